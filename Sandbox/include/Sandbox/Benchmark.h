@@ -0,0 +1,27 @@
+//
+// Created by ZHIKANG on 2023/4/10.
+//
+
+#pragma once
+
+#include <VulkanToy.h>
+
+namespace VT
+{
+    // Micro benchmarks of engine hot paths, run by "Sandbox --benchmark" without window and device
+    class Benchmark final
+    {
+    public:
+        static void run();
+
+    private:
+        // N threads look up GPU asset cache while one thread keeps inserting
+        static void runAssetCacheLookup();
+
+        // Import bundled meshes and compare cache statistics before and after mesh optimizer, CPU only
+        static void runMeshOptimize();
+
+        // Scalar, SIMD and parallel frustum culling over 10k to 1M random bounds
+        static void runFrustumCulling();
+    };
+}
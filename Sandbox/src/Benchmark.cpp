@@ -0,0 +1,205 @@
+//
+// Created by ZHIKANG on 2023/4/10.
+//
+
+#include <Sandbox/Benchmark.h>
+#include <VulkanToy/AssetSystem/GPUCache.h>
+#include <VulkanToy/AssetSystem/MeshManager.h>
+#include <VulkanToy/AssetSystem/MeshOptimizer.h>
+#include <VulkanToy/Renderer/FrustumCuller.h>
+
+namespace VT
+{
+    namespace
+    {
+        // CPU only asset, no GPU resource behind
+        class BenchmarkAsset final : public GPUAssetInterface
+        {
+        public:
+            explicit BenchmarkAsset(bool isPersistent) : GPUAssetInterface(isPersistent) {}
+
+            size_t getSize() const override { return 1024; }
+
+            void release() override {}
+        };
+    }
+
+    void Benchmark::run()
+    {
+        runAssetCacheLookup();
+        runMeshOptimize();
+        runFrustumCulling();
+    }
+
+    void Benchmark::runAssetCacheLookup()
+    {
+        constexpr uint32_t assetCount = 4096;
+        constexpr auto duration = std::chrono::seconds(2);
+        const uint32_t readerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+        // Budget large enough to keep all assets resident, measure lookup only
+        GPUAssetCache<BenchmarkAsset> cache{ 256, 64 };
+        std::vector<UUID> keys(assetCount);
+        for (uint32_t index = 0; index < assetCount; ++index)
+        {
+            keys[index] = buildUUID();
+            cache.insert(keys[index], CreateRef<BenchmarkAsset>(index % 2 == 0));
+        }
+
+        std::atomic<bool> isRunning{ true };
+        std::atomic<uint64_t> lookupCount{ 0 };
+        std::atomic<uint64_t> insertCount{ 0 };
+
+        std::vector<std::thread> readers;
+        for (uint32_t threadIndex = 0; threadIndex < readerCount; ++threadIndex)
+        {
+            readers.emplace_back([&, threadIndex]()
+            {
+                uint64_t localCount = 0;
+                uint32_t keyIndex = threadIndex * 7919;
+                while (isRunning.load(std::memory_order_relaxed))
+                {
+                    for (uint32_t batch = 0; batch < 256; ++batch)
+                    {
+                        keyIndex = (keyIndex + 101) % assetCount;
+                        if (cache.tryGet(keys[keyIndex]) == nullptr)
+                        {
+                            VT_ERROR("Asset cache benchmark lookup miss");
+                        }
+                    }
+                    localCount += 256;
+                }
+                lookupCount += localCount;
+            });
+        }
+
+        // Loader side, insert fresh transient assets and tick like frames to keep pruning going
+        std::thread writer([&]()
+        {
+            uint64_t localCount = 0;
+            while (isRunning.load(std::memory_order_relaxed))
+            {
+                cache.insert(buildUUID(), CreateRef<BenchmarkAsset>(false));
+                if (++localCount % 1024 == 0)
+                {
+                    cache.tick();
+                }
+            }
+            insertCount += localCount;
+        });
+
+        std::this_thread::sleep_for(duration);
+        isRunning.store(false);
+        for (auto& reader : readers)
+        {
+            reader.join();
+        }
+        writer.join();
+
+        const double seconds = std::chrono::duration<double>(duration).count();
+        const auto stats = cache.getStats();
+        VT_INFO("Asset cache lookup: {0} readers, {1:.2f} M lookups/s, {2:.2f} M lookups/s per reader, {3:.2f} K inserts/s",
+                readerCount, lookupCount.load() / seconds / 1e6, lookupCount.load() / seconds / 1e6 / readerCount,
+                insertCount.load() / seconds / 1e3);
+        VT_INFO("Asset cache stats: hits {0}, misses {1}, evictions {2}, resident {3} KB",
+                stats.hits, stats.misses, stats.evictions, stats.getResidentBytes() / 1024);
+    }
+
+    void Benchmark::runMeshOptimize()
+    {
+        // Import already runs the optimizer and logs its statistics, shuffle triangles to get unoptimized baseline
+        const std::vector<std::string> meshPaths = { "../data/meshes/Box.obj", "../data/meshes/Sphere.obj",
+                                                    "../data/meshes/Skybox.obj", "../data/meshes/cerberus.fbx" };
+        std::mt19937 generator{ 1234 };
+        for (const auto& meshPath : meshPaths)
+        {
+            auto meshBin = StaticMeshAssetBin::importFromModel(meshPath, meshPath);
+            if (meshBin == nullptr)
+            {
+                VT_ERROR("Mesh optimize benchmark fail to import '{0}'", meshPath);
+                continue;
+            }
+
+            auto vertices = meshBin->getVertices();
+            auto indices = meshBin->getIndices();
+            const size_t lodIndexCount = meshBin->getLods().front().indexCount;
+            const auto optimized = MeshOptimizer::analyzeVertexCache(indices.data(), lodIndexCount);
+
+            // Shuffle whole triangles inside each LOD 0 sub-mesh
+            for (const auto& subMesh : meshBin->getSubMeshes())
+            {
+                const uint32_t triangleCount = subMesh.indexCount / 3;
+                for (uint32_t triangle = triangleCount; triangle > 1; --triangle)
+                {
+                    const uint32_t other = std::uniform_int_distribution<uint32_t>{ 0, triangle - 1 }(generator);
+                    std::swap_ranges(indices.begin() + subMesh.indexStartPosition + 3 * (triangle - 1),
+                                    indices.begin() + subMesh.indexStartPosition + 3 * triangle,
+                                    indices.begin() + subMesh.indexStartPosition + 3 * other);
+                }
+            }
+            const auto shuffled = MeshOptimizer::analyzeVertexCache(indices.data(), lodIndexCount);
+
+            const auto start = std::chrono::steady_clock::now();
+            MeshOptimizer::optimize(meshPath, vertices, indices, meshBin->getSubMeshes(), meshBin->getLods());
+            const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            VT_INFO("Mesh optimize '{0}': {1} triangles, shuffled ACMR {2:.3f} ATVR {3:.3f}, optimized ACMR {4:.3f} ATVR {5:.3f}, {6:.2f} ms",
+                    meshPath, optimized.triangleCount, shuffled.acmr, shuffled.atvr, optimized.acmr, optimized.atvr, milliseconds);
+        }
+    }
+
+    void Benchmark::runFrustumCulling()
+    {
+        // Camera at origin looking down -z, bounds scattered all around it
+        Frustum frustum{};
+        frustum.Update(glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f) *
+                        glm::lookAt(glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 0.0f, -1.0f }, glm::vec3{ 0.0f, 1.0f, 0.0f }));
+
+        std::mt19937 generator{ 5678 };
+        std::uniform_real_distribution<float> positionDistribution{ -500.0f, 500.0f };
+        std::uniform_real_distribution<float> extentDistribution{ 0.5f, 5.0f };
+        for (uint32_t boundCount : { 10000u, 100000u, 1000000u })
+        {
+            CullingBoundsTable bounds{};
+            bounds.resize(boundCount);
+            for (uint32_t index = 0; index < boundCount; ++index)
+            {
+                const glm::vec3 center{ positionDistribution(generator), positionDistribution(generator), positionDistribution(generator) };
+                const glm::vec3 extent{ extentDistribution(generator), extentDistribution(generator), extentDistribution(generator) };
+                bounds.set(index, center, extent, glm::length(extent));
+            }
+
+            // Best of several runs, nanoseconds per bound
+            auto measure = [boundCount](const std::function<uint32_t()> &function, uint32_t &outVisibleCount)
+            {
+                double best = std::numeric_limits<double>::max();
+                for (uint32_t run = 0; run < 10; ++run)
+                {
+                    const auto start = std::chrono::steady_clock::now();
+                    outVisibleCount = function();
+                    best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+                }
+                return best / boundCount;
+            };
+
+            std::vector<uint32_t> visible(boundCount + GCullingBatchSize);
+            uint32_t scalarCount = 0;
+            uint32_t simdCount = 0;
+            uint32_t parallelCount = 0;
+            const double scalarTime = measure([&]() { return FrustumCuller::cullScalar(frustum, bounds, 0, boundCount, visible.data()); }, scalarCount);
+            const double simdTime = measure([&]() { return FrustumCuller::cull(frustum, bounds, 0, boundCount, visible.data()); }, simdCount);
+            const double parallelTime = measure([&]()
+            {
+                FrustumCuller::cullAll(frustum, bounds, visible);
+                return static_cast<uint32_t>(visible.size());
+            }, parallelCount);
+
+            if (scalarCount != simdCount || scalarCount != parallelCount)
+            {
+                VT_ERROR("Frustum culling mismatch: scalar {0}, SIMD {1}, parallel {2}", scalarCount, simdCount, parallelCount);
+            }
+            VT_INFO("Frustum culling {0} bounds, {1} visible: scalar {2:.2f} ns, SIMD {3:.2f} ns, parallel {4:.2f} ns per bound",
+                    boundCount, simdCount, scalarTime, simdTime, parallelTime);
+        }
+    }
+}
@@ -3,9 +3,46 @@
 //
 
 #include <Sandbox/Sandbox.h>
+#include <Sandbox/Benchmark.h>
+#include <VulkanToy/AssetSystem/MeshManager.h>
+#include <VulkanToy/Core/JobSystem.h>
 
-int main()
+int main(int argc, char **argv)
 {
+    if (argc > 1 && std::string_view(argv[1]) == "--benchmark")
+    {
+        VT::Benchmark::run();
+        return 0;
+    }
+
+    // Offline cook step: Sandbox --cook [--compact] model1 model2 ...
+    if (argc > 1 && std::string_view(argv[1]) == "--cook")
+    {
+        // Sub-meshes of one model are processed as jobs
+        VT::JobSystemHandle::Get()->init();
+
+        int result = 0;
+        auto vertexFormat = VT::VertexFormat::Standard;
+        for (int index = 2; index < argc; ++index)
+        {
+            if (std::string_view(argv[index]) == "--compact")
+            {
+                vertexFormat = VT::VertexFormat::Compact;
+                continue;
+            }
+
+            const std::filesystem::path modelPath{ argv[index] };
+            if (!VT::StaticMeshAssetBin::cook(modelPath, VT::StaticMeshAssetBin::getCookedPath(modelPath, vertexFormat), vertexFormat))
+            {
+                VT_ERROR("Fail to cook mesh '{0}'", modelPath.string());
+                result = 1;
+            }
+        }
+        VT::JobSystemHandle::Get()->release();
+        return result;
+    }
+
+    VT::GEngine->setSettings(VT::EngineSettings::fromCommandLine(argc, argv));
     VT::GEditor->run();
     VT::GEditor->release();
-}
\ No newline at end of file
+}
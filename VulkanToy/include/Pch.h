@@ -14,10 +14,12 @@
 #include <queue>
 #include <list>
 #include <vector>
+#include <array>
 #include <string>
 #include <string_view>
 #include <stack>
 #include <variant>
+#include <optional>
 #include <utility>
 #include <type_traits>
 #include <thread>
@@ -30,6 +32,10 @@
 #include <map>
 #include <set>
 #include <shared_mutex>
+#include <random>
+#include <limits>
+#include <numeric>
+#include <tuple>
 
 // glm math.
 // 0 - glm force compute on radians.
@@ -40,6 +40,8 @@ namespace VT
         UUID m_uuid;
         bool m_isPersistent;
         std::atomic<bool> m_isAsyncLoading{ true };
+        // Set by users every frame they use the asset, cleared by cache tick
+        std::atomic<bool> m_isUsed{ false };
 
     public:
         explicit GPUAssetInterface(bool isPersistent)
@@ -60,6 +62,14 @@ namespace VT
 
         void setAsyncLoadState(bool state) { m_isAsyncLoading.store(state); }
 
+        // Holders of the asset never look it up again, marking keeps it recently used in cache
+        void markUsed() { m_isUsed.store(true, std::memory_order_relaxed); }
+
+        bool consumeUsed() { return m_isUsed.exchange(false, std::memory_order_relaxed); }
+
         virtual size_t getSize() const = 0;
+
+        // Free GPU resources, cache calls it for persistent assets on clear
+        virtual void release() = 0;
     };
 }
@@ -14,7 +14,10 @@ namespace VT
     protected:
         std::filesystem::path m_projectAssetBinFolderPath;
 
+        std::mutex m_uploadTaskMutex;
         std::vector<Ref<AssetLoadTask>> m_uploadTasks;
+
+        AsyncUploaderManager m_uploaderManager{};
     public:
         [[nodiscard]] const auto& getProjectBinFolderPath() const
         {
@@ -26,13 +29,17 @@ namespace VT
         ~AssetSystem() = default;
 
         void addUploadTask(Ref<AssetLoadTask> inTask);
+        // Submit all tasks and block until uploaded
         void flushUploadTask();
         void init() override;
         void release() override;
         virtual void tick(const RuntimeModuleTickData &tickData) override;
 
+        [[nodiscard]] bool isUploadBusy() const { return m_uploaderManager.isBusy(); }
+
     private:
         void engineAssetInit();
+        void submitUploadTasks();
     };
 
     using AssetSystemHandle = Singleton<AssetSystem>;
@@ -24,11 +24,20 @@ namespace VT
 
         explicit AssimpModelProcess(const std::filesystem::path &inPath);
 
-//        void processNode(aiNode *node, const aiScene *scene);                 // Old method
+        // Process all meshes in node hierarchy, each sub-mesh processed by one worker in parallel
+        // Vertices and indices are concatenated, indices already offset by the sub-mesh base vertex
+        void processScene(const aiScene *scene);
 
-//        StaticMeshSubMesh processMesh(aiMesh *mesh, const aiScene *scene);    // Old method
+        void processNode(const aiNode *node, const aiScene *scene, std::vector<const aiMesh *> &outMeshes);
 
-        void processMesh(aiMesh *mesh, const aiScene *scene);                   // New method
+        void processMesh(aiMesh *mesh, const aiScene *scene);
+
+    private:
+        // Fill pre-allocated vertex and index range of one sub-mesh, thread safe between different sub-meshes
+        static void processMeshRange(const aiMesh *mesh, const aiScene *scene,
+                                    uint32_t vertexStart, uint32_t indexStart,
+                                    StaticMeshVertex *outVertices, VertexIndexType *outIndices,
+                                    StaticMeshSubMesh &outSubMesh);
     };
 }
 
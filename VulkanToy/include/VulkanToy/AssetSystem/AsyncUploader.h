@@ -15,18 +15,179 @@ namespace VT
     constexpr size_t GStaticUploaderMaxSize = 64 * 1024 * 1024;     // 64 MB
     constexpr size_t GDynamicUploaderMinSize = 32 * 1024 * 1024;    // 32 MB
 
+    // Stage buffer offset alignment, covers texel block size and copy queue 4 bytes requirement
+    constexpr VkDeviceSize GUploaderOffsetAlignment = 16;
+    // Static uploader batches in flight, wait the oldest one when exceed
+    constexpr uint32_t GStaticUploaderMaxInFlight = 4;
+
     struct AssetLoadTask
     {
+        virtual ~AssetLoadTask() = default;
+
         // When load task finish call
         virtual void finishCallback() = 0;
 
         // Load task need stage buffer size
         virtual uint32_t getUploadSize() const = 0;
 
-        // Upload main body function
+        // Upload main body function, mapped already points to stageBufferOffset, record on copy queue
         virtual void uploadDevice(uint32_t stageBufferOffset,
                         void *mapped,
                         CommandBufferBase &commandBuffer,
                         VulkanBuffer &stageBuffer) = 0;
+
+        // Acquire uploaded resources released by copy queue, record on major graphics queue
+        virtual void acquireOwnership(CommandBufferBase &commandBuffer) = 0;
+    };
+
+    class AsyncUploaderManager;
+
+    // Uploader worker, own one copy queue and its command pool exclusively
+    class AsyncUploaderBase : private DisableCopy
+    {
+    protected:
+        std::string m_name;
+        AsyncUploaderManager &m_manager;
+
+        VkQueue m_queue = VK_NULL_HANDLE;
+        VkCommandPool m_commandPool = VK_NULL_HANDLE;
+        uint32_t m_queueFamily = ~0;
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::queue<Ref<AssetLoadTask>> m_pendingTasks;
+        bool m_isShutdown = false;
+
+    public:
+        AsyncUploaderBase(const std::string &name, AsyncUploaderManager &manager, VkQueue queue, VkCommandPool commandPool);
+        virtual ~AsyncUploaderBase() = default;
+
+        void start();
+        void stop();
+
+        void addTask(Ref<AssetLoadTask> inTask);
+
+    protected:
+        // Worker thread main body
+        virtual void loop() = 0;
+
+        // Move all pending tasks to worker, return false when shutdown
+        // Polling mode only wait a moment, so worker can check in flight fences
+        bool waitTasks(std::queue<Ref<AssetLoadTask>> &outTasks, bool isPolling);
+
+        CommandBufferBase allocateCommandBuffer();
+        void freeCommandBuffer(CommandBufferBase &commandBuffer);
+
+        void beginCommandBuffer(CommandBufferBase &commandBuffer);
+        void submitCommandBuffer(CommandBufferBase &commandBuffer, VkFence fence);
+    };
+
+    // Pack small tasks into a persistent ring stage buffer, several batches in flight
+    class StaticAsyncUploader final : public AsyncUploaderBase
+    {
+    private:
+        struct UploadBatch
+        {
+            CommandBufferBase commandBuffer{};
+            VkFence fence = VK_NULL_HANDLE;
+            // Ring head after this batch and bytes consumed (include wrap tail)
+            VkDeviceSize ringEnd = 0;
+            VkDeviceSize ringSize = 0;
+            std::vector<Ref<AssetLoadTask>> tasks;
+        };
+
+        Ref<VulkanBuffer> m_stageBuffer = nullptr;
+        VkDeviceSize m_ringHead = 0;
+        VkDeviceSize m_ringTail = 0;
+        VkDeviceSize m_ringUsed = 0;
+
+        std::array<UploadBatch, GStaticUploaderMaxInFlight> m_batches{};
+        std::vector<uint32_t> m_freeBatches;
+        std::queue<uint32_t> m_inFlightBatches;
+        // Batch recording, ~0 when none
+        uint32_t m_recordingBatch = ~0;
+
+    public:
+        StaticAsyncUploader(AsyncUploaderManager &manager, VkQueue queue, VkCommandPool commandPool);
+        ~StaticAsyncUploader() override = default;
+
+    protected:
+        void loop() override;
+
+    private:
+        void init();
+        void release();
+
+        bool tryAllocate(VkDeviceSize size, VkDeviceSize &outOffset);
+        void beginBatch();
+        void submitBatch();
+        // Return false if oldest batch still running and no wait
+        bool retireOldestBatch(bool isWait);
+    };
+
+    // Upload one large task each time, stage buffer grow on demand and release when idle
+    class DynamicAsyncUploader final : public AsyncUploaderBase
+    {
+    private:
+        Ref<VulkanBuffer> m_stageBuffer = nullptr;
+        CommandBufferBase m_commandBuffer{};
+        VkFence m_fence = VK_NULL_HANDLE;
+
+    public:
+        DynamicAsyncUploader(AsyncUploaderManager &manager, VkQueue queue, VkCommandPool commandPool);
+        ~DynamicAsyncUploader() override = default;
+
+    protected:
+        void loop() override;
+
+    private:
+        void releaseStageBuffer();
+    };
+
+    // Dispatch tasks to uploaders, acquire finished tasks on major graphics queue
+    class AsyncUploaderManager : private DisableCopy
+    {
+    private:
+        struct AcquireSubmission
+        {
+            VkCommandBuffer cmd = VK_NULL_HANDLE;
+            // Frame timeline value signaled when acquire finish
+            uint64_t timelineValue = 0;
+        };
+
+        Scope<StaticAsyncUploader> m_staticUploader = nullptr;
+        Scope<DynamicAsyncUploader> m_dynamicUploader = nullptr;
+
+        std::mutex m_finishMutex;
+        std::condition_variable m_finishCondition;
+        std::vector<Ref<AssetLoadTask>> m_finishedTasks;
+
+        // Tasks added but not call finish callback yet
+        std::atomic<uint32_t> m_workingTaskCount{ 0 };
+
+        std::vector<AcquireSubmission> m_acquireSubmissions;
+
+    public:
+        AsyncUploaderManager() = default;
+
+        void init();
+        void release();
+
+        void addTask(Ref<AssetLoadTask> inTask);
+
+        // Call by uploader thread when copy queue finish
+        void onTasksFinished(std::vector<Ref<AssetLoadTask>> &tasks);
+
+        // Acquire finished tasks and call finish callback, run on render thread
+        void tick();
+
+        // Block until all added tasks finish
+        void flush();
+
+        [[nodiscard]] bool isBusy() const { return m_workingTaskCount.load() > 0; }
+
+    private:
+        void recycleAcquireSubmissions(bool isWait);
     };
 }
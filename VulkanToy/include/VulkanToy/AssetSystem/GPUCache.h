@@ -9,18 +9,65 @@
 
 namespace VT
 {
+    // Frames a transient asset must stay unused before eviction, cover frames in flight
+    constexpr uint64_t GAssetCacheFrameLatency = 3;
+    // Shard count of cache maps, lookups only contend inside one shard
+    constexpr size_t GAssetCacheShardCount = 16;
+
+    struct GPUAssetCacheStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t revivals = 0;
+
+        size_t persistentBytes = 0;
+        size_t transientBytes = 0;
+
+        [[nodiscard]] size_t getResidentBytes() const { return persistentBytes + transientBytes; }
+    };
+
     template <typename ValueType = GPUAssetInterface, typename KeyType = UUID>
     class GPUAssetCache
     {
     protected:
         static_assert(std::is_base_of_v<GPUAssetInterface, ValueType>, "Value type muse be derived from GPUAssetInterface");
+        static_assert((GAssetCacheShardCount & (GAssetCacheShardCount - 1)) == 0, "Shard count must be power of two");
+
+        struct TransientEntry
+        {
+            Ref<ValueType> value;
+            // Stamped by readers and by tick for assets marked used, LRU order is resolved when pruning
+            std::atomic<uint64_t> lastUsedFrame;
+
+            TransientEntry(Ref<ValueType> inValue, uint64_t frame)
+                : value(std::move(inValue)), lastUsedFrame(frame) {}
+        };
+
+        // Readers take shared lock, only insert, revive and evict take exclusive lock
+        struct alignas(64) Shard
+        {
+            std::shared_mutex mutex;
+
+            // Cache persistent resource
+            std::unordered_map<KeyType, Ref<ValueType>> persistentMap;
+            // Cache transient resource
+            std::unordered_map<KeyType, TransientEntry> transientMap;
+            // Evicted resource still referenced outside, revive when requested or marked used again
+            std::unordered_map<KeyType, std::weak_ptr<ValueType>> weakReferencesMap;
+
+            // Statistic counters, per shard to avoid one hot cache line
+            std::atomic<uint64_t> hitCount{ 0 };
+            std::atomic<uint64_t> missCount{ 0 };
+        };
+
+        std::array<Shard, GAssetCacheShardCount> m_shards;
 
-        // Cache persistent resource
         std::atomic<size_t> m_persistentAssetSize{ 0 };
-        std::unordered_map<KeyType, Ref<ValueType>> m_cachePersistentMap;
+        std::atomic<size_t> m_lruAssetSize{ 0 };
 
-        // Mutex for map edit
-        std::mutex m_mutex;
+        // Serialize pruning, readers never touch it
+        std::mutex m_pruneMutex;
 
         // GPU cache desired capacity
         size_t m_capacity;
@@ -28,6 +75,12 @@ namespace VT
         // Elastic space to enable GPU cache no always prune
         size_t m_elasticity;
 
+        // Frame counter for last used frame
+        std::atomic<uint64_t> m_frameIndex{ 0 };
+
+        std::atomic<uint64_t> m_evictionCount{ 0 };
+        std::atomic<uint64_t> m_revivalCount{ 0 };
+
     public:
         explicit GPUAssetCache(size_t capacity, size_t elasticity)
             : m_capacity(capacity * 1024 * 1024), m_elasticity(elasticity * 1024 * 1024)
@@ -45,68 +98,253 @@ namespace VT
 
         size_t getPersistentAssetSize() const { return m_persistentAssetSize.load(); }
 
+        size_t getTransientAssetSize() const { return m_lruAssetSize.load(); }
+
+        size_t getResidentSize() const { return getPersistentAssetSize() + getTransientAssetSize(); }
+
+        GPUAssetCacheStats getStats() const
+        {
+            GPUAssetCacheStats stats{};
+            for (const auto& shard : m_shards)
+            {
+                stats.hits += shard.hitCount.load(std::memory_order_relaxed);
+                stats.misses += shard.missCount.load(std::memory_order_relaxed);
+            }
+            stats.evictions = m_evictionCount.load();
+            stats.revivals = m_revivalCount.load();
+            stats.persistentBytes = getPersistentAssetSize();
+            stats.transientBytes = getTransientAssetSize();
+            return stats;
+        }
+
         bool contain(const KeyType &key)
         {
-            // Need lock when search from weak ptr map
-            std::lock_guard<std::mutex> guard(m_mutex);
+            auto& shard = getShard(key);
+            std::shared_lock<std::shared_mutex> guard(shard.mutex);
 
-            if (m_cachePersistentMap.contains(key))
+            if (shard.persistentMap.contains(key) || shard.transientMap.contains(key))
             {
                 return true;
             }
 
-            return false;
+            auto it = shard.weakReferencesMap.find(key);
+            return it != shard.weakReferencesMap.end() && !it->second.expired();
         }
 
         void insert(const KeyType &key, Ref<ValueType> value)
         {
-            std::lock_guard<std::mutex> guard(m_mutex);
-
-            // Persistent asset
-            // TODO: check persistent
-            auto it = m_cachePersistentMap.try_emplace(key, value);
-            if (it.second)
+            auto& shard = getShard(key);
             {
-                m_persistentAssetSize += value->getSize();
-            } else
+                std::unique_lock<std::shared_mutex> guard(shard.mutex);
+
+                if (value->isPersistent())
+                {
+                    auto it = shard.persistentMap.try_emplace(key, value);
+                    if (it.second)
+                    {
+                        m_persistentAssetSize += value->getSize();
+                    } else
+                    {
+                        VT_CORE_ERROR("Try insert persistent asset that already exists");
+                    }
+                    return;
+                }
+
+                if (shard.transientMap.contains(key))
+                {
+                    VT_CORE_ERROR("Try insert transient asset that already exists");
+                    return;
+                }
+
+                shard.weakReferencesMap.erase(key);
+                m_lruAssetSize += value->getSize();
+                shard.transientMap.try_emplace(key, std::move(value), m_frameIndex.load(std::memory_order_relaxed));
+            }
+
+            if (getResidentSize() > getMaxAllowedSize())
             {
-                VT_CORE_ERROR("Try insert persistent asset that already exists");
+                prune();
             }
         }
 
         Ref<ValueType> tryGet(const KeyType &inKey)
         {
-            std::lock_guard<std::mutex> guard(m_mutex);
+            auto& shard = getShard(inKey);
+            bool isRevivable = false;
+            {
+                std::shared_lock<std::shared_mutex> guard(shard.mutex);
+
+                if (auto it = shard.persistentMap.find(inKey); it != shard.persistentMap.end())
+                {
+                    shard.hitCount.fetch_add(1, std::memory_order_relaxed);
+                    return it->second;
+                }
+
+                if (auto it = shard.transientMap.find(inKey); it != shard.transientMap.end())
+                {
+                    it->second.lastUsedFrame.store(m_frameIndex.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    shard.hitCount.fetch_add(1, std::memory_order_relaxed);
+                    return it->second.value;
+                }
+
+                if (auto it = shard.weakReferencesMap.find(inKey); it != shard.weakReferencesMap.end())
+                {
+                    isRevivable = !it->second.expired();
+                }
+            }
 
-            if (m_cachePersistentMap.contains(inKey))
+            if (isRevivable)
             {
-                return m_cachePersistentMap[inKey];
+                // Rare path, evicted but still alive, revive into cache without reload
+                std::unique_lock<std::shared_mutex> guard(shard.mutex);
+                if (auto it = shard.transientMap.find(inKey); it != shard.transientMap.end())
+                {
+                    shard.hitCount.fetch_add(1, std::memory_order_relaxed);
+                    return it->second.value;
+                }
+                if (auto it = shard.weakReferencesMap.find(inKey); it != shard.weakReferencesMap.end())
+                {
+                    auto value = it->second.lock();
+                    shard.weakReferencesMap.erase(it);
+                    if (value != nullptr)
+                    {
+                        m_lruAssetSize += value->getSize();
+                        shard.transientMap.try_emplace(inKey, value, m_frameIndex.load(std::memory_order_relaxed));
+                        shard.hitCount.fetch_add(1, std::memory_order_relaxed);
+                        m_revivalCount++;
+                        return value;
+                    }
+                }
             }
 
+            shard.missCount.fetch_add(1, std::memory_order_relaxed);
             return nullptr;
         }
 
-        void clear()
+        // Stamp assets marked used, advance frame and evict transient asset if over budget, call once per frame
+        void tick()
         {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            // TODO: remove
-            for (auto& singleCache : m_cachePersistentMap)
+            const uint64_t frameIndex = m_frameIndex.load();
+            for (auto& shard : m_shards)
             {
-                singleCache.second->release();
+                {
+                    std::shared_lock<std::shared_mutex> guard(shard.mutex);
+                    for (auto& [key, entry] : shard.transientMap)
+                    {
+                        if (entry.value->consumeUsed())
+                        {
+                            entry.lastUsedFrame.store(frameIndex, std::memory_order_relaxed);
+                        }
+                    }
+                }
+
+                // Evicted assets still in use come back as resident, dead weak references are dropped
+                std::unique_lock<std::shared_mutex> guard(shard.mutex);
+                for (auto it = shard.weakReferencesMap.begin(); it != shard.weakReferencesMap.end();)
+                {
+                    auto value = it->second.lock();
+                    if (value != nullptr && value->consumeUsed())
+                    {
+                        m_lruAssetSize += value->getSize();
+                        shard.transientMap.try_emplace(it->first, std::move(value), frameIndex);
+                        m_revivalCount++;
+                    } else if (value != nullptr)
+                    {
+                        ++it;
+                        continue;
+                    }
+                    it = shard.weakReferencesMap.erase(it);
+                }
             }
 
-            m_cachePersistentMap.clear();
+            m_frameIndex.fetch_add(1);
+            prune();
         }
-    };
-}
-
-
-
-
-
 
+        void clear()
+        {
+            for (auto& shard : m_shards)
+            {
+                std::unique_lock<std::shared_mutex> guard(shard.mutex);
+                // TODO: remove
+                for (auto& singleCache : shard.persistentMap)
+                {
+                    singleCache.second->release();
+                }
+                shard.persistentMap.clear();
+
+                // Transient asset release itself when the last reference drops
+                shard.transientMap.clear();
+                shard.weakReferencesMap.clear();
+            }
 
+            m_persistentAssetSize.store(0);
+            m_lruAssetSize.store(0);
+        }
 
+    protected:
+        Shard& getShard(const KeyType &key)
+        {
+            return m_shards[std::hash<KeyType>{}(key) & (GAssetCacheShardCount - 1)];
+        }
 
+        // Evict least recently used transient assets down to capacity once over capacity + elasticity
+        void prune()
+        {
+            std::lock_guard<std::mutex> pruneGuard(m_pruneMutex);
+            if (getResidentSize() <= getMaxAllowedSize())
+            {
+                return;
+            }
 
+            // Collect candidates not used by frames in flight
+            struct Candidate
+            {
+                KeyType key;
+                uint64_t lastUsedFrame;
+                Shard *shard;
+            };
+            std::vector<Candidate> candidates;
+            const uint64_t frameIndex = m_frameIndex.load();
+            for (auto& shard : m_shards)
+            {
+                std::shared_lock<std::shared_mutex> guard(shard.mutex);
+                for (const auto& [key, entry] : shard.transientMap)
+                {
+                    const uint64_t lastUsedFrame = entry.lastUsedFrame.load(std::memory_order_relaxed);
+                    if (lastUsedFrame + GAssetCacheFrameLatency <= frameIndex)
+                    {
+                        candidates.push_back({ key, lastUsedFrame, &shard });
+                    }
+                }
+            }
+            std::sort(candidates.begin(), candidates.end(),
+                        [](const Candidate &a, const Candidate &b) { return a.lastUsedFrame < b.lastUsedFrame; });
 
+            for (const auto& candidate : candidates)
+            {
+                if (getResidentSize() <= m_capacity)
+                {
+                    break;
+                }
+
+                std::unique_lock<std::shared_mutex> guard(candidate.shard->mutex);
+                auto it = candidate.shard->transientMap.find(candidate.key);
+                // Used again after collecting
+                if (it == candidate.shard->transientMap.end() ||
+                    it->second.lastUsedFrame.load(std::memory_order_relaxed) != candidate.lastUsedFrame)
+                {
+                    continue;
+                }
+
+                m_lruAssetSize -= it->second.value->getSize();
+                if (it->second.value.use_count() > 1)
+                {
+                    candidate.shard->weakReferencesMap[candidate.key] = it->second.value;
+                }
+                candidate.shard->transientMap.erase(it);
+                m_evictionCount++;
+            }
+        }
+    };
+}
@@ -48,6 +48,9 @@ namespace VT
         Ref<VulkanImage> metallicTexture = nullptr;
         Ref<VulkanImage> roughnessTexture = nullptr;
 
+        // Slot in bindless material buffer, registered by owner once textures are uploaded
+        uint32_t bindlessIndex = std::numeric_limits<uint32_t>::max();
+
         inline static Ref<VulkanImage> irradianceTexture = nullptr;
         inline static Ref<VulkanImage> BRDFLUT = nullptr;
         inline static Ref<VulkanImage> prefilteredMapTexture = nullptr;
@@ -7,6 +7,7 @@
 #include <VulkanToy/AssetSystem/MeshMisc.h>
 #include <VulkanToy/AssetSystem/GPUCache.h>
 #include <VulkanToy/AssetSystem/AsyncUploader.h>
+#include <VulkanToy/Core/MappedFile.h>
 
 namespace VT
 {
@@ -32,11 +33,19 @@ namespace VT
     private:
         std::vector<StaticMeshVertex> m_vertices;
         std::vector<VertexIndexType> m_indices{};
+        std::vector<StaticMeshSubMesh> m_subMeshes{};
+        StaticMeshRenderBound m_renderBound{};
+        std::vector<StaticMeshLod> m_lods{};
 
     public:
         StaticMeshAssetBin() = default;
         StaticMeshAssetBin(const std::string &name)
             : AssetBinInterface(buildUUID(), name) {}
+        StaticMeshAssetBin(const std::string &name,
+                        std::vector<StaticMeshVertex> vertices,
+                        std::vector<VertexIndexType> indices,
+                        std::vector<StaticMeshSubMesh> subMeshes,
+                        std::vector<StaticMeshLod> lods = {});
 
         AssetType getAssetType() const override
         {
@@ -52,6 +61,38 @@ namespace VT
         {
             return m_vertices;
         }
+
+        const std::vector<StaticMeshSubMesh>& getSubMeshes() const
+        {
+            return m_subMeshes;
+        }
+
+        const StaticMeshRenderBound& getRenderBound() const
+        {
+            return m_renderBound;
+        }
+
+        const std::vector<StaticMeshLod>& getLods() const
+        {
+            return m_lods;
+        }
+
+        // Import all sub-meshes of model file, return nullptr when failed
+        static Ref<StaticMeshAssetBin> importFromModel(const std::string &name, const std::filesystem::path &path);
+
+        // Quantize vertices into compact layout, output quantization box
+        std::vector<StaticMeshCompactVertex> getCompactVertices(glm::vec3 &outPositionOffset, glm::vec3 &outPositionScale) const;
+
+        // Write cooked mesh container with vertices in the requested layout
+        bool saveCooked(const std::filesystem::path &path, VertexFormat vertexFormat = VertexFormat::Standard) const;
+
+        // Offline cook step, model file to cooked mesh container
+        static bool cook(const std::filesystem::path &modelPath, const std::filesystem::path &cookedPath,
+                        VertexFormat vertexFormat = VertexFormat::Standard);
+
+        // Cooked file sits next to model file, such as Box.obj.vtmesh or Box.obj.compact.vtmesh
+        static std::filesystem::path getCookedPath(const std::filesystem::path &modelPath,
+                                                VertexFormat vertexFormat = VertexFormat::Standard);
     };
 
     class GPUMeshAsset final : public GPUAssetInterface
@@ -71,6 +112,21 @@ namespace VT
         uint32_t m_vertexCount = 0;
         uint32_t m_vertexFloat32Count = 0;
 
+        // Index ranges into shared buffers, whole mesh as one sub-mesh when built from raw data
+        std::vector<StaticMeshSubMesh> m_subMeshes{};
+        StaticMeshRenderBound m_renderBound{};
+        // LOD 0 first, whole index buffer as one LOD when built from raw data
+        std::vector<StaticMeshLod> m_lods{};
+
+        // Vertex layout and quantization box of compact vertex
+        VertexFormat m_vertexFormat = VertexFormat::Standard;
+        glm::vec3 m_positionOffset{ 0.0f };
+        glm::vec3 m_positionScale{ 1.0f };
+
+        // Slots in bindless storage buffer array, taken when upload finish
+        uint32_t m_vertexBindlessIndex = std::numeric_limits<uint32_t>::max();
+        uint32_t m_indexBindlessIndex = std::numeric_limits<uint32_t>::max();
+
     public:
         // Immediately build GPU mesh asset
         GPUMeshAsset(const std::string &name, bool isPersistent,
@@ -81,16 +137,24 @@ namespace VT
 
         ~GPUMeshAsset() override;
 
-        void release();
+        void release() override;
 
         size_t getSize() const override
         {
             return m_vertexBuffer->getMemorySize() + m_indexBuffer->getMemorySize();
         }
 
-        void prepareToUpload();
+        // Prepare buffers when start to upload on copy queue
+        void prepareToUpload(CommandBufferBase &cmd);
+
+        // Release buffers from copy queue when upload finish
+        void finishUpload(CommandBufferBase &cmd);
 
-        void finishUpload();
+        // Acquire buffers on graphics queue for vertex input
+        void acquireOwnership(CommandBufferBase &cmd);
+
+        // Register vertex and index buffers into bindless heap for shader fetch
+        void registerBindless();
 
         auto& getVertexBuffer() { return m_vertexBuffer->getBuffer(); }
 
@@ -102,7 +166,39 @@ namespace VT
 
         const uint32_t& getIndicesCount() const { return m_indexCount; }
 
+        VkIndexType getIndexType() const { return m_indexType; }
+
         const uint32_t& getVerticesCount() const { return m_vertexCount; }
+
+        // Set sub-mesh ranges before the asset is published, render bound is merged from them
+        void setSubMeshes(std::vector<StaticMeshSubMesh> subMeshes);
+
+        const std::vector<StaticMeshSubMesh>& getSubMeshes() const { return m_subMeshes; }
+
+        const StaticMeshRenderBound& getRenderBound() const { return m_renderBound; }
+
+        // Set LOD ranges before the asset is published
+        void setLods(std::vector<StaticMeshLod> lods);
+
+        const std::vector<StaticMeshLod>& getLods() const { return m_lods; }
+
+        // Set before the asset is published, standard layout ignores quantization box
+        void setVertexFormat(VertexFormat vertexFormat, const glm::vec3 &positionOffset, const glm::vec3 &positionScale)
+        {
+            m_vertexFormat = vertexFormat;
+            m_positionOffset = positionOffset;
+            m_positionScale = positionScale;
+        }
+
+        VertexFormat getVertexFormat() const { return m_vertexFormat; }
+
+        const glm::vec3& getPositionOffset() const { return m_positionOffset; }
+
+        const glm::vec3& getPositionScale() const { return m_positionScale; }
+
+        uint32_t getVertexBindlessIndex() const { return m_vertexBindlessIndex; }
+
+        uint32_t getIndexBindlessIndex() const { return m_indexBindlessIndex; }
     };
 
     class MeshContext final
@@ -114,8 +210,11 @@ namespace VT
         MeshContext() = default;
 
         void init();
+        void tick();
         void release();
 
+        [[nodiscard]] GPUAssetCacheStats getCacheStats() const { return m_GPUCache->getStats(); }
+
         bool isAssetExist(const UUID &id)
         {
             return m_GPUCache->contain(id);
@@ -143,6 +242,7 @@ namespace VT
 
         void finishCallback() override
         {
+            meshAssetGPU->registerBindless();
             meshAssetGPU->setAsyncLoadState(false);
         }
 
@@ -150,6 +250,11 @@ namespace VT
         {
             return static_cast<uint32_t>(meshAssetGPU->getSize());
         }
+
+        void acquireOwnership(CommandBufferBase &commandBuffer) override
+        {
+            meshAssetGPU->acquireOwnership(commandBuffer);
+        }
     };
 
     struct StaticMeshRawDataLoadTask : AssetMeshLoadTask
@@ -159,6 +264,11 @@ namespace VT
         std::vector<uint8_t> cacheVertexData;
         std::vector<uint8_t> cacheIndexData;
 
+        uint32_t getUploadSize() const override
+        {
+            return static_cast<uint32_t>(cacheVertexData.size() + cacheIndexData.size());
+        }
+
         void uploadDevice(uint32_t stageBufferOffset,
                         void *mapped,
                         CommandBufferBase &commandBuffer,
@@ -173,12 +283,47 @@ namespace VT
             VkIndexType indexType,
             uint8_t *vertices,
             size_t vertexSize,
-            size_t singleVertexSize);
+            size_t singleVertexSize,
+            std::vector<StaticMeshSubMesh> subMeshes = {},
+            std::vector<StaticMeshLod> lods = {});
 
+        // Build from model file with all sub-meshes, upload asynchronously by asset system
+        // Load cooked container when it is newer than model file, otherwise import and cook it for next launch
         static void buildFromPath(const std::string &name,
             const std::filesystem::path &path,
             const UUID &uuid,
-            bool isPersistent);
+            bool isPersistent,
+            VertexFormat vertexFormat = VertexFormat::Standard);
     };
 
+    // Upload straight from a cooked file mapping, vertex and index data are copied once into stage buffer
+    struct StaticMeshCookedLoadTask : AssetMeshLoadTask
+    {
+        StaticMeshCookedLoadTask() = default;
+
+        // Keep mapping alive until upload finish
+        Ref<MappedFile> mappedFile = nullptr;
+
+        const uint8_t *vertexData = nullptr;
+        size_t vertexSize = 0;
+        const uint8_t *indexData = nullptr;
+        size_t indexSize = 0;
+
+        uint32_t getUploadSize() const override
+        {
+            return static_cast<uint32_t>(vertexSize + indexSize);
+        }
+
+        void uploadDevice(uint32_t stageBufferOffset,
+                        void *mapped,
+                        CommandBufferBase &commandBuffer,
+                        VulkanBuffer &stageBuffer) override;
+
+        // Build from cooked mesh container, return nullptr when file missing or invalid
+        static Ref<StaticMeshCookedLoadTask> buildFromCooked(const std::string &name,
+            const std::filesystem::path &cookedPath,
+            const UUID &uuid,
+            bool isPersistent,
+            VertexFormat vertexFormat = VertexFormat::Standard);
+    };
 }
@@ -13,6 +13,12 @@ namespace VT
         Position, Normal, UV, Tangent, Bitangent
     };
 
+    // Vertex layout of one mesh, pipelines are created per layout
+    enum class VertexFormat : uint8_t
+    {
+        Standard = 0, Compact
+    };
+
     // Standard index type
     using VertexIndexType = uint32_t;
 
@@ -40,6 +46,92 @@ namespace VT
     // Explicit assert struct size avoid some glm macro pad memory to float4
     static_assert(sizeof(StaticMeshVertex) == (3 + 3 + 2 + 3 + 3) * sizeof(float));
 
+    // Compact static mesh vertex, 20 bytes instead of 56
+    // Position is unorm16 inside mesh quantization box, w stores bitangent sign
+    // Normal and tangent are octahedral snorm16, bitangent is rebuilt as cross(normal, tangent) * sign
+    struct StaticMeshCompactVertex
+    {
+        uint16_t position[4]{};
+        int16_t normal[2]{};
+        int16_t tangent[2]{};
+        uint16_t uv[2]{};       // half float
+
+        static VkVertexInputBindingDescription vertexInputBindingDescription;
+        static std::vector<VkVertexInputAttributeDescription> vertexInputAttributeDescriptions;
+        static VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo;
+
+        static VkVertexInputBindingDescription getInputBindingDescription(uint32_t binding);
+        static VkVertexInputAttributeDescription getInputAttributeDescription(uint32_t binding, uint32_t location, VertexComponent component);
+        static std::vector<VkVertexInputAttributeDescription> getInputAttributeDescriptions(uint32_t binding, const std::vector<VertexComponent> &components);
+
+        // Same locations as standard vertex, so one vertex shader decodes both layouts
+        static VkPipelineVertexInputStateCreateInfo* getPipelineVertexInputState(const std::vector<VertexComponent> &components, uint32_t binding = 0);
+
+        // Quantize standard vertex, position offset and scale describe the quantization box
+        static StaticMeshCompactVertex encode(const StaticMeshVertex &vertex, const glm::vec3 &positionOffset, const glm::vec3 &positionScale);
+        static StaticMeshVertex decode(const StaticMeshCompactVertex &vertex, const glm::vec3 &positionOffset, const glm::vec3 &positionScale);
+
+        // Compute quantization box from vertex positions
+        static void computeQuantization(const std::vector<StaticMeshVertex> &vertices, glm::vec3 &outPositionOffset, glm::vec3 &outPositionScale);
+    };
+
+    static_assert(sizeof(StaticMeshCompactVertex) == 20);
+
+    // Per batch vertex push constants, position dequantization is ignored by standard vertex
+    struct StaticMeshPushConstants
+    {
+        glm::vec4 positionOffset{ 0.0f };
+        glm::vec4 positionScale{ 1.0f };
+    };
+
+    // Per instance data in per frame storage buffer, indexed by gl_InstanceIndex, std430 layout
+    struct StaticMeshInstanceData
+    {
+        glm::mat4 model{ 1.0f };
+        uint32_t materialIndex = 0;     // Slot in bindless material buffer
+        uint32_t padding[3]{};
+    };
+
+    // Per instance culling data in per frame storage buffer, std430 layout
+    // Huge radius keeps instance always visible
+    struct StaticMeshCullData
+    {
+        glm::vec4 centerRadius{ 0.0f, 0.0f, 0.0f, 1.0f };     // World space bound sphere, negative radius is culled on CPU
+        glm::vec3 extent{ 1.0f };                              // World space bound box half extent
+        uint32_t batchIndex = 0;                               // Indirect command of the instance
+    };
+
+    static_assert(sizeof(StaticMeshPushConstants) == 32);
+    static_assert(sizeof(StaticMeshInstanceData) == 80);
+    static_assert(sizeof(StaticMeshCullData) == 32);
+
+    inline uint32_t getVertexFormatStride(VertexFormat format)
+    {
+        return format == VertexFormat::Compact ? sizeof(StaticMeshCompactVertex) : sizeof(StaticMeshVertex);
+    }
+
+    // Meshes with fewer than 65536 vertices use 16-bit indices, primitive restart is never enabled
+    inline VkIndexType getIndexTypeForVertexCount(size_t vertexCount)
+    {
+        return vertexCount <= std::numeric_limits<uint16_t>::max() + size_t(1) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
+
+    inline uint32_t indexTypeToSize(VkIndexType type)
+    {
+        switch (type)
+        {
+            case VK_INDEX_TYPE_UINT16:    return sizeof(uint16_t);
+            case VK_INDEX_TYPE_UINT32:    return sizeof(uint32_t);
+            case VK_INDEX_TYPE_UINT8_EXT: return sizeof(uint8_t);
+            default:
+                VT_CORE_CRITICAL("Unknown VkIndexType");
+        }
+        return 0;
+    }
+
+    // Narrow standard indices to 16-bit, every index must fit
+    std::vector<uint16_t> narrowIndices(const std::vector<VertexIndexType> &indices);
+
     // Render bounds of sub-mesh
     struct StaticMeshRenderBound
     {
@@ -60,7 +152,74 @@ namespace VT
         uint32_t indexStartPosition = 0;
         uint32_t indexCount = 0;
         std::string material{};
+
+        // Exact union of sub-mesh boxes, no inflation unlike StaticMeshRenderBound::combine
+        static StaticMeshRenderBound mergeBounds(const std::vector<StaticMeshSubMesh> &subMeshes);
     };
+
+    // LOD 0 is the full mesh, coarser LODs follow it in the same index buffer
+    constexpr uint32_t GMaxMeshLodCount = 4;
+    // Simplification error allowed on screen when selecting LOD, in pixels
+    constexpr float GMeshLodPixelError = 1.0f;
+    // Bound sphere projected smaller than this uses coarsest LOD, in pixels
+    constexpr float GMeshLodMinScreenSize = 8.0f;
+
+    struct StaticMeshLod
+    {
+        uint32_t indexStartPosition = 0;
+        uint32_t indexCount = 0;
+        // Object space distance to LOD 0 surface, accumulated along the chain
+        float error = 0.0f;
+    };
+
+    // Cooked static mesh container, every section is aligned so it can be copied straight from a file mapping
+    // Layout: header | vertices | indices | sub-mesh table | material name blob
+    constexpr uint32_t GCookedMeshMagic = 0x534D5456;      // "VTMS"
+    constexpr uint32_t GCookedMeshVersion = 4;
+    constexpr uint64_t GCookedMeshAlignment = 16;
+    constexpr const char *GCookedMeshExtension = ".vtmesh";
+
+    struct CookedMeshHeader
+    {
+        uint32_t magic = GCookedMeshMagic;
+        uint32_t version = GCookedMeshVersion;
+        uint32_t vertexStride = sizeof(StaticMeshVertex);
+        uint32_t indexStride = sizeof(VertexIndexType);     // 2 when vertex count allows 16-bit indices
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        uint32_t subMeshCount = 0;
+        uint32_t vertexFormat = static_cast<uint32_t>(VertexFormat::Standard);
+        StaticMeshRenderBound renderBound{};
+        uint32_t lodCount = 0;
+
+        // Byte offsets from file begin
+        uint64_t vertexOffset = 0;
+        uint64_t indexOffset = 0;
+        uint64_t subMeshOffset = 0;
+        uint64_t nameOffset = 0;
+        uint64_t nameSize = 0;
+
+        // Quantization box of compact vertex
+        glm::vec3 positionOffset{ 0.0f };
+        glm::vec3 positionScale{ 1.0f };
+
+        // LOD 0 first, index ranges into index section
+        StaticMeshLod lods[GMaxMeshLodCount]{};
+    };
+
+    struct CookedSubMesh
+    {
+        StaticMeshRenderBound renderBound{};
+        uint32_t indexStartPosition = 0;
+        uint32_t indexCount = 0;
+        // Range in material name blob
+        uint32_t materialNameOffset = 0;
+        uint32_t materialNameSize = 0;
+    };
+
+    static_assert(std::is_trivially_copyable_v<CookedMeshHeader> && sizeof(CookedMeshHeader) == 176);
+    static_assert(std::is_trivially_copyable_v<StaticMeshLod> && sizeof(StaticMeshLod) == 12);
+    static_assert(std::is_trivially_copyable_v<CookedSubMesh> && sizeof(CookedSubMesh) == 44);
 }
 
 
@@ -0,0 +1,60 @@
+//
+// Created by ZHIKANG on 2023/4/14.
+//
+
+#pragma once
+
+#include <VulkanToy/AssetSystem/MeshMisc.h>
+
+namespace VT
+{
+    // Post transform cache size assumed when reordering, small enough to suit most GPUs
+    constexpr uint32_t GMeshOptimizerCacheSize = 16;
+    // Overdraw clusters may give up this much cache efficiency, relative to vertex cache optimized order
+    constexpr float GMeshOptimizerOverdrawThreshold = 1.05f;
+
+    struct MeshCacheStatistics
+    {
+        uint32_t triangleCount = 0;
+        uint32_t vertexCount = 0;
+        uint32_t cacheMissCount = 0;
+
+        // Average cache miss ratio, transformed vertices per triangle, 0.5 is ideal for regular grid
+        float acmr = 0.0f;
+        // Average transform to vertex ratio, 1.0 is ideal
+        float atvr = 0.0f;
+    };
+
+    // Offline index and vertex reordering, runs at cook time on CPU only
+    // Indices are absolute into vertex array, every pass keeps the sub-mesh index ranges intact
+    class MeshOptimizer
+    {
+    public:
+        // Full pipeline: vertex cache, overdraw, then vertex fetch remap, report LOD 0 statistics per mesh
+        // Sub-meshes describe LOD 0, every coarser LOD range is reordered as a whole
+        static void optimize(const std::string &name,
+                            std::vector<StaticMeshVertex> &vertices,
+                            std::vector<VertexIndexType> &indices,
+                            const std::vector<StaticMeshSubMesh> &subMeshes,
+                            const std::vector<StaticMeshLod> &lods = {});
+
+        // Tipsify ordering, output triangle offsets where each cluster starts
+        static void optimizeVertexCache(VertexIndexType *indices, size_t indexCount,
+                                        std::vector<uint32_t> *outClusters = nullptr,
+                                        uint32_t cacheSize = GMeshOptimizerCacheSize);
+
+        // Split clusters at soft boundaries and draw outward facing clusters first
+        static void optimizeOverdraw(VertexIndexType *indices, size_t indexCount,
+                                    const StaticMeshVertex *vertices,
+                                    const std::vector<uint32_t> &hardClusters,
+                                    float threshold = GMeshOptimizerOverdrawThreshold,
+                                    uint32_t cacheSize = GMeshOptimizerCacheSize);
+
+        // Reorder vertices by first use, unreferenced vertices move to the end
+        static void optimizeVertexFetch(std::vector<StaticMeshVertex> &vertices, std::vector<VertexIndexType> &indices);
+
+        // FIFO post transform cache simulation
+        static MeshCacheStatistics analyzeVertexCache(const VertexIndexType *indices, size_t indexCount,
+                                                    uint32_t cacheSize = GMeshOptimizerCacheSize);
+    };
+}
@@ -0,0 +1,34 @@
+//
+// Created by ZHIKANG on 2023/4/15.
+//
+
+#pragma once
+
+#include <VulkanToy/AssetSystem/MeshMisc.h>
+
+namespace VT
+{
+    // Triangle ratio between two consecutive LODs
+    constexpr float GMeshLodReduction = 0.5f;
+    // Stop the chain once a LOD would drop below this triangle count
+    constexpr uint32_t GMeshLodMinTriangleCount = 64;
+
+    // Offline quadric error edge collapse, runs at cook time on CPU only
+    // Vertices are never moved or added, every LOD indexes the same vertex buffer
+    class MeshSimplifier
+    {
+    public:
+        // Collapse edges until index count reaches target or nothing can collapse, return object space error
+        // Seam and border vertices are locked so attribute seams and open edges never crack
+        static float simplify(const std::vector<StaticMeshVertex> &vertices,
+                            const VertexIndexType *indices, size_t indexCount,
+                            size_t targetIndexCount, std::vector<VertexIndexType> &outIndices);
+
+        // Append coarser LODs after LOD 0 indices, each sub-mesh is simplified on its own
+        // Return LOD table, LOD 0 covers the original indices
+        static std::vector<StaticMeshLod> buildLodChain(const std::string &name,
+                                                        const std::vector<StaticMeshVertex> &vertices,
+                                                        std::vector<VertexIndexType> &indices,
+                                                        const std::vector<StaticMeshSubMesh> &subMeshes);
+    };
+}
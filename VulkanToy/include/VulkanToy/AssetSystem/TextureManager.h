@@ -59,6 +59,8 @@ namespace VT
     {
     private:
         Ref<VulkanImage> m_image = nullptr;
+        // Slot in bindless sampled image array, taken when upload finish
+        uint32_t m_bindlessIndex = std::numeric_limits<uint32_t>::max();
 
     public:
         GPUImageAsset(const std::string &name, bool isPersistent, VkFormat format,
@@ -66,14 +68,20 @@ namespace VT
 
         ~GPUImageAsset() override;
 
-        void release();
+        void release() override;
 
         // Prepare image layout when start to upload
         void prepareToUpload(CommandBufferBase &cmd, VkImageSubresourceRange range);
 
-        // Finish image layout when ready for shader read
+        // Finish image layout when ready for shader read, release from copy queue
         void finishUpload(CommandBufferBase &cmd, VkImageSubresourceRange range);
 
+        // Acquire image on graphics queue, generate mipmaps if needed
+        void acquireOwnership(CommandBufferBase &cmd, VkImageSubresourceRange range);
+
+        // Register image view into bindless heap, image must be in shader read only layout
+        void registerBindless();
+
         size_t getSize() const override
         {
             return m_image->getMemorySize();
@@ -82,6 +90,8 @@ namespace VT
         auto& getImage() { return m_image->getImage(); }
 
         Ref<VulkanImage> getVulkanImage() const { return m_image; }
+
+        [[nodiscard]] uint32_t getBindlessIndex() const { return m_bindlessIndex; }
     };
 
     class TextureContext final
@@ -93,8 +103,11 @@ namespace VT
         TextureContext() = default;
 
         void init();
+        void tick();
         void release();
 
+        [[nodiscard]] GPUAssetCacheStats getCacheStats() const { return m_GPUCache->getStats(); }
+
         bool isAssetExist(const UUID &id)
         {
             return m_GPUCache->contain(id);
@@ -127,8 +140,15 @@ namespace VT
 
         void finishCallback() override
         {
+            imageAssetGPU->registerBindless();
             imageAssetGPU->setAsyncLoadState(false);
         }
+
+        void acquireOwnership(CommandBufferBase &commandBuffer) override
+        {
+            VkImageSubresourceRange range{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+            imageAssetGPU->acquireOwnership(commandBuffer, range);
+        }
     };
 
     // Load from raw data, no mipmap, persistent, no compress
@@ -138,12 +158,17 @@ namespace VT
 
         TextureRawDataLoadTask() = default;
 
+        uint32_t getUploadSize() const override
+        {
+            return static_cast<uint32_t>(cacheRawData.size());
+        }
+
         void uploadDevice(uint32_t stageBufferOffset,
                         void *mapped,
                         CommandBufferBase &commandBuffer,
                         VulkanBuffer &stageBuffer) override;
 
-        // Build load task from file path - store in Texture Manager
+        // Build load task from file path - store in Texture Manager, upload asynchronously by asset system
         static void buildFromPath(
             const std::filesystem::path &path,
             const UUID &uuid,
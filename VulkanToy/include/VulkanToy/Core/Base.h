@@ -87,6 +87,7 @@ namespace VT
 #include <VulkanToy/Core/DisableCopy.h>
 #include <VulkanToy/Core/Singleton.h>
 #include <VulkanToy/Core/Log.h>
+#include <VulkanToy/Core/Profiler.h>
 #include <VulkanToy/Core/UUID.h>
 
 
@@ -11,11 +11,29 @@
 
 namespace VT
 {
+    // Startup options, set before engine init
+    struct EngineSettings
+    {
+        // Cull components on CPU before batching, otherwise every instance is culled in compute pass
+        bool cpuCulling = false;
+        // Record main pass on calling thread only, otherwise long draw lists split across workers
+        bool serialRecording = false;
+        // Frames CPU may record ahead of GPU, zero keeps RHI default, clamped to GMaxFramesInFlight
+        uint32_t framesInFlight = 0;
+        // Chrome trace written on release, empty writes none, startup frames are captured when set
+        std::filesystem::path traceExportPath;
+
+        // Options not recognized are ignored, e.g. --cpu-culling --serial-recording --frames-in-flight 3 --trace VulkanToyTrace.json
+        static EngineSettings fromCommandLine(int argc, char **argv);
+    };
+
     class Engine final
     {
     private:
         Scope<Window> m_window;
 
+        EngineSettings m_settings{};
+
         LayerStack m_layerStack;
 
         float m_lastTime = 0.0f;
@@ -34,6 +52,9 @@ namespace VT
         Window& getWindow() { return *m_window; }
         bool isEngineInitialized() const { return m_isInitialized; }
 
+        void setSettings(const EngineSettings &settings) { m_settings = settings; }
+        const EngineSettings& getSettings() const { return m_settings; }
+
         void pushLayer(Layer *layer);
         void pushOverlay(Layer *layer);
 
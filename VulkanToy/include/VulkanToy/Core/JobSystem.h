@@ -0,0 +1,121 @@
+//
+// Created by ZHIKANG on 2023/4/22.
+//
+
+#pragma once
+
+#include <VulkanToy/Core/Base.h>
+
+namespace VT
+{
+    // Items per parallel for job, smaller loops run on calling thread
+    constexpr uint32_t GDefaultJobGrainSize = 64;
+    // Parallel for splits into at most this many jobs per thread, leftovers are balanced by stealing
+    constexpr uint32_t GJobsPerThread = 4;
+
+    using Job = std::function<void()>;
+
+    // Unfinished jobs of one group, see JobSystem::wait
+    class JobCounter final : public DisableCopy
+    {
+    private:
+        friend class JobSystem;
+        std::atomic<uint32_t> m_pending{ 0 };
+
+    public:
+        [[nodiscard]] bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+    };
+
+    // Work stealing scheduler, each worker pops newest job of own deque and steals oldest job of others
+    // External threads push into a shared deque, waiting threads run jobs instead of blocking,
+    // so jobs may spawn and wait on nested jobs
+    class JobSystem final
+    {
+    private:
+        struct JobEntry
+        {
+            Job job;
+            JobCounter *counter = nullptr;
+        };
+
+        struct JobQueue
+        {
+            std::mutex mutex;
+            std::deque<JobEntry> jobs;
+        };
+
+        std::vector<std::thread> m_workers;
+        // Queue 0 is shared by external threads, queue i belongs to worker i
+        std::vector<Scope<JobQueue>> m_queues;
+        std::atomic<uint32_t> m_queuedJobCount{ 0 };
+
+        std::mutex m_sleepMutex;
+        std::condition_variable m_sleepCondition;
+        bool m_isShutdown = false;
+
+    private:
+        void workerLoop(uint32_t queueIndex);
+
+        void push(JobEntry &&entry);
+
+        // Own queue first, then steal from others
+        bool tryPop(JobEntry &outEntry);
+
+        static void execute(JobEntry &entry);
+
+    public:
+        // Zero worker count uses hardware concurrency minus calling thread
+        void init(uint32_t workerCount = 0);
+
+        void release();
+
+        void run(JobCounter &counter, Job &&job);
+
+        // Run queued jobs on calling thread until counter is done
+        void wait(JobCounter &counter);
+
+        // Split [0, count) into ranges of at least grain size and wait for all of them, calling thread takes part
+        void parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)> &func);
+
+        // Workers plus calling thread
+        [[nodiscard]] uint32_t getConcurrency() const { return static_cast<uint32_t>(m_workers.size()) + 1; }
+
+        // Zero on external threads, worker index plus one on workers
+        static uint32_t getThreadIndex();
+    };
+
+    // Jobs with dependencies, a node starts once every node it depends on has finished
+    // Graph is built once and may run many times, run blocks until every node finished
+    class JobGraph final
+    {
+    public:
+        using NodeId = uint32_t;
+
+    private:
+        struct Node
+        {
+            Job job;
+            std::vector<NodeId> successors;
+            uint32_t dependencyCount = 0;
+            std::atomic<uint32_t> remainingDependencies{ 0 };
+        };
+
+        // Deque keeps node addresses stable, atomics cannot move
+        std::deque<Node> m_nodes;
+
+    private:
+        void schedule(JobSystem &jobSystem, JobCounter &counter, NodeId nodeId);
+
+    public:
+        NodeId addNode(Job &&job);
+
+        // Node runs after dependency finished
+        void addDependency(NodeId node, NodeId dependency);
+
+        void run(JobSystem &jobSystem);
+
+        [[nodiscard]] size_t getNodeCount() const { return m_nodes.size(); }
+    };
+
+    using JobSystemHandle = Singleton<JobSystem>;
+}
@@ -0,0 +1,41 @@
+//
+// Created by ZHIKANG on 2023/4/10.
+//
+
+#pragma once
+
+#include <VulkanToy/Core/Base.h>
+
+namespace VT
+{
+    // Read only memory mapped file, pages are faulted in by OS on first touch
+    class MappedFile : private DisableCopy
+    {
+    private:
+        std::filesystem::path m_path{};
+        const uint8_t *m_data = nullptr;
+        size_t m_size = 0;
+
+#ifdef _WIN32
+        void *m_fileHandle = nullptr;
+        void *m_mappingHandle = nullptr;
+#else
+        int m_fileDescriptor = -1;
+#endif
+
+    public:
+        explicit MappedFile(const std::filesystem::path &path);
+        ~MappedFile();
+
+        // Return nullptr when file can not be opened or mapped
+        static Ref<MappedFile> create(const std::filesystem::path &path);
+
+        [[nodiscard]] bool isValid() const { return m_data != nullptr; }
+        [[nodiscard]] const uint8_t* getData() const { return m_data; }
+        [[nodiscard]] size_t getSize() const { return m_size; }
+        [[nodiscard]] const std::filesystem::path& getPath() const { return m_path; }
+
+    private:
+        void release();
+    };
+}
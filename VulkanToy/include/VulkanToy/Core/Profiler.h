@@ -0,0 +1,174 @@
+//
+// Created by ZHIKANG on 2023/4/23.
+//
+
+#pragma once
+
+#include <VulkanToy/Core/Base.h>
+
+namespace VT
+{
+    // Events one thread may record between two frame marks, later ones are dropped
+    constexpr uint32_t GProfilerThreadEventCapacity = 8192;
+    // Frame durations kept for history plot
+    constexpr uint32_t GProfilerFrameHistorySize = 240;
+    // Frames captured from start when a trace export is requested, covers engine init and first frames
+    constexpr uint32_t GProfilerStartupCaptureFrames = 120;
+    // Captured events kept for trace export
+    constexpr uint32_t GProfilerMaxCaptureEvents = 1 << 20;
+
+    struct ProfilerEvent
+    {
+        const char *name = nullptr;
+        uint64_t beginNs = 0;
+        uint64_t endNs = 0;
+        uint32_t depth = 0;
+    };
+
+    // Zones of one frame merged by call path, calls of same zone under same parent share a node
+    struct ProfilerZoneNode
+    {
+        const char *name = nullptr;
+        uint32_t parent = UINT32_MAX;
+        uint32_t depth = 0;
+        uint32_t callCount = 0;
+        uint64_t totalNs = 0;
+        uint64_t childNs = 0;
+
+        [[nodiscard]] uint64_t getSelfNs() const { return totalNs > childNs ? totalNs - childNs : 0; }
+    };
+
+    struct ProfilerThreadFrame
+    {
+        std::string threadName;
+        // Depth first order, first child directly follows its parent
+        std::vector<ProfilerZoneNode> nodes;
+    };
+
+    struct ProfilerFrame
+    {
+        uint64_t frameNumber = 0;
+        uint64_t durationNs = 0;
+        uint32_t droppedEventCount = 0;
+        std::vector<ProfilerThreadFrame> threads;
+    };
+
+    // Hierarchical CPU zones, each thread writes its own ring without locks and frame mark drains every ring
+    // Zone names must outlive profiler, use string literals or internName
+    class Profiler final : public DisableCopy
+    {
+    private:
+        // Single producer single consumer, owner thread writes head and frame mark reads up to it
+        struct ThreadBuffer
+        {
+            std::string name;
+            uint32_t threadId = 0;
+            uint32_t depth = 0;
+            std::atomic<uint64_t> head{ 0 };
+            std::atomic<uint64_t> tail{ 0 };
+            std::atomic<uint32_t> droppedCount{ 0 };
+            std::array<ProfilerEvent, GProfilerThreadEventCapacity> events;
+        };
+
+        struct CaptureEvent
+        {
+            ProfilerEvent event;
+            uint32_t threadId = 0;
+        };
+
+        std::chrono::steady_clock::time_point m_epoch = std::chrono::steady_clock::now();
+
+        std::mutex m_threadMutex;
+        // Buffers live until profiler is destroyed, exited threads keep their history
+        std::vector<Scope<ThreadBuffer>> m_threadBuffers;
+
+        std::mutex m_nameMutex;
+        std::unordered_set<std::string> m_internedNames;
+
+        std::mutex m_frameMutex;
+        uint64_t m_frameNumber = 0;
+        uint64_t m_frameBeginNs = 0;
+        ProfilerFrame m_lastFrame{};
+        std::vector<float> m_frameHistoryMs;
+        uint32_t m_frameHistoryOffset = 0;
+
+        bool m_isCapturing = false;
+        uint64_t m_captureEndFrame = 0;
+        std::vector<CaptureEvent> m_captureEvents;
+
+    private:
+        ThreadBuffer& getThreadBuffer();
+
+        // Merge drained events of one thread into call tree
+        static void aggregate(std::vector<ProfilerEvent> &events, ProfilerThreadFrame &outFrame);
+
+    public:
+        Profiler();
+
+        [[nodiscard]] uint64_t getTimeNs() const;
+
+        void beginZone();
+        void endZone(const char *name, uint64_t beginNs);
+
+        // Name shown for calling thread
+        void setThreadName(const std::string &name);
+
+        // Stable copy of a runtime name, e.g. render graph pass names
+        const char* internName(std::string_view name);
+
+        // Close current frame, drain every thread and rebuild frame statistics
+        void markFrame();
+
+        // Copy of last closed frame
+        [[nodiscard]] ProfilerFrame getLastFrame();
+
+        // Frame times in milliseconds, oldest first
+        [[nodiscard]] std::vector<float> getFrameHistory();
+
+        void startCapture(uint32_t frameCount);
+        void stopCapture();
+
+        [[nodiscard]] bool isCapturing();
+
+        // Chrome trace event format, open in chrome://tracing or Perfetto
+        bool exportChromeTrace(const std::filesystem::path &path);
+    };
+
+    using ProfilerHandle = Singleton<Profiler>;
+
+    class ProfileZone final : public DisableCopy
+    {
+    private:
+        const char *m_name;
+        uint64_t m_beginNs;
+
+    public:
+        explicit ProfileZone(const char *name)
+        : m_name(name)
+        {
+            ProfilerHandle::Get()->beginZone();
+            m_beginNs = ProfilerHandle::Get()->getTimeNs();
+        }
+
+        ~ProfileZone()
+        {
+            ProfilerHandle::Get()->endZone(m_name, m_beginNs);
+        }
+    };
+}
+
+#define VT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VT_PROFILE_CONCAT(a, b) VT_PROFILE_CONCAT_IMPL(a, b)
+
+// Zones compile away unless VT_ENABLE_PROFILER is defined
+#ifdef VT_ENABLE_PROFILER
+    #define VT_PROFILE_SCOPE(name) ::VT::ProfileZone VT_PROFILE_CONCAT(profileZone, __LINE__){ name }
+    #define VT_PROFILE_SCOPE_DYNAMIC(name) ::VT::ProfileZone VT_PROFILE_CONCAT(profileZone, __LINE__){ ::VT::ProfilerHandle::Get()->internName(name) }
+    #define VT_PROFILE_THREAD(name) ::VT::ProfilerHandle::Get()->setThreadName(name)
+    #define VT_PROFILE_FRAME() ::VT::ProfilerHandle::Get()->markFrame()
+#else
+    #define VT_PROFILE_SCOPE(name)
+    #define VT_PROFILE_SCOPE_DYNAMIC(name)
+    #define VT_PROFILE_THREAD(name)
+    #define VT_PROFILE_FRAME()
+#endif
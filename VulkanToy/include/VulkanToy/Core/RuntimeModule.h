@@ -5,6 +5,7 @@
 #pragma once
 
 #include <VulkanToy/Core/Base.h>
+#include <VulkanToy/Core/JobSystem.h>
 
 namespace VT
 {
@@ -40,5 +41,9 @@ namespace VT
         virtual void init() { }
         virtual void tick(const RuntimeModuleTickData &tickData) = 0;
         virtual void release() { }
+
+    protected:
+        // Scheduler shared by all modules, jobs may run on any worker
+        static JobSystem& getJobSystem() { return *JobSystemHandle::Get(); }
     };
 }
@@ -8,12 +8,106 @@
 
 namespace VT
 {
-    // Standard string uuid
-    // String uuid maybe slow than uint128, but current speed is enough
-    using UUID = std::string;
+    // 128-bit uuid, trivially copyable and cheap to hash and compare
+    // String form is the standard 8-4-4-4-12 lower case hex, same as stduuid
+    struct UUID
+    {
+        uint64_t high = 0;
+        uint64_t low = 0;
+
+        constexpr UUID() = default;
+        constexpr UUID(uint64_t inHigh, uint64_t inLow) : high(inHigh), low(inLow) {}
+
+        [[nodiscard]] constexpr bool isNil() const { return high == 0 && low == 0; }
+
+        constexpr auto operator<=>(const UUID &) const = default;
+
+        // Parse string form, accept optional braces, return nullopt when malformed
+        static constexpr std::optional<UUID> fromString(std::string_view str)
+        {
+            if (str.size() == 38 && str.front() == '{' && str.back() == '}')
+            {
+                str = str.substr(1, 36);
+            }
+            if (str.size() != 36)
+            {
+                return std::nullopt;
+            }
+
+            UUID result{};
+            uint32_t nibbleCount = 0;
+            for (size_t index = 0; index < str.size(); ++index)
+            {
+                const char c = str[index];
+                if (index == 8 || index == 13 || index == 18 || index == 23)
+                {
+                    if (c != '-')
+                    {
+                        return std::nullopt;
+                    }
+                    continue;
+                }
+
+                const int32_t nibble = hexToNibble(c);
+                if (nibble < 0)
+                {
+                    return std::nullopt;
+                }
+                uint64_t &word = nibbleCount < 16 ? result.high : result.low;
+                word = (word << 4) | static_cast<uint64_t>(nibble);
+                ++nibbleCount;
+            }
+            return result;
+        }
+
+        [[nodiscard]] std::string toString() const
+        {
+            constexpr char hexDigits[] = "0123456789abcdef";
+            std::string result(36, '-');
+            uint32_t nibbleCount = 0;
+            for (size_t index = 0; index < result.size(); ++index)
+            {
+                if (index == 8 || index == 13 || index == 18 || index == 23)
+                {
+                    continue;
+                }
+                const uint64_t word = nibbleCount < 16 ? high : low;
+                const uint32_t shift = 60 - 4 * (nibbleCount % 16);
+                result[index] = hexDigits[(word >> shift) & 0xf];
+                ++nibbleCount;
+            }
+            return result;
+        }
+
+    private:
+        static constexpr int32_t hexToNibble(char c)
+        {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+    };
+    static_assert(std::is_trivially_copyable_v<UUID> && sizeof(UUID) == 16);
+
+    inline std::ostream& operator<<(std::ostream &os, const UUID &uuid)
+    {
+        return os << uuid.toString();
+    }
+
+    // Random uuid from system generator
     inline UUID buildUUID()
     {
-        return uuids::to_string(uuids::uuid_system_generator{}());
+        const auto systemUUID = uuids::uuid_system_generator{}();
+        const auto bytes = systemUUID.as_bytes();
+
+        UUID result{};
+        for (size_t index = 0; index < 8; ++index)
+        {
+            result.high = (result.high << 8) | static_cast<uint64_t>(bytes[index]);
+            result.low = (result.low << 8) | static_cast<uint64_t>(bytes[index + 8]);
+        }
+        return result;
     }
 
     // Random device guid
@@ -27,3 +121,18 @@ namespace VT
         return s_uniformDistribution(s_engine);
     }
 }
+
+namespace std
+{
+    template<>
+    struct hash<VT::UUID>
+    {
+        size_t operator()(const VT::UUID &uuid) const noexcept
+        {
+            // Random bits already, one multiply-xorshift round to fold both halves
+            uint64_t value = uuid.high ^ (uuid.low * 0x9e3779b97f4a7c15ull);
+            value ^= value >> 32;
+            return static_cast<size_t>(value);
+        }
+    };
+}
@@ -0,0 +1,31 @@
+//
+// Created by ZHIKANG on 2023/4/17.
+//
+
+#pragma once
+
+#include <VulkanToy/VulkanRHI/GPUResource.h>
+#include <VulkanToy/Renderer/PassCommon.h>
+
+namespace VT
+{
+    // Compute frustum culling of scene instances, writes indirect and visible buffers read by PBR pass
+    class CullingPass final
+    {
+    private:
+        VkPipeline m_cullingPipeline = VK_NULL_HANDLE;
+        VkPipelineLayout m_cullingPipelineLayout = VK_NULL_HANDLE;
+        VkDescriptorSetLayout m_instanceDescriptorSetLayout = VK_NULL_HANDLE;
+
+    public:
+        void init(const PassAttachmentFormats &formats);
+
+        void release();
+
+        // Build draw batches of this frame and add culling of their instances, imports instance buffers into graph
+        void addToRenderGraph(RenderGraph &graph, PassFrameResources &resources);
+
+        [[nodiscard]] const VkPipeline& getPipeline() const { return m_cullingPipeline; }
+        [[nodiscard]] const VkPipelineLayout& getPipelineLayout() const { return m_cullingPipelineLayout; }
+    };
+}
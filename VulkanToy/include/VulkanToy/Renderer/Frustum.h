@@ -46,10 +46,11 @@ namespace VT
             m_Plane[BOTTOM].z = matrix[2].w + matrix[2].y;
             m_Plane[BOTTOM].w = matrix[3].w + matrix[3].y;
 
-            m_Plane[BACK].x = matrix[0].w + matrix[0].z;
-            m_Plane[BACK].y = matrix[1].w + matrix[1].z;
-            m_Plane[BACK].z = matrix[2].w + matrix[2].z;
-            m_Plane[BACK].w = matrix[3].w + matrix[3].z;
+            // Depth range is zero to one, near plane is z >= 0 rather than z >= -w
+            m_Plane[BACK].x = matrix[0].z;
+            m_Plane[BACK].y = matrix[1].z;
+            m_Plane[BACK].z = matrix[2].z;
+            m_Plane[BACK].w = matrix[3].z;
 
             m_Plane[FRONT].x = matrix[0].w - matrix[0].z;
             m_Plane[FRONT].y = matrix[1].w - matrix[1].z;
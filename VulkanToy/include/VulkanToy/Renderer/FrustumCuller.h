@@ -0,0 +1,65 @@
+//
+// Created by ZHIKANG on 2023/4/16.
+//
+
+#pragma once
+
+#include <VulkanToy/Renderer/Frustum.h>
+
+namespace VT
+{
+    // Bounds per SIMD batch, table is padded to it so batches never read past the end
+    constexpr uint32_t GCullingBatchSize = 8;
+    // Bounds per parallel culling chunk, smaller tables cull on calling thread
+    constexpr uint32_t GCullingChunkSize = 16384;
+
+    static_assert(GCullingChunkSize % GCullingBatchSize == 0, "Culling chunk must hold whole batches");
+
+    // World space bounds of all drawables in structure of arrays
+    // Object is tested with both sphere and box, whichever is tighter against each plane
+    class CullingBoundsTable
+    {
+    private:
+        std::vector<float> m_centerX, m_centerY, m_centerZ;
+        std::vector<float> m_extentX, m_extentY, m_extentZ;
+        std::vector<float> m_radius;
+        uint32_t m_count = 0;
+
+    public:
+        // Keep existing entries, padding entries are always culled
+        void resize(uint32_t count);
+
+        void set(uint32_t index, const glm::vec3 &center, const glm::vec3 &extent, float radius);
+
+        // Never culled, for drawables without bounds
+        void setAlwaysVisible(uint32_t index);
+
+        [[nodiscard]] uint32_t getCount() const { return m_count; }
+
+        [[nodiscard]] const float* getCenterX() const { return m_centerX.data(); }
+        [[nodiscard]] const float* getCenterY() const { return m_centerY.data(); }
+        [[nodiscard]] const float* getCenterZ() const { return m_centerZ.data(); }
+        [[nodiscard]] const float* getExtentX() const { return m_extentX.data(); }
+        [[nodiscard]] const float* getExtentY() const { return m_extentY.data(); }
+        [[nodiscard]] const float* getExtentZ() const { return m_extentZ.data(); }
+        [[nodiscard]] const float* getRadius() const { return m_radius.data(); }
+    };
+
+    class FrustumCuller
+    {
+    public:
+        // Test bounds [begin, end) against six planes with SSE, or AVX when compiled with it
+        // Begin must be batch aligned, output needs room for (end - begin) rounded up to batch size
+        // Return visible count, indices are written ascending
+        static uint32_t cull(const Frustum &frustum, const CullingBoundsTable &bounds,
+                            uint32_t begin, uint32_t end, uint32_t *outVisible);
+
+        // Scalar reference, same result as cull
+        static uint32_t cullScalar(const Frustum &frustum, const CullingBoundsTable &bounds,
+                                    uint32_t begin, uint32_t end, uint32_t *outVisible);
+
+        // Whole table, chunks run as jobs once table is larger than one chunk
+        static void cullAll(const Frustum &frustum, const CullingBoundsTable &bounds,
+                            std::vector<uint32_t> &outVisible);
+    };
+}
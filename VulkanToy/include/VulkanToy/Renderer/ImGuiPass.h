@@ -5,7 +5,7 @@
 #pragma once
 
 #include <VulkanToy/Core/Base.h>
-#include <VulkanToy/VulkanRHI/GPUResource.h>
+#include <VulkanToy/Renderer/PassCommon.h>
 
 namespace VT
 {
@@ -13,6 +13,7 @@ namespace VT
     {
     private:
         // Event delegate
+        uint32_t m_swapChainRebuildHandle = 0;
 
         // GPU resource
         struct ImGuiPassGPUResource
@@ -20,34 +21,40 @@ namespace VT
             VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
             VkRenderPass renderPass = VK_NULL_HANDLE;
 
+            // One per swap chain image, UI is drawn over tone mapped image
             std::vector<VkFramebuffer> frameBuffers;
-            std::vector<VkCommandPool> commandPools;
-            std::vector<VkCommandBuffer> commandBuffers;
         } m_renderResource;
 
-        glm::vec4 m_clearColor{ 0.45f, 0.55f, 0.60f, 1.00f };
-
         bool m_isInit = false;
 
-    private:
-        const VkFormat m_drawUIFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
-        Ref<VulkanImage> m_drawUIImages;
+        // Profiler panel state
+        bool m_isProfilerPaused = false;
+        ProfilerFrame m_profilerFrame{};
+        uint32_t m_profilerCaptureFrames = 300;
 
+    private:
         void buildRenderPass();
         void releaseRenderPass(bool isFullRelease);
 
     public:
-        VkCommandBuffer getCommandBuffer(uint32_t index)
-        {
-            return m_renderResource.commandBuffers[index];
-        }
-
         void init();
         void release();
 
-        void renderFrame(uint32_t backBufferIndex);
+        // Start ImGui frame, windows are drawn between this and endFrame
+        void beginFrame();
+        void endFrame();
+
+        // Draw UI of last endFrame into swap chain image after tone mapping
+        void addToRenderGraph(RenderGraph &graph, PassFrameResources &resources);
+
+        void renderFrame(VkCommandBuffer cmd, uint32_t backBufferIndex);
+
+        // Frame time history and zone tree of last frame, call between ImGui new frame and render
+        void drawProfilerPanel(bool *isOpen = nullptr);
+
+        // Rolling GPU time per pass and dispatch in a corner overlay
+        void drawGPUProfilerOverlay(bool *isOpen = nullptr);
     };
-}
 
 
 
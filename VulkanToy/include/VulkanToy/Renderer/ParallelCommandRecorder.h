@@ -0,0 +1,59 @@
+//
+// Created by ZHIKANG on 2023/4/18.
+//
+
+#pragma once
+
+#include <VulkanToy/VulkanRHI/VulkanRHICommon.h>
+
+namespace VT
+{
+    // Draw items per parallel recording chunk, smaller draw lists record on calling thread
+    constexpr uint32_t GMinDrawItemsPerRecordChunk = 64;
+
+    // Record secondary command buffers of one dynamic rendering scope on several threads
+    // Command pools are per thread and per frame slot, reset when that slot is acquired again
+    class ParallelCommandRecorder final
+    {
+    private:
+        struct ThreadFrameResource
+        {
+            VkCommandPool pool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> commandBuffers;
+            uint32_t usedCount = 0;
+        };
+        // Indexed by [frame][thread]
+        std::vector<std::vector<ThreadFrameResource>> m_frameResources;
+        uint32_t m_threadCount = 1;
+        uint32_t m_frameIndex = 0;
+
+        VkCommandBufferInheritanceInfo m_inheritanceInfo{};
+        VkCommandBufferInheritanceRenderingInfo m_renderingInfo{};
+        std::vector<VkFormat> m_colorFormats;
+        VkViewport m_viewport{};
+        VkRect2D m_scissor{};
+
+    private:
+        // Begin secondary command buffer from pool of thread, viewport and scissor already set
+        VkCommandBuffer beginCommandBuffer(uint32_t threadIndex);
+
+    public:
+        // Zero thread count uses job system concurrency
+        void init(uint32_t threadCount = 0);
+
+        void release();
+
+        // Reset pools of this frame, all secondary command buffers continue rendering with the given attachment formats
+        void beginFrame(uint32_t frameIndex, const std::vector<VkFormat> &colorFormats, VkFormat depthFormat, VkFormat stencilFormat,
+                        const VkViewport &viewport, const VkRect2D &scissor);
+
+        // Record on calling thread into one secondary command buffer
+        VkCommandBuffer record(const std::function<void(VkCommandBuffer cmd)> &func);
+
+        // Split draw items [0, itemCount) into chunks recorded as jobs, command buffers are appended in chunk order
+        void recordParallel(uint32_t itemCount, const std::function<void(VkCommandBuffer cmd, uint32_t beginItem, uint32_t endItem)> &func,
+                            std::vector<VkCommandBuffer> &outCommandBuffers);
+
+        [[nodiscard]] uint32_t getThreadCount() const { return m_threadCount; }
+    };
+}
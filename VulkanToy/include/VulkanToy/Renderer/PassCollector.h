@@ -3,7 +3,9 @@
 //
 
 #include <VulkanToy/Core/RuntimeModule.h>
+#include <VulkanToy/Renderer/PassCommon.h>
 #include <VulkanToy/Renderer/PreprocessPass.h>
+#include <VulkanToy/Renderer/CullingPass.h>
 
 namespace VT
 {
@@ -16,15 +18,18 @@ namespace VT
 
     private:
         void setupDescriptorLayout();
-        void setupPipeline(VkRenderPass renderPass);
+        void setupPipeline(const PassAttachmentFormats &formats);
 
     public:
-        void init(VkRenderPass renderPass);
+        void init(const PassAttachmentFormats &formats);
 
         void release();
 
         void onRenderTick(VkCommandBuffer cmd);
 
+        // Clear depth and fill scene color
+        void addToRenderGraph(RenderGraph &graph, PassFrameResources &resources);
+
         [[nodiscard]] const VkPipeline& getPipeline() const { return skyboxPipeline; }
         [[nodiscard]] const VkPipelineLayout& getPipelineLayout() const { return skyboxPipelineLayout; }
     };
@@ -33,21 +38,34 @@ namespace VT
     {
     private:
         VkPipeline pbrPipeline = VK_NULL_HANDLE;
+        VkPipeline pbrCompactPipeline = VK_NULL_HANDLE;
         VkPipelineLayout pbrPipelineLayout = VK_NULL_HANDLE;
+        // Scene set, GSceneDescriptorSetIndex
         VkDescriptorSetLayout pbrDescriptorSetLayout = VK_NULL_HANDLE;
+        // Per frame instance buffer, set GInstanceDescriptorSetIndex
+        VkDescriptorSetLayout pbrInstanceDescriptorSetLayout = VK_NULL_HANDLE;
+        // Bindless heap layout at GBindlessDescriptorSetIndex is owned by vulkan context
+        PassAttachmentFormats pbrAttachmentFormats{};
 
     private:
         void setupDescriptorLayout();
-        void setupPipeline(VkRenderPass renderPass);
+        void setupPipeline(const PassAttachmentFormats &formats);
 
     public:
-        void init(VkRenderPass renderPass);
+        void init(const PassAttachmentFormats &formats);
 
         void release();
 
         void onRenderTick(VkCommandBuffer cmd);
 
+        // Draw a range of scene draw items, safe to call from several threads with different command buffers
+        void onRenderTick(VkCommandBuffer cmd, uint32_t beginItem, uint32_t endItem);
+
+        // Draw scene over skybox, draw items are split across threads when frame has a command recorder
+        void addToRenderGraph(RenderGraph &graph, PassFrameResources &resources);
+
         [[nodiscard]] const VkPipeline& getPipeline() const { return pbrPipeline; }
+        [[nodiscard]] const VkPipeline& getCompactPipeline() const { return pbrCompactPipeline; }
         [[nodiscard]] const VkPipelineLayout& getPipelineLayout() const { return pbrPipelineLayout; }
     };
 
@@ -57,26 +75,26 @@ namespace VT
         VkPipeline tonemapPipeline = VK_NULL_HANDLE;
         VkPipelineLayout tonemapPipelineLayout = VK_NULL_HANDLE;
         VkDescriptorSetLayout tonemapDescriptorSetLayout = VK_NULL_HANDLE;
-        std::vector<VkDescriptorSet> tonemapDescriptorSets;
 
     private:
-        void setupDescriptor(const std::vector<VkDescriptorImageInfo> &descriptors);
-        void setupPipeline(VkRenderPass renderPass);
+        void setupDescriptor();
+        void setupPipeline(const PassAttachmentFormats &formats);
 
     public:
-        void init(VkRenderPass renderPass, const std::vector<VkDescriptorImageInfo> &descriptors);
+        void init(const PassAttachmentFormats &formats);
 
         void release();
 
-        // Update descriptor sets if swap chain rebuilt
-        void updateDescriptorSets(const std::vector<VkDescriptorImageInfo> &descriptors);
+        // Scene color may be a different aliased image every frame, a transient descriptor set is written before drawing
+        void onRenderTick(VkCommandBuffer cmd, uint32_t frameIndex, VkImageView sceneColorView);
 
-        void onRenderTick(VkCommandBuffer cmd);
+        // Tone map scene color into swap chain image
+        void addToRenderGraph(RenderGraph &graph, PassFrameResources &resources);
 
         [[nodiscard]] const VkPipeline& getPipeline() const { return tonemapPipeline; }
         [[nodiscard]] const VkPipelineLayout& getPipelineLayout() const { return tonemapPipelineLayout; }
     };
 
-    using PassInterface = std::variant<Ref<PreprocessPass>, Ref<SkyboxPass>, Ref<PBRPass>, Ref<TonemapPass>>;
+    using PassInterface = std::variant<Ref<PreprocessPass>, Ref<CullingPass>, Ref<SkyboxPass>, Ref<PBRPass>, Ref<TonemapPass>>;
     using PassCollector = std::vector<PassInterface>;
 }
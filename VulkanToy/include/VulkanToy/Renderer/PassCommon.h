@@ -0,0 +1,41 @@
+//
+// Created by ZHIKANG on 2023/4/19.
+//
+
+#pragma once
+
+#include <VulkanToy/Renderer/RenderGraph.h>
+
+namespace VT
+{
+    class ParallelCommandRecorder;
+
+    // Attachment formats pipelines are created for, passes render with dynamic rendering
+    struct PassAttachmentFormats
+    {
+        VkFormat sceneColorFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+        VkFormat sceneDepthFormat = VK_FORMAT_UNDEFINED;
+        // Same as depth format when it has stencil aspect
+        VkFormat sceneStencilFormat = VK_FORMAT_UNDEFINED;
+        VkFormat swapChainFormat = VK_FORMAT_UNDEFINED;
+    };
+
+    // Graph resources of one frame, earlier passes fill handles later passes consume
+    struct PassFrameResources
+    {
+        uint32_t frameIndex = 0;
+        // Acquired swap chain image, differs from frame slot
+        uint32_t imageIndex = 0;
+
+        RenderGraphHandle swapChain{};
+        RenderGraphHandle sceneColor{};
+        RenderGraphHandle sceneDepth{};
+
+        // Invalid when scene has no instanced draws
+        RenderGraphHandle instanceIndirectBuffer{};
+        RenderGraphHandle instanceVisibleBuffer{};
+
+        // Main pass records into secondary command buffers on several threads when set
+        ParallelCommandRecorder *commandRecorder = nullptr;
+    };
+}
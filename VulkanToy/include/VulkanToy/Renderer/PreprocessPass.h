@@ -5,6 +5,7 @@
 #pragma once
 
 #include <VulkanToy/VulkanRHI/GPUResource.h>
+#include <VulkanToy/Renderer/PassCommon.h>
 
 namespace VT
 {
@@ -34,7 +35,7 @@ namespace VT
         void preprocessEnvMap();
 
     public:
-        void init(VkRenderPass renderPass);
+        void init(const PassAttachmentFormats &formats);
 
         void release();
     };
@@ -0,0 +1,223 @@
+//
+// Created by ZHIKANG on 2023/4/19.
+//
+
+#pragma once
+
+#include <VulkanToy/VulkanRHI/VulkanRHICommon.h>
+
+namespace VT
+{
+    // Resource declared in current graph, valid until next reset
+    struct RenderGraphHandle
+    {
+        uint32_t index = std::numeric_limits<uint32_t>::max();
+
+        [[nodiscard]] bool isValid() const { return index != std::numeric_limits<uint32_t>::max(); }
+    };
+
+    // How a pass uses a resource, decides pipeline stage, access mask and image layout
+    enum class RenderGraphAccess : uint8_t
+    {
+        ColorAttachment = 0,
+        DepthAttachment,
+        FragmentSampled,
+        ComputeSampled,
+        VertexStorageRead,
+        FragmentStorageRead,
+        ComputeStorageRead,
+        ComputeStorageWrite,
+        IndirectRead,
+        TransferRead,
+        TransferWrite,
+        Present
+    };
+
+    struct RenderGraphImageDesc
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+
+        auto operator<=>(const RenderGraphImageDesc&) const = default;
+    };
+
+    // Attachment of graphics pass, store op is chosen by graph from later uses
+    struct RenderGraphAttachment
+    {
+        RenderGraphHandle handle{};
+        VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        VkClearValue clearValue{};
+    };
+
+    class RenderGraph;
+
+    using RenderGraphExecuteFunc = std::function<void(VkCommandBuffer cmd, const RenderGraph &graph)>;
+
+    // Declare resource uses of one pass inside its setup callback
+    class RenderGraphPassBuilder final
+    {
+    private:
+        RenderGraph &m_graph;
+        uint32_t m_passIndex;
+
+    public:
+        RenderGraphPassBuilder(RenderGraph &graph, uint32_t passIndex)
+            : m_graph(graph), m_passIndex(passIndex) {}
+
+        void read(RenderGraphHandle handle, RenderGraphAccess access);
+        void write(RenderGraphHandle handle, RenderGraphAccess access);
+
+        // Passes with attachments are wrapped in dynamic rendering by graph, viewport and scissor cover render area
+        void colorAttachment(RenderGraphHandle handle, VkAttachmentLoadOp loadOp, VkClearValue clearValue = {});
+        void depthAttachment(RenderGraphHandle handle, VkAttachmentLoadOp loadOp, VkClearValue clearValue = {});
+
+        // Draws are recorded into secondary command buffers, primary only executes them
+        void setSecondaryCommandBuffers();
+
+        // Keep pass even if nothing reads its outputs
+        void setSideEffect();
+    };
+
+    // Frame graph rebuilt every frame: passes declare reads and writes of named images and buffers,
+    // compile orders them, culls unused ones, aliases transient images and plans barriers
+    // Transient images are cached per frame slot and reused while graph keeps the same shape
+    class RenderGraph final
+    {
+        friend class RenderGraphPassBuilder;
+
+    private:
+        struct Resource
+        {
+            std::string name{};
+            bool isImage = false;
+            bool isImported = false;
+
+            RenderGraphImageDesc desc{};
+            VkImageUsageFlags usage = 0;
+            VkImageAspectFlags aspect = 0;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+            VkBuffer buffer = VK_NULL_HANDLE;
+
+            // State before first pass and after last pass of imported resource
+            VkPipelineStageFlags2 initialStage = VK_PIPELINE_STAGE_2_NONE;
+            VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            bool hasFinalAccess = false;
+            RenderGraphAccess finalAccess = RenderGraphAccess::Present;
+
+            // Execution order range of alive passes using it
+            uint32_t firstUse = std::numeric_limits<uint32_t>::max();
+            uint32_t lastUse = 0;
+            // Memory block of transient image and previous image living in it
+            uint32_t block = std::numeric_limits<uint32_t>::max();
+            uint32_t aliasPredecessor = std::numeric_limits<uint32_t>::max();
+        };
+
+        struct ResourceUse
+        {
+            uint32_t resource = 0;
+            RenderGraphAccess access = RenderGraphAccess::ColorAttachment;
+            bool isWrite = false;
+            // Previous contents are needed, false for cleared or discarded attachments
+            bool preserve = true;
+        };
+
+        struct Pass
+        {
+            std::string name{};
+            std::vector<ResourceUse> uses;
+            std::vector<RenderGraphAttachment> colorAttachments;
+            RenderGraphAttachment depthAttachment{};
+            bool secondaryCommandBuffers = false;
+            bool sideEffect = false;
+            bool isAlive = false;
+            RenderGraphExecuteFunc execute;
+
+            // Planned by compile
+            std::vector<VkImageMemoryBarrier2> imageBarriers;
+            VkMemoryBarrier2 memoryBarrier{};
+        };
+
+        struct TransientImage
+        {
+            RenderGraphImageDesc desc{};
+            VkImageUsageFlags usage = 0;
+            uint32_t block = 0;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+        };
+
+        // Transient images of one frame slot, rebuilt when graph shape changes
+        struct FrameTransients
+        {
+            std::vector<TransientImage> images;
+            std::vector<VmaAllocation> blocks;
+
+            void release();
+        };
+
+        std::vector<Resource> m_resources;
+        std::vector<Pass> m_passes;
+        std::vector<uint32_t> m_executionOrder;
+        std::vector<VkImageMemoryBarrier2> m_finalImageBarriers;
+        VkMemoryBarrier2 m_finalMemoryBarrier{};
+
+        std::vector<FrameTransients> m_frameTransients;
+        uint32_t m_frameIndex = 0;
+        bool m_compiled = false;
+
+        // Statistics of last compile
+        uint32_t m_culledPassCount = 0;
+        VkDeviceSize m_transientMemorySize = 0;
+        VkDeviceSize m_aliasedMemorySize = 0;
+
+    private:
+        void addUse(uint32_t passIndex, RenderGraphHandle handle, RenderGraphAccess access, bool isWrite, bool preserve);
+
+        // Execution order is declaration order of alive passes, every read binds to latest earlier write
+        void cullPasses();
+        void computeLifetimes();
+        void aliasTransients(std::vector<VkMemoryRequirements> &outBlockRequirements);
+        void realizeTransients(const std::vector<VkMemoryRequirements> &blockRequirements);
+        void planBarriers();
+
+        [[nodiscard]] const Resource& getResource(RenderGraphHandle handle) const;
+
+    public:
+        void release();
+
+        // Release cached transient images, device must be idle
+        void releaseTransients();
+
+        // Drop all passes and resources of previous frame, transient images of frame index may be reused
+        void reset(uint32_t frameIndex);
+
+        RenderGraphHandle createImage(const std::string &name, const RenderGraphImageDesc &desc);
+
+        // External image, initial stage is waited on before first use, final access is applied after last pass
+        RenderGraphHandle importImage(const std::string &name, VkImage image, VkImageView view, const RenderGraphImageDesc &desc,
+                                    VkImageLayout initialLayout, VkPipelineStageFlags2 initialStage,
+                                    std::optional<RenderGraphAccess> finalAccess = std::nullopt);
+
+        RenderGraphHandle importBuffer(const std::string &name, VkBuffer buffer);
+
+        void addPass(const std::string &name, const std::function<void(RenderGraphPassBuilder &builder)> &setup,
+                    RenderGraphExecuteFunc &&execute);
+
+        void compile();
+
+        void execute(VkCommandBuffer cmd);
+
+        [[nodiscard]] VkImage getImage(RenderGraphHandle handle) const { return getResource(handle).image; }
+        [[nodiscard]] VkImageView getImageView(RenderGraphHandle handle) const { return getResource(handle).view; }
+        [[nodiscard]] VkBuffer getBuffer(RenderGraphHandle handle) const { return getResource(handle).buffer; }
+        [[nodiscard]] const RenderGraphImageDesc& getImageDesc(RenderGraphHandle handle) const { return getResource(handle).desc; }
+
+        [[nodiscard]] uint32_t getPassCount() const { return static_cast<uint32_t>(m_passes.size()); }
+        [[nodiscard]] uint32_t getCulledPassCount() const { return m_culledPassCount; }
+        // Sum of transient image sizes and memory actually allocated for them
+        [[nodiscard]] VkDeviceSize getTransientMemorySize() const { return m_transientMemorySize; }
+        [[nodiscard]] VkDeviceSize getAliasedMemorySize() const { return m_aliasedMemorySize; }
+    };
+}
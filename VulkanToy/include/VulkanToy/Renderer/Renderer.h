@@ -7,30 +7,35 @@
 #include <VulkanToy/Core/RuntimeModule.h>
 #include <VulkanToy/VulkanRHI/GPUResource.h>
 #include <VulkanToy/Renderer/PassCollector.h>
+#include <VulkanToy/Renderer/RenderGraph.h>
+#include <VulkanToy/Renderer/ParallelCommandRecorder.h>
+#include <VulkanToy/Renderer/ImGuiPass.h>
 
 namespace VT
 {
-    struct RenderTarget
+    class Renderer final
     {
-        Ref<VulkanImage> colorImage = nullptr;
-        Ref<VulkanImage> depthImage = nullptr;
-        VkFormat colorFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
-        VkFormat depthFormat = VK_FORMAT_D24_UNORM_S8_UINT;
-        uint32_t width;
-        uint32_t height;
+    private:
+        PassCollector m_passCollector{};
+        PassAttachmentFormats m_attachmentFormats{};
 
-        void release();
+        // Rebuilt every frame from passes, transient images are cached inside
+        RenderGraph m_renderGraph{};
 
-        static RenderTarget create(uint32_t width, uint32_t height, uint32_t samples, VkFormat colorFormat, VkFormat depthFormat);
-    };
+        // Main pass is recorded into secondary command buffers on several threads when enabled
+        // Draw lists too short for two chunks are still recorded serially into the primary command buffer
+        ParallelCommandRecorder m_commandRecorder{};
+        bool m_parallelRecording = true;
+
+        // Debug UI drawn over tone mapped swap chain image, last pass of graph
+        ImGuiPass m_imGuiPass{};
 
-    class Renderer final
-    {
     private:
-        VkRenderPass m_renderPass = VK_NULL_HANDLE;
-        std::vector<RenderTarget> m_renderTargets;
-        std::vector<VkFramebuffer> m_frameBuffers;
-        PassCollector m_passCollector{};
+        // Declare frame resources and let every pass add itself
+        void buildRenderGraph(uint32_t frameIndex, uint32_t imageIndex);
+
+        // Build ImGui draw data of this frame
+        void drawUI();
 
     public:
         Renderer();
@@ -40,12 +45,13 @@ namespace VT
 
         void tick(const RuntimeModuleTickData &tickData);
 
-        void rebuildRenderTargetsAndFramebuffers();
+        void setParallelRecording(bool enable) { m_parallelRecording = enable; }
+
+        [[nodiscard]] bool isParallelRecording() const { return m_parallelRecording; }
+
+        [[nodiscard]] const RenderGraph& getRenderGraph() const { return m_renderGraph; }
 
     private:
-        void setupRenderTargets();
-        void setupRenderPass();
-        void setupFrameBuffers();
         void setupPipelines();
     };
 
@@ -26,6 +26,7 @@ namespace VT
         void setDistance(float distance) { m_distance = distance; }
 
         void setViewportSize(float width, float height) { m_viewportWidth = width; m_viewportHeight = height; updateProjection(); }
+        [[nodiscard]] float getViewportHeight() const { return m_viewportHeight; }
 
         [[nodiscard]] const glm::mat4& getViewMatrix() const { return m_viewMatrix; }
         [[nodiscard]] glm::mat4 getViewProjection() const { return m_projection * m_viewMatrix; }
@@ -5,9 +5,20 @@
 #pragma once
 
 #include <VulkanToy/Core/RuntimeModule.h>
+#include <VulkanToy/AssetSystem/MeshMisc.h>
 
 namespace VT
 {
+    // Components with equal key share one instanced draw, material is fetched per instance from bindless heap
+    struct InstanceBatchKey
+    {
+        uintptr_t mesh = 0;
+        uint32_t lodIndex = 0;
+        VertexFormat vertexFormat = VertexFormat::Standard;
+
+        auto operator<=>(const InstanceBatchKey &) const = default;
+    };
+
     struct Component
     {
         virtual void init() {}
@@ -15,5 +26,19 @@ namespace VT
         virtual void setupDescriptors() {}
         virtual void tick(const RuntimeModuleTickData &tickData) {};
         virtual void onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout) {}
+        // Pipeline vertex layout this component draws with
+        virtual VertexFormat getVertexFormat() const { return VertexFormat::Standard; }
+        // World space bound for culling, false keeps component always visible
+        virtual bool getWorldBound(StaticMeshRenderBound &outBound) const { return false; }
+
+        // Instanced drawing, false draws component alone through onRenderTick
+        virtual bool getInstanceBatchKey(InstanceBatchKey &outKey) const { return false; }
+        virtual void getInstanceData(StaticMeshInstanceData &outData) const {}
+        // Bump whenever instance data or world bound changes, instance table only rewrites bumped instances
+        virtual uint32_t getInstanceRevision() const { return 0; }
+        // Index range of batch, instance count and first instance are filled by GPU culling
+        virtual void getInstanceDrawCommand(VkDrawIndexedIndirectCommand &outCommand) const {}
+        // Bind resources shared by batch, draw is issued by instance batcher
+        virtual void bindInstanceResources(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout) {}
     };
 }
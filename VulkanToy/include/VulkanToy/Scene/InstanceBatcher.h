@@ -0,0 +1,117 @@
+//
+// Created by ZHIKANG on 2023/4/17.
+//
+
+#pragma once
+
+#include <VulkanToy/Scene/Component.h>
+#include <VulkanToy/VulkanRHI/GPUResource.h>
+
+namespace VT
+{
+    // Descriptor set indices in mesh pipelines: scene uniforms and IBL maps, instance buffers, bindless heap
+    constexpr uint32_t GSceneDescriptorSetIndex = 0;
+    constexpr uint32_t GInstanceDescriptorSetIndex = 1;
+    constexpr uint32_t GBindlessDescriptorSetIndex = 2;
+    // Instance buffers start with this capacity and double when exceeded
+    constexpr uint32_t GMinInstanceCapacity = 1024;
+    constexpr uint32_t GMinBatchCapacity = 64;
+    // Work group size of GPUCulling.comp
+    constexpr uint32_t GCullingWorkGroupSize = 64;
+
+    struct InstanceBatch
+    {
+        // Component binding resources shared by the batch
+        uint32_t componentIndex = 0;
+        uint32_t firstInstance = 0;
+        uint32_t instanceCount = 0;
+        VertexFormat vertexFormat = VertexFormat::Standard;
+    };
+
+    // Frustum planes and instance count, GPUCulling.comp push constants
+    struct GPUCullingPushConstants
+    {
+        std::array<glm::vec4, 6> planes{};
+        uint32_t instanceCount = 0;
+    };
+
+    // Group ready components by mesh and LOD, one indirect draw per group
+    // Instance data lives in storage buffers per frame slot, reused once that slot is acquired again
+    // Table is persistent, a slot is rewritten whole only when grouping changes, otherwise just instances
+    // whose component revision or CPU visibility moved since that slot was last written
+    // GPU culling writes visible instance indices and instance count of every indirect command
+    class InstanceBatcher
+    {
+    private:
+        struct FrameResource
+        {
+            // Host written, model matrices and culling data in sorted instance order
+            Ref<VulkanBuffer> instanceBuffer = nullptr;
+            Ref<VulkanBuffer> cullBuffer = nullptr;
+            // Host written with zero instance count, GPU culling counts visible instances
+            Ref<VulkanBuffer> indirectBuffer = nullptr;
+            // GPU written, instance index per visible slot, read by vertex shader through gl_InstanceIndex
+            Ref<VulkanBuffer> visibleBuffer = nullptr;
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+            uint32_t instanceCapacity = 0;
+            uint32_t batchCapacity = 0;
+            // Sorted items and instance stamps last written into this slot
+            std::vector<std::pair<InstanceBatchKey, uint32_t>> writtenItems;
+            std::vector<uint64_t> writtenStamps;
+
+            void release();
+        };
+        std::vector<FrameResource> m_frameResources;
+        uint32_t m_frameIndex = 0;
+
+        std::vector<std::pair<InstanceBatchKey, uint32_t>> m_sortItems;
+        std::vector<InstanceBatch> m_batches;
+        // Batch of every sorted instance, lets instance data be written in parallel
+        std::vector<uint32_t> m_instanceBatchIndices;
+        // Components without batch key, drawn one by one
+        std::vector<uint32_t> m_singleComponents;
+        // Component revision and CPU visibility per sorted instance, compared with written stamps of a slot
+        std::vector<uint64_t> m_instanceStamps;
+        std::vector<uint32_t> m_dirtyInstances;
+        std::vector<uint8_t> m_componentVisible;
+
+    private:
+        void reserve(FrameResource &frameResource, uint32_t instanceCount, uint32_t batchCount);
+
+    public:
+        // Bindings of instance descriptor set, shared by mesh pipelines and GPU culling pipeline
+        static std::vector<VkDescriptorSetLayoutBinding> getDescriptorSetLayoutBindings();
+
+        void release();
+
+        // Group ready components and write changed instances into this frame's slot
+        // Components missing from visibleComponents stay in their batch but are culled before GPU culling
+        void build(const std::vector<Ref<Component>> &components, const std::vector<uint32_t> &visibleComponents, uint32_t frameIndex);
+
+        // Record GPU culling of this frame, must be outside of rendering, pipeline is bound by caller
+        // Render graph orders culling writes before indirect draws and vertex reads
+        void cull(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, const std::array<glm::vec4, 6> &planes) const;
+
+        // Bind instance buffers of this frame and draw items matching vertex format
+        // Draw items are batches followed by single components, ranges may be recorded on different threads
+        void draw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, VertexFormat vertexFormat,
+                const std::vector<Ref<Component>> &components,
+                uint32_t beginItem = 0, uint32_t endItem = std::numeric_limits<uint32_t>::max()) const;
+
+        [[nodiscard]] uint32_t getDrawItemCount() const { return static_cast<uint32_t>(m_batches.size() + m_singleComponents.size()); }
+        [[nodiscard]] uint32_t getBatchCount() const { return static_cast<uint32_t>(m_batches.size()); }
+        [[nodiscard]] uint32_t getInstanceCount() const { return static_cast<uint32_t>(m_sortItems.size()); }
+
+        // Buffers of current frame written by GPU culling, null before first build
+        [[nodiscard]] VkBuffer getIndirectBuffer() const
+        {
+            return m_frameIndex < m_frameResources.size() && m_frameResources[m_frameIndex].indirectBuffer ?
+                m_frameResources[m_frameIndex].indirectBuffer->getBuffer() : VK_NULL_HANDLE;
+        }
+        [[nodiscard]] VkBuffer getVisibleBuffer() const
+        {
+            return m_frameIndex < m_frameResources.size() && m_frameResources[m_frameIndex].visibleBuffer ?
+                m_frameResources[m_frameIndex].visibleBuffer->getBuffer() : VK_NULL_HANDLE;
+        }
+    };
+}
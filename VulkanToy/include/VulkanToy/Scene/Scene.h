@@ -5,11 +5,16 @@
 #pragma once
 
 #include <VulkanToy/Scene/Component.h>
+#include <VulkanToy/Scene/InstanceBatcher.h>
 #include <VulkanToy/Scene/Skybox.h>
+#include <VulkanToy/Renderer/FrustumCuller.h>
 #include <VulkanToy/VulkanRHI/GPUResource.h>
 
 namespace VT
 {
+    // Components per tick job, component tick is cheap so jobs stay coarse
+    constexpr uint32_t GComponentTickGrainSize = 32;
+
     struct CameraParameters
     {
         alignas(16) glm::mat4 projection{};
@@ -22,12 +27,32 @@ namespace VT
     private:
         Ref<Skybox> m_skybox;
         std::vector<Ref<Component>> m_components;
-        Ref<VulkanBuffer> m_uniformBuffer;
+        // Camera uniforms and IBL maps shared by every mesh draw, GSceneDescriptorSetIndex
+        // Camera uniforms are a dynamic buffer over frame linear allocator
+        VkDescriptorSet m_sceneDescriptorSet = VK_NULL_HANDLE;
 
         CameraParameters m_cameraParas{};
+        // Dynamic offset of this frame's camera uniforms, scene draws are skipped when they fail to allocate
+        uint32_t m_cameraUniformOffset = 0;
+        bool m_hasFrameUniforms = false;
+
+        // Component bounds and visible component indices, refreshed every tick
+        Frustum m_frustum{};
+        CullingBoundsTable m_cullingBounds{};
+        std::vector<uint32_t> m_visibleComponents{};
+        // Compute pass culls every instance; when off, SIMD CPU culling marks hidden instances first
+        // and compute pass only tests the rest, see EngineSettings::cpuCulling
+        bool m_gpuCulling = true;
+
+        // Persistent instance table, only instances of changed components are rewritten
+        InstanceBatcher m_instanceBatcher{};
 
     private:
-        void updateUniformBuffer();
+        void updateCameraParameters();
+
+        void setupSceneDescriptors();
+
+        void cullComponents();
 
     public:
         Scene() = default;
@@ -38,9 +63,28 @@ namespace VT
 
         void addComponent(const Ref<Component> &component);
 
+        // Components tick in parallel, so component tick must only touch its own state
         void tick(const RuntimeModuleTickData &tickData);
 
-        void onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout);
+        // Write camera uniforms of this frame into frame allocator, call once per frame after image acquire
+        void prepareFrameUniforms();
+
+        // Update instance table and indirect draws of this frame slot, call once per frame before onRenderTick
+        void prepareDrawBatches(uint32_t frameIndex);
+
+        void setGPUCulling(bool enable) { m_gpuCulling = enable; }
+
+        [[nodiscard]] bool isGPUCulling() const { return m_gpuCulling; }
+
+        // Bind scene set and bindless heap once, draws of any vertex format after it reuse them
+        void bindSceneDescriptors(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout) const;
+
+        // Draw visible components matching the vertex format of bound pipeline
+        void onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, VertexFormat vertexFormat);
+
+        // Draw a range of draw items, see InstanceBatcher::draw
+        void onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, VertexFormat vertexFormat,
+                        uint32_t beginItem, uint32_t endItem);
 
         void onRenderTickSkybox(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout);
 
@@ -49,9 +93,29 @@ namespace VT
             return m_components;
         }
 
-        [[nodiscard]] Ref<VulkanBuffer> getUniformBuffer() const
+        [[nodiscard]] const std::vector<uint32_t>& getVisibleComponents() const
+        {
+            return m_visibleComponents;
+        }
+
+        [[nodiscard]] const Frustum& getFrustum() const
+        {
+            return m_frustum;
+        }
+
+        [[nodiscard]] const InstanceBatcher& getInstanceBatcher() const
+        {
+            return m_instanceBatcher;
+        }
+
+        [[nodiscard]] bool hasFrameUniforms() const
+        {
+            return m_hasFrameUniforms;
+        }
+
+        [[nodiscard]] uint32_t getCameraUniformOffset() const
         {
-            return m_uniformBuffer;
+            return m_cameraUniformOffset;
         }
     };
 
@@ -27,7 +27,8 @@ namespace VT
         void init();
         void release();
         void tick(const RuntimeModuleTickData &tickData);
-        void onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout);
+        // Camera uniforms are bound at dynamic offset of this frame
+        void onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t cameraUniformOffset);
 
         void setupDescriptors();
     };
@@ -7,6 +7,7 @@
 #include <VulkanToy/Scene/Component.h>
 #include <VulkanToy/AssetSystem/MaterialManager.h>
 #include <VulkanToy/AssetSystem/MeshManager.h>
+#include <VulkanToy/AssetSystem/TextureManager.h>
 
 namespace VT
 {
@@ -16,8 +17,8 @@ namespace VT
         Ref<GPUMeshAsset> cacheGPUMeshAsset = nullptr;
         // Material is optional, if no exist, store mesh info in GPU mesh asset directly
         Ref<StandardPBRMaterial> cacheMaterialAsset = nullptr;
-        // Descriptor set
-        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        // Cache texture assets, check async upload state before drawing
+        std::vector<Ref<GPUImageAsset>> cacheTextureAssets;
 
         // Asset uuid
         UUID staticMeshUUID{};
@@ -32,6 +33,14 @@ namespace VT
         // Mesh already replace
         bool isMeshReplace = true;
 
+        // LOD drawn this frame, selected on tick
+        uint32_t lodIndex = 0;
+
+        // Bumped on transform or material change, transform is compared on tick
+        uint32_t instanceRevision = 0;
+        glm::vec3 revisionTranslation{ 0.0f, 0.0f, 0.0f };
+        glm::vec3 revisionScale{ 1.0f, 1.0f, 1.0f };
+
         StaticMeshComponent() = default;
         StaticMeshComponent(const UUID &in);
 
@@ -39,14 +48,31 @@ namespace VT
 
         void loadAssetByUUID();
 
-        void setupDescriptors() override;
+        // Write material into bindless heap, texture slots are valid once uploads finish
+        void registerMaterial();
 
         void tick(const RuntimeModuleTickData &tickData) override;
 
-        void onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout) override;
+        // Ready meshes batch by mesh and LOD, nothing is drawn before ready
+        bool getInstanceBatchKey(InstanceBatchKey &outKey) const override;
+
+        void getInstanceData(StaticMeshInstanceData &outData) const override;
+
+        uint32_t getInstanceRevision() const override { return instanceRevision; }
+
+        void getInstanceDrawCommand(VkDrawIndexedIndirectCommand &outCommand) const override;
+
+        void bindInstanceResources(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout) override;
+
+        VertexFormat getVertexFormat() const override;
+
+        bool getWorldBound(StaticMeshRenderBound &outBound) const override;
 
         void updateObjectCollectInfo(const RuntimeModuleTickData &tickData);
 
+        // Pick coarsest LOD whose error projects under GMeshLodPixelError, by bound sphere distance to camera
+        void selectLod();
+
         void release() override;
     };
 }
@@ -0,0 +1,94 @@
+//
+// Created by ZHIKANG on 2023/4/20.
+//
+
+#pragma once
+
+#include <VulkanToy/VulkanRHI/GPUResource.h>
+
+namespace VT
+{
+    // Slot counts of global bindless set, clamped to device update-after-bind limits
+    constexpr uint32_t GBindlessMaxSampledImages = 4096;
+    constexpr uint32_t GBindlessMaxStorageBuffers = 4096;
+    constexpr uint32_t GBindlessMaxMaterials = 4096;
+    constexpr uint32_t GBindlessInvalidIndex = std::numeric_limits<uint32_t>::max();
+    // Reserved on init and never freed, materials that fail to register fall back to it
+    constexpr uint32_t GBindlessDefaultMaterialIndex = 0;
+
+    // Bindings of global bindless set, shaders declare the same
+    constexpr uint32_t GBindlessSampledImageBinding = 0;
+    constexpr uint32_t GBindlessSamplerBinding = 1;
+    constexpr uint32_t GBindlessStorageBufferBinding = 2;
+    constexpr uint32_t GBindlessMaterialBinding = 3;
+
+    // Material entry in bindless material buffer, std430 layout, texture indices are sampled image slots
+    struct BindlessMaterialData
+    {
+        glm::vec4 baseColorFactor{ 1.0f };
+        uint32_t albedoIndex = GBindlessInvalidIndex;
+        uint32_t normalIndex = GBindlessInvalidIndex;
+        uint32_t roughnessIndex = GBindlessInvalidIndex;
+        uint32_t metallicIndex = GBindlessInvalidIndex;
+        float metallicFactor = 1.0f;
+        float roughnessFactor = 1.0f;
+        float alphaCutOff = 1.0f;
+        uint32_t padding = 0;
+    };
+
+    static_assert(sizeof(BindlessMaterialData) == 48);
+
+    // One update-after-bind descriptor set holding every sampled image, storage buffer and material
+    // Assets take a stable slot when upload finish and give it back on release, the set is bound once per pass
+    class BindlessHeap final
+    {
+    private:
+        // Free list of one binding, released slots are reused first
+        struct SlotAllocator
+        {
+            std::vector<uint32_t> freeSlots;
+            uint32_t nextSlot = 0;
+            uint32_t capacity = 0;
+
+            uint32_t allocate(const char *bindingName);
+            void free(uint32_t slot);
+        };
+
+        VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+        VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+        // Immutable sampler shared by material textures
+        VkSampler m_sampler = VK_NULL_HANDLE;
+
+        // Host visible, written when material registers or changes
+        Ref<VulkanBuffer> m_materialBuffer = nullptr;
+
+        SlotAllocator m_sampledImageSlots{};
+        SlotAllocator m_storageBufferSlots{};
+        SlotAllocator m_materialSlots{};
+
+        // Assets register from asset system and release from any thread dropping last reference
+        std::mutex m_mutex;
+
+    public:
+        void init(const VkPhysicalDeviceProperties &properties, const VkPhysicalDeviceDescriptorIndexingProperties &indexingProperties);
+
+        void release();
+
+        // Image view must stay in shader read only layout while registered
+        uint32_t registerSampledImage(VkImageView view);
+        void releaseSampledImage(uint32_t index);
+
+        uint32_t registerStorageBuffer(VkBuffer buffer, VkDeviceSize size = VK_WHOLE_SIZE);
+        void releaseStorageBuffer(uint32_t index);
+
+        // Invalid index when material table is full
+        uint32_t registerMaterial(const BindlessMaterialData &data);
+        // Default material is left untouched by update and release
+        void updateMaterial(uint32_t index, const BindlessMaterialData &data);
+        void releaseMaterial(uint32_t index);
+
+        [[nodiscard]] VkDescriptorSetLayout getDescriptorSetLayout() const { return m_descriptorSetLayout; }
+        [[nodiscard]] const VkDescriptorSet& getDescriptorSet() const { return m_descriptorSet; }
+    };
+}
@@ -0,0 +1,57 @@
+//
+// Created by ZHIKANG on 2023/4/21.
+//
+
+#pragma once
+
+#include <VulkanToy/VulkanRHI/VulkanRHICommon.h>
+
+namespace VT
+{
+    // Retired handles are destroyed once every frame that could reference them has finished on GPU
+    // Handles retired while a frame records wait for the timeline value that frame signals on submit
+    // Retire is safe from any thread, caller must stop recording new uses of the handle before retiring it
+    class DeletionQueue final
+    {
+    private:
+        struct Entry
+        {
+            uint64_t timelineValue = 0;
+            std::function<void()> destroy;
+        };
+
+        std::mutex m_mutex;
+        // Retired while current frame records, no timeline value yet
+        std::vector<std::function<void()>> m_pendingEntries;
+        // Ordered by timeline value, values only grow
+        std::deque<Entry> m_entries;
+        uint64_t m_completedValue = 0;
+
+    private:
+        // Destroy entries of completed frames outside lock, destroy callbacks may retire again
+        void collect();
+
+    public:
+        // Device must be idle
+        void release();
+
+        void retire(std::function<void()> &&destroy);
+
+        void retireBuffer(VkBuffer buffer, VmaAllocation allocation);
+        void retireBuffer(VkBuffer buffer, VkDeviceMemory memory);
+        void retireImage(VkImage image, VmaAllocation allocation);
+        void retireImage(VkImage image, VkDeviceMemory memory);
+        void retireImageView(VkImageView imageView);
+
+        // Frame being recorded is submitted and signals timeline value
+        void onFrameSubmitted(uint64_t timelineValue);
+
+        // Frame timeline has reached value, destroy what its frame and earlier frames retired
+        void onTimelineReached(uint64_t timelineValue);
+
+        // Every submitted frame has finished, e.g. after vkDeviceWaitIdle
+        void onDeviceIdle();
+
+        [[nodiscard]] size_t getPendingCount();
+    };
+}
@@ -0,0 +1,72 @@
+//
+// Created by ZHIKANG on 2023/4/20.
+//
+
+#pragma once
+
+#include <VulkanToy/VulkanRHI/GPUResource.h>
+
+namespace VT
+{
+    // Bytes of one frame region, uniforms and per draw data written by host every frame
+    constexpr VkDeviceSize GFrameAllocatorRegionSize = 4 * 1024 * 1024;
+
+    // Suballocation valid until the same frame index begins again
+    struct FrameAllocation
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        // From buffer start, pass as dynamic offset with descriptor of range size
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void *mapped = nullptr;
+
+        [[nodiscard]] bool isValid() const { return mapped != nullptr; }
+        [[nodiscard]] uint32_t getDynamicOffset() const { return static_cast<uint32_t>(offset); }
+    };
+
+    // Linear allocator over one persistent mapped buffer, split into one region per frame slot
+    // Region of a frame is rewound once the fence of its previous use signals, so host never overwrites data GPU still reads
+    // Allocation is lock free, command recording threads may allocate concurrently
+    class FrameLinearAllocator final
+    {
+    private:
+        Ref<VulkanBuffer> m_buffer = nullptr;
+        VkDeviceSize m_regionSize = 0;
+        VkDeviceSize m_alignment = 0;
+        uint32_t m_regionCount = 0;
+
+        uint32_t m_frameIndex = 0;
+        std::atomic<VkDeviceSize> m_regionOffset{ 0 };
+        VkDeviceSize m_peakUsedSize = 0;
+
+    public:
+        void init(const VkPhysicalDeviceProperties &properties, uint32_t frameCount, VkDeviceSize regionSize = GFrameAllocatorRegionSize);
+
+        void release();
+
+        // Call when GPU finished last frame with this slot
+        void beginFrame(uint32_t frameIndex);
+
+        // Aligned for uniform and storage buffer offsets, invalid allocation when region is full
+        FrameAllocation allocate(VkDeviceSize size);
+
+        template<typename T>
+        FrameAllocation upload(const T &data)
+        {
+            FrameAllocation allocation = allocate(sizeof(T));
+            if (allocation.isValid())
+            {
+                std::memcpy(allocation.mapped, &data, sizeof(T));
+            }
+            return allocation;
+        }
+
+        // Descriptor for dynamic uniform or storage buffer, range is the largest allocation bound through it
+        [[nodiscard]] VkDescriptorBufferInfo getDescriptorBufferInfo(VkDeviceSize range) const;
+
+        [[nodiscard]] VkBuffer getBuffer() const { return m_buffer->getBuffer(); }
+        [[nodiscard]] VkDeviceSize getRegionSize() const { return m_regionSize; }
+        [[nodiscard]] VkDeviceSize getUsedSize() const { return m_regionOffset.load(std::memory_order_relaxed); }
+        [[nodiscard]] VkDeviceSize getPeakUsedSize() const { return m_peakUsedSize; }
+    };
+}
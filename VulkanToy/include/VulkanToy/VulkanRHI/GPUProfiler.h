@@ -0,0 +1,105 @@
+//
+// Created by ZHIKANG on 2023/4/24.
+//
+
+#pragma once
+
+#include <VulkanToy/VulkanRHI/VulkanRHICommon.h>
+
+namespace VT
+{
+    // Timestamp zones one frame slot may record, later zones are skipped
+    constexpr uint32_t GMaxGPUProfilerZones = 64;
+    // Frames of one zone kept for rolling min, average and max
+    constexpr uint32_t GGPUProfilerHistorySize = 120;
+
+    struct GPUZoneTiming
+    {
+        std::string name;
+        uint32_t depth = 0;
+        float lastMs = 0.0f;
+        float minMs = 0.0f;
+        float avgMs = 0.0f;
+        float maxMs = 0.0f;
+    };
+
+    // Timestamp pairs around passes and dispatches, one query range per frame slot
+    // Results are read when the slot comes round again and its timeline value is reached, so readback never stalls
+    // Zones are recorded and read on render thread only
+    class GPUProfiler final
+    {
+    private:
+        struct Zone
+        {
+            std::string name;
+            uint32_t depth = 0;
+        };
+
+        struct FrameZones
+        {
+            std::array<Zone, GMaxGPUProfilerZones> zones;
+            uint32_t zoneCount = 0;
+            uint32_t openDepth = 0;
+        };
+
+        struct ZoneHistory
+        {
+            std::string name;
+            uint32_t depth = 0;
+            // Frame number and zone index of last sample, zone order of that frame is kept for display
+            uint64_t lastFrame = 0;
+            uint32_t lastOrder = 0;
+            std::array<float, GGPUProfilerHistorySize> samples{};
+            uint32_t sampleCount = 0;
+            uint32_t sampleOffset = 0;
+        };
+
+        VkQueryPool m_queryPool = VK_NULL_HANDLE;
+        bool m_isSupported = false;
+        // Nanoseconds per tick
+        float m_timestampPeriod = 1.0f;
+        uint64_t m_timestampMask = ~0ull;
+
+        std::vector<FrameZones> m_frames;
+        uint32_t m_frameIndex = 0;
+        uint64_t m_frameNumber = 0;
+
+        std::vector<ZoneHistory> m_histories;
+        std::unordered_map<std::string, uint32_t> m_historyIndices;
+
+    private:
+        [[nodiscard]] uint32_t getFirstQuery(uint32_t frameIndex) const { return frameIndex * GMaxGPUProfilerZones * 2; }
+
+        void readback(uint32_t frameIndex);
+
+    public:
+        // Timestamps need graphics queue support for timestamps and host query reset
+        void init(const VkPhysicalDeviceProperties &properties, const VkQueueFamilyProperties &queueFamilyProperties, uint32_t frameCount);
+
+        void release();
+
+        // Call when GPU finished last frame with this slot, reads its zones and reuses its queries
+        void beginFrame(uint32_t frameIndex);
+
+        // Returns zone index for endZone
+        uint32_t beginZone(VkCommandBuffer cmd, std::string_view name);
+        void endZone(VkCommandBuffer cmd, uint32_t zoneIndex);
+
+        // Zones seen within history window in recording order, parents before children
+        [[nodiscard]] std::vector<GPUZoneTiming> getZoneTimings() const;
+
+        [[nodiscard]] bool isSupported() const { return m_isSupported; }
+    };
+
+    // Timestamp zone around commands recorded into cmd within this scope
+    class GPUProfileScope final : public DisableCopy
+    {
+    private:
+        VkCommandBuffer m_cmd;
+        uint32_t m_zoneIndex;
+
+    public:
+        GPUProfileScope(VkCommandBuffer cmd, std::string_view name);
+        ~GPUProfileScope();
+    };
+}
@@ -32,6 +32,7 @@ namespace VT
         [[nodiscard]] VkDeviceSize getMemorySize() const { return m_size; }
         [[nodiscard]] const char* getName() const { return m_name.c_str(); }
         [[nodiscard]] bool isHeap() const { return m_isHeap; }
+        [[nodiscard]] void* getMapped() const { return m_mapped; }
 
         void setName(const std::string &newName);
 
@@ -114,6 +115,8 @@ namespace VT
 
         // Generate mipmap
         void generateMipmaps();
+        // Record mipmap generation, mip 0 must be in transfer src layout, whole chain ends in shader read layout
+        void generateMipmaps(VkCommandBuffer cmd);
 
         // For texture creation
         static Ref<VulkanImage> create(const char *name,
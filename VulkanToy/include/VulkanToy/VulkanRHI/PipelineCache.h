@@ -0,0 +1,48 @@
+//
+// Created by ZHIKANG on 2023/4/18.
+//
+
+#pragma once
+
+#include <VulkanToy/Core/Base.h>
+
+namespace VT
+{
+    constexpr const char *GPipelineCachePath = "../data/cache/PipelineCache.bin";
+
+    // Pipeline cache shared by all passes, loaded from disk on init and written back on release
+    // Cache data of other GPU or driver is discarded by header check
+    class PipelineCache final
+    {
+    private:
+        VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+        std::filesystem::path m_path{};
+
+        // Creation statistics, compare cold and warm launch
+        uint32_t m_pipelineCount = 0;
+        double m_totalCreateMilliseconds = 0.0;
+
+    private:
+        // Return true when data was written by this GPU and driver
+        static bool isCompatible(const std::vector<uint8_t> &data, const VkPhysicalDeviceProperties &properties);
+
+        void recordCreateTime(const char *name, std::chrono::steady_clock::time_point start);
+
+    public:
+        PipelineCache() = default;
+
+        void init(const VkPhysicalDeviceProperties &properties, const std::filesystem::path &path = GPipelineCachePath);
+        void release();
+
+        // Write cache data to disk, also called by release
+        bool save() const;
+
+        [[nodiscard]] VkPipelineCache get() const { return m_pipelineCache; }
+
+        VkPipeline createGraphicsPipeline(const VkGraphicsPipelineCreateInfo &createInfo, const char *name);
+        VkPipeline createComputePipeline(const VkComputePipelineCreateInfo &createInfo, const char *name);
+
+        [[nodiscard]] uint32_t getPipelineCount() const { return m_pipelineCount; }
+        [[nodiscard]] double getTotalCreateMilliseconds() const { return m_totalCreateMilliseconds; }
+    };
+}
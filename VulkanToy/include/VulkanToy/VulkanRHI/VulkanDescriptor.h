@@ -8,6 +8,21 @@
 
 namespace VT
 {
+    // Set usage of descriptor pools, transient peak is the most sets one frame used
+    struct DescriptorPoolStats
+    {
+        uint32_t poolCount = 0;
+        uint32_t allocatedSets = 0;
+        uint32_t maxSets = 0;
+
+        uint32_t transientPoolCount = 0;
+        uint32_t transientAllocatedSets = 0;
+        uint32_t transientMaxSets = 0;
+        uint32_t transientPeakSets = 0;
+    };
+
+    // Named chains of persistent pools plus transient pools per frame slot
+    // A full pool never fails allocation, next pool of chain is used or created
     class DescriptorPoolCache
     {
     public:
@@ -15,27 +30,119 @@ namespace VT
         void release();
         void reset();
 
+        // Persistent set, free it through freeSet
         VkDescriptorSet allocateSet(VkDescriptorSetLayout layout, const std::string &poolName = "MainPool");
+        void freeSet(VkDescriptorSet descriptorSet);
+
+        // Set lives until pools of frame are reset, never freed one by one
+        VkDescriptorSet allocateTransientSet(VkDescriptorSetLayout layout, uint32_t frameIndex);
+
+        // Call once GPU finished frame, all transient sets of frame become invalid
+        void resetTransientPools(uint32_t frameIndex);
+
+        // First pool of chain, for users allocating on their own such as ImGui
         VkDescriptorPool getPool(const std::string &poolName = "MainPool");
 
+        [[nodiscard]] DescriptorPoolStats getStats() const;
+
     private:
-        VkDescriptorPool createPool(const std::string &poolName);
+        struct PoolChain
+        {
+            std::vector<VkDescriptorPool> pools;
+            // Pools before it were full when last tried
+            uint32_t current = 0;
+            uint32_t allocatedSets = 0;
+        };
+
+        struct SetOwner
+        {
+            PoolChain *chain = nullptr;
+            VkDescriptorPool pool = VK_NULL_HANDLE;
+        };
+
+        static VkDescriptorPool createPool(VkDescriptorPoolCreateFlags flags);
+
+        VkDescriptorSet allocateFromChain(PoolChain &chain, VkDescriptorSetLayout layout, VkDescriptorPoolCreateFlags flags,
+                                        const std::string &chainName, VkDescriptorPool &outPool);
 
     private:
-        std::unordered_map<std::string, VkDescriptorPool> m_pools;
+        std::unordered_map<std::string, PoolChain> m_pools;
+        std::vector<PoolChain> m_transientPools;
+        std::unordered_map<VkDescriptorSet, SetOwner> m_setOwners;
+        uint32_t m_transientPeakSets = 0;
     };
 
+    // Layouts keyed by create flags and binding list, equal binding lists share one layout
+    // Layouts live until release, callers never destroy them
     class DescriptorLayoutCache
     {
     public:
-        static VkDescriptorSetLayout createDescriptorLayout(VkDescriptorSetLayoutCreateInfo &info);
+        void release();
+
+        // Create info without pNext chain, binding order does not matter
+        VkDescriptorSetLayout createDescriptorLayout(const VkDescriptorSetLayoutCreateInfo &info);
+
+        [[nodiscard]] size_t getLayoutCount() const { return m_layouts.size(); }
+
+    private:
+        struct LayoutKey
+        {
+            VkDescriptorSetLayoutCreateFlags flags = 0;
+            // Immutable sampler pointers are only compared against null, they point into caller memory
+            std::vector<VkDescriptorSetLayoutBinding> bindings;
+            // Immutable sampler handles of every binding in binding order, descriptor count each
+            std::vector<VkSampler> immutableSamplers;
+
+            bool operator==(const LayoutKey &other) const;
+        };
+
+        struct LayoutKeyHash
+        {
+            size_t operator()(const LayoutKey &key) const;
+        };
+
+        std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> m_layouts;
+    };
+
+    // Descriptor sets keyed by layout and bound resources, builds writing the same resources share one set
+    // Shared sets are reference counted, give them back through releaseSet instead of freeing them
+    class DescriptorSetCache
+    {
+    public:
+        void release();
+
+        // Return cached set and add one reference, VK_NULL_HANDLE when key is new
+        VkDescriptorSet acquire(const std::vector<uint64_t> &key);
+
+        // Insert new set with one reference
+        void insert(const std::vector<uint64_t> &key, VkDescriptorSet descriptorSet);
+
+        // Drop one reference, set is freed back to its pool with the last one
+        void releaseSet(VkDescriptorSet descriptorSet);
+
+        [[nodiscard]] size_t getSetCount() const { return m_sets.size(); }
+
+    private:
+        struct KeyHash
+        {
+            size_t operator()(const std::vector<uint64_t> &key) const;
+        };
+
+        struct Entry
+        {
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+            uint32_t refCount = 0;
+        };
+
+        std::unordered_map<std::vector<uint64_t>, Entry, KeyHash> m_sets;
+        std::unordered_map<VkDescriptorSet, std::vector<uint64_t>> m_keys;
     };
 
     class DescriptorFactory final
     {
     public:
         // start building
-        static DescriptorFactory begin(DescriptorPoolCache* poolCache);
+        static DescriptorFactory begin(DescriptorPoolCache *poolCache, DescriptorLayoutCache *layoutCache, DescriptorSetCache *setCache);
 
         // Use for bufffers
         DescriptorFactory& bindBuffers(uint32_t binding, uint32_t count, VkDescriptorBufferInfo *bufferInfo, VkDescriptorType type, VkShaderStageFlags stageFlags);
@@ -43,6 +150,7 @@ namespace VT
         // Use for textures
         DescriptorFactory& bindImages(uint32_t binding, uint32_t count, VkDescriptorImageInfo *imageInfo, VkDescriptorType type, VkShaderStageFlags stageFlags);
 
+        // Layout is owned by layout cache, set is shared with equal builds, see DescriptorSetCache::releaseSet
         bool build(VkDescriptorSet &descriptorSet, VkDescriptorSetLayout &layout);
         bool build(VkDescriptorSet &descriptorSet);
 
@@ -60,5 +168,11 @@ namespace VT
         std::vector<DescriptorWriteContainer> m_descriptorWriteBufInfos{};
         std::vector<VkDescriptorSetLayoutBinding> m_bindings;
         DescriptorPoolCache* m_cache;
+        DescriptorLayoutCache* m_layoutCache;
+        DescriptorSetCache* m_setCache;
+
+    private:
+        // Layout handle followed by every written resource handle
+        std::vector<uint64_t> buildSetKey(VkDescriptorSetLayout layout) const;
     };
 }
@@ -11,10 +11,18 @@
 #include <VulkanToy/VulkanRHI/Shader.h>
 #include <VulkanToy/VulkanRHI/VulkanDescriptor.h>
 #include <VulkanToy/VulkanRHI/Sampler.h>
+#include <VulkanToy/VulkanRHI/PipelineCache.h>
+#include <VulkanToy/VulkanRHI/BindlessHeap.h>
+#include <VulkanToy/VulkanRHI/FrameLinearAllocator.h>
+#include <VulkanToy/VulkanRHI/DeletionQueue.h>
+#include <VulkanToy/VulkanRHI/GPUProfiler.h>
 #include <VulkanToy/Events/EventDelegate.h>
 
 namespace VT
 {
+    // Frames CPU may record ahead of GPU, per frame resources are allocated for the maximum
+    constexpr uint32_t GMaxFramesInFlight = 3;
+    constexpr uint32_t GDefaultFramesInFlight = 2;
 
     class VulkanContext final : public DisableCopy
     {
@@ -34,25 +42,45 @@ namespace VT
 
         VmaAllocator m_vmaAllocator{};
         DescriptorPoolCache m_descriptorPoolCache{};
+        DescriptorLayoutCache m_descriptorLayoutCache{};
+        DescriptorSetCache m_descriptorSetCache{};
 
         struct PresentContext
         {
             bool isSwapChainChange = false;
-            uint32_t imageIndex;
-            uint32_t currentFrame;
-            std::vector<VkSemaphore> semaphoresImageAvailable;
+            uint32_t imageIndex = 0;
+            // Frame slot being recorded, in [0, framesInFlight)
+            uint32_t currentFrame = 0;
+            uint32_t framesInFlight = GDefaultFramesInFlight;
+            // Acquire signals one per frame slot, present waits one per swap chain image
+            std::array<VkSemaphore, GMaxFramesInFlight> semaphoresImageAvailable{};
             std::vector<VkSemaphore> semaphoresRenderFinished;
-            std::vector<VkFence> inFlightFences;
-            std::vector<VkFence> imagesInFlight;
+            // Timeline value each frame slot signaled last, slot is reused once timeline reaches it
+            std::array<uint64_t, GMaxFramesInFlight> frameTimelineValues{};
 
             void init();
             void release();
         } m_presentContext;
 
+        // Signaled by every timeline submission on major graphics queue, values only grow
+        VkSemaphore m_timelineSemaphore = VK_NULL_HANDLE;
+        uint64_t m_timelineValue = 0;
+        std::mutex m_timelineMutex;
+
         ShaderCache m_shaderCache;
 
         SamplerCache m_samplerCache;
 
+        PipelineCache m_pipelineCache;
+
+        BindlessHeap m_bindlessHeap;
+
+        FrameLinearAllocator m_frameAllocator;
+
+        DeletionQueue m_deletionQueue;
+
+        GPUProfiler m_gpuProfiler;
+
         std::vector<VkCommandBuffer> m_drawCmdBuffers;
 
     private:
@@ -92,9 +120,21 @@ namespace VT
     public:
         uint32_t acquireNextPresentImage();
         void present();
-        void submit(uint32_t count, VkSubmitInfo *infos);
-        void submitWithoutFence(uint32_t count, VkSubmitInfo* infos);
-        void resetFence();
+        // Submit frame commands of current frame slot, slot is free again once its timeline value is reached
+        void submitFrame(const VkSubmitInfo &info);
+
+        // Submit on major graphics queue and signal next timeline value, returns the value
+        // Other queues may wait on timeline semaphore but must not signal it
+        uint64_t submitWithTimeline(const VkSubmitInfo &info);
+
+        void waitTimeline(uint64_t value, uint64_t timeout = UINT64_MAX);
+        [[nodiscard]] bool isTimelineReached(uint64_t value) const;
+        [[nodiscard]] uint64_t getCompletedTimelineValue() const;
+        [[nodiscard]] VkSemaphore getTimelineSemaphore() const { return m_timelineSemaphore; }
+
+        // Latency and throughput knob, takes effect from next frame, clamped to [1, GMaxFramesInFlight]
+        void setFramesInFlight(uint32_t count);
+        [[nodiscard]] uint32_t getFramesInFlight() const { return m_presentContext.framesInFlight; }
 
         Events::EventDelegate<> onAfterSwapChainRebuild;
 
@@ -125,6 +165,8 @@ namespace VT
 
         // Descriptor
         DescriptorPoolCache& getDescriptorPoolCache() { return m_descriptorPoolCache; }
+        DescriptorLayoutCache& getDescriptorLayoutCache() { return m_descriptorLayoutCache; }
+        DescriptorSetCache& getDescriptorSetCache() { return m_descriptorSetCache; }
 
         DescriptorFactory descriptorFactoryBegin();
 
@@ -132,13 +174,29 @@ namespace VT
 
         void updateDescriptorSet(VkDescriptorSet &dstDescriptorSet, uint32_t dstBinding, VkDescriptorType descriptorType, const std::vector<VkDescriptorBufferInfo> &descriptors) const;
 
+        // Pipeline cache, every pipeline should be created through it
+        PipelineCache& getPipelineCache() { return m_pipelineCache; }
+
+        // Global update-after-bind set of asset textures, buffers and materials
+        BindlessHeap& getBindlessHeap() { return m_bindlessHeap; }
+
+        // Per frame uniform and dynamic data, rewound when last frame of current slot finish
+        FrameLinearAllocator& getFrameAllocator() { return m_frameAllocator; }
+
+        // Destroy handles after frames in flight finish with them, usable from any thread
+        DeletionQueue& getDeletionQueue() { return m_deletionQueue; }
+
+        // Per pass GPU time from timestamp queries, read back frames in flight later
+        GPUProfiler& getGPUProfiler() { return m_gpuProfiler; }
+
         // Other
         VkPipelineLayout createPipelineLayout(const VkPipelineLayoutCreateInfo& info);
 
         VkCommandBuffer& getDrawCommandBuffer(uint32_t index) { return m_drawCmdBuffers.at(index); }
 
-        // TODO: fix confusing function
-        [[nodiscard]] uint32_t getCurrentFrameIndex() const { return m_presentContext.imageIndex; }
+        // Frame slot being recorded, indexes per frame resources, not swap chain images
+        [[nodiscard]] uint32_t getCurrentFrameIndex() const { return m_presentContext.currentFrame; }
+        [[nodiscard]] uint32_t getCurrentImageIndex() const { return m_presentContext.imageIndex; }
 
         VulkanSwapChain& getSwapChain() { return m_swapChain; }
         std::vector<VkImageView>& getSwapChainImageViews() { return m_swapChain.swapChainImageViews; }
@@ -150,7 +208,7 @@ namespace VT
         [[nodiscard]] VkPhysicalDeviceProperties getPhysicalDeviceProperties() const { return m_device.properties; }
 
         [[nodiscard]] VkSemaphore getCurrentFrameWaitSemaphore() const { return m_presentContext.semaphoresImageAvailable[m_presentContext.currentFrame]; }
-        [[nodiscard]] VkSemaphore getCurrentFrameFinishSemaphore() const { return m_presentContext.semaphoresRenderFinished[m_presentContext.currentFrame]; }
+        [[nodiscard]] VkSemaphore getCurrentFrameFinishSemaphore() const { return m_presentContext.semaphoresRenderFinished[m_presentContext.imageIndex]; }
     };
 
     namespace VulkanRHI
@@ -16,25 +16,45 @@ namespace VT
 
     void AssetSystem::addUploadTask(Ref<AssetLoadTask> inTask)
     {
+        std::lock_guard<std::mutex> lock(m_uploadTaskMutex);
         m_uploadTasks.push_back(inTask);
     }
 
+    void AssetSystem::submitUploadTasks()
+    {
+        std::vector<Ref<AssetLoadTask>> uploadTasks;
+        {
+            std::lock_guard<std::mutex> lock(m_uploadTaskMutex);
+            uploadTasks.swap(m_uploadTasks);
+        }
+
+        for (auto& task : uploadTasks)
+        {
+            m_uploaderManager.addTask(task);
+        }
+    }
+
     void AssetSystem::flushUploadTask()
     {
-        // TODO: submit and flush tasks
+        submitUploadTasks();
+        m_uploaderManager.flush();
     }
 
     void AssetSystem::init()
     {
         TextureManager::Get()->init();
         MeshManager::Get()->init();
+        m_uploaderManager.init();
 
-        // TODO: engine asset init
         engineAssetInit();
+        // Start copying while other modules initialize
+        submitUploadTasks();
     }
 
     void AssetSystem::engineAssetInit()
     {
+        VT_PROFILE_SCOPE("AssetSystem::engineAssetInit");
+
         // Engine mesh upload
         StaticMeshRawDataLoadTask::buildFromPath(
                 "EngineMeshBox",
@@ -51,7 +71,8 @@ namespace VT
                 "EngineMeshCerberus",
                 "../data/meshes/Cerberus.fbx",
                 EngineMeshes::GCerberusUUID,
-                true);
+                true,
+                VertexFormat::Compact);
 
         StaticMeshRawDataLoadTask::buildFromPath(
                 "EngineMeshSkybox",
@@ -92,13 +113,24 @@ namespace VT
 
     void AssetSystem::release()
     {
-        // TODO: complete
+        // Stop uploaders before releasing assets they may still write
+        m_uploaderManager.release();
+        {
+            std::lock_guard<std::mutex> lock(m_uploadTaskMutex);
+            m_uploadTasks.clear();
+        }
+
         TextureManager::Get()->release();
         MeshManager::Get()->release();
     }
 
     void AssetSystem::tick(const RuntimeModuleTickData &tickData)
     {
-        // TODO: submit all task
+        submitUploadTasks();
+        m_uploaderManager.tick();
+
+        // Evict unused transient assets over budget
+        MeshManager::Get()->tick();
+        TextureManager::Get()->tick();
     }
 }
\ No newline at end of file
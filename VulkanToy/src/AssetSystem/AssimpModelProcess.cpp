@@ -3,6 +3,7 @@
 //
 
 #include <VulkanToy/AssetSystem/AssimpModelProcess.h>
+#include <VulkanToy/Core/JobSystem.h>
 
 namespace VT
 {
@@ -12,109 +13,92 @@ namespace VT
 
     }
 
-//    void AssimpModelProcess::processNode(aiNode *node, const aiScene *scene)
-//    {
-//        for (uint32_t i = 0; i < node->mNumMeshes; ++i)
-//        {
-//            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-//            m_subMeshInfos.push_back(processMesh(mesh, scene));
-//        }
-//
-//        for (uint32_t i = 0; i < node->mNumChildren; ++i)
-//        {
-//            processNode(node->mChildren[i], scene);
-//        }
-//    }
-
-//    StaticMeshSubMesh AssimpModelProcess::processMesh(aiMesh *mesh, const aiScene *scene)
-//    {
-//        VT_CORE_ASSERT(mesh->HasPositions(), "The model file does not have position information");
-//        VT_CORE_ASSERT(mesh->HasNormals(), "The model file does not have normal information");
-//
-//        StaticMeshSubMesh subMeshInfo{};
-//        subMeshInfo.indexStartPosition = static_cast<uint32_t>(m_indices.size());
-//        uint32_t indexOffset = static_cast<uint32_t>(m_vertices.size());
-//
-//        std::vector<StaticMeshVertex> vertices{};
-//        std::vector<VertexIndexType> indices{};
-//
-//        for (uint32_t i = 0; i < mesh->mNumVertices; ++i)
-//        {
-//            StaticMeshVertex vertex{};
-//
-//            vertex.position = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
-//            vertex.normal = { mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z };
-//
-//            if (mesh->HasTextureCoords(0))
-//            {
-//                vertex.uv = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
-//            } else
-//            {
-//                vertex.uv = glm::vec2{ 0.0f, 0.0f };
-//            }
-//
-//            // Tangent and bitangent
-//            if (mesh->HasTangentsAndBitangents())
-//            {
-//                glm::vec4 tangentVec = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z, 1.0f };
-//
-//                glm::vec3 vector = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z };
-//
-//                glm::vec3 bitangent = { mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z };
-//
-//                // Tangent sign process
-//                tangentVec.w = glm::sign(
-//                        glm::dot(glm::normalize(bitangent), glm::normalize(glm::cross(vertex.normal, vector))));
-//
-//                vertex.tangent = tangentVec;
-//            }
-//
-//            vertices.push_back(vertex);
-//        }
-//
-//        for (uint32_t i = 0; i < mesh->mNumFaces; ++i)
-//        {
-//            aiFace face = mesh->mFaces[i];
-//            for (uint32_t j = 0; j < face.mNumIndices; ++j)
-//            {
-//                indices.push_back(indexOffset + face.mIndices[j]);
-//            }
-//        }
-//
-//        m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
-//        m_indices.insert(m_indices.end(), indices.begin(), indices.end());
-//
-//        subMeshInfo.indexCount = static_cast<uint32_t>(indices.size());
-//
-//        // AABB bound process
-//        auto aabbMax = mesh->mAABB.mMax;
-//        auto aabbMin = mesh->mAABB.mMin;
-//        auto aabbExt = (aabbMax - aabbMin) * 0.5f;
-//        auto aabbCenter = aabbExt + aabbMin;
-//        subMeshInfo.renderBound.extent[0] = aabbExt.x;
-//        subMeshInfo.renderBound.extent[1] = aabbExt.y;
-//        subMeshInfo.renderBound.extent[2] = aabbExt.z;
-//        subMeshInfo.renderBound.origin[0] = aabbCenter.x;
-//        subMeshInfo.renderBound.origin[1] = aabbCenter.y;
-//        subMeshInfo.renderBound.origin[2] = aabbCenter.z;
-//        subMeshInfo.renderBound.radius = glm::distance(
-//            glm::vec3(aabbMax.x, aabbMax.y, aabbMax.x),
-//            glm::vec3(aabbCenter.x, aabbCenter.y, aabbCenter.z));
-//
-//        subMeshInfo.material = {};
-//
-//        return subMeshInfo;
-//    }
+    void AssimpModelProcess::processScene(const aiScene *scene)
+    {
+        std::vector<const aiMesh *> meshes{};
+        processNode(scene->mRootNode, scene, meshes);
+        if (meshes.empty())
+        {
+            VT_CORE_WARN("Model '{0}' has no mesh", folderPath.string());
+            return;
+        }
+
+        // Sub-mesh ranges are known up front, so every worker writes its own slice without lock
+        std::vector<uint32_t> vertexStarts(meshes.size());
+        uint32_t vertexCount = static_cast<uint32_t>(m_vertices.size());
+        uint32_t indexCount = static_cast<uint32_t>(m_indices.size());
+        const size_t subMeshStart = m_subMeshInfos.size();
+        m_subMeshInfos.resize(subMeshStart + meshes.size());
+        for (size_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+        {
+            vertexStarts[meshIndex] = vertexCount;
+            m_subMeshInfos[subMeshStart + meshIndex].indexStartPosition = indexCount;
+            vertexCount += meshes[meshIndex]->mNumVertices;
+            indexCount += 3 * meshes[meshIndex]->mNumFaces;
+        }
+        m_vertices.resize(vertexCount);
+        m_indices.resize(indexCount);
+
+        // Concurrent imports share job system workers instead of spawning threads each, sub-mesh sizes vary a lot
+        // so ranges are as small as job system allows
+        JobSystemHandle::Get()->parallelFor(static_cast<uint32_t>(meshes.size()), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t meshIndex = begin; meshIndex < end; ++meshIndex)
+            {
+                auto& subMesh = m_subMeshInfos[subMeshStart + meshIndex];
+                processMeshRange(meshes[meshIndex], scene, vertexStarts[meshIndex], subMesh.indexStartPosition,
+                                m_vertices.data(), m_indices.data(), subMesh);
+            }
+        });
+    }
+
+    void AssimpModelProcess::processNode(const aiNode *node, const aiScene *scene, std::vector<const aiMesh *> &outMeshes)
+    {
+        // Iterative traversal, deep hierarchies exported from DCC tools can overflow recursion
+        std::vector<const aiNode *> nodeStack{ node };
+        while (!nodeStack.empty())
+        {
+            const aiNode *currentNode = nodeStack.back();
+            nodeStack.pop_back();
+
+            for (uint32_t i = 0; i < currentNode->mNumMeshes; ++i)
+            {
+                outMeshes.push_back(scene->mMeshes[currentNode->mMeshes[i]]);
+            }
+            // Push in reverse to keep sub-mesh order same as recursion
+            for (uint32_t i = currentNode->mNumChildren; i > 0; --i)
+            {
+                nodeStack.push_back(currentNode->mChildren[i - 1]);
+            }
+        }
+    }
 
     void AssimpModelProcess::processMesh(aiMesh *mesh, const aiScene *scene)
+    {
+        const uint32_t vertexStart = static_cast<uint32_t>(m_vertices.size());
+        const uint32_t indexStart = static_cast<uint32_t>(m_indices.size());
+        m_vertices.resize(vertexStart + mesh->mNumVertices);
+        m_indices.resize(indexStart + 3 * mesh->mNumFaces);
+
+        StaticMeshSubMesh subMeshInfo{};
+        subMeshInfo.indexStartPosition = indexStart;
+        processMeshRange(mesh, scene, vertexStart, indexStart, m_vertices.data(), m_indices.data(), subMeshInfo);
+
+        m_subMeshInfos.emplace_back(subMeshInfo);
+    }
+
+    void AssimpModelProcess::processMeshRange(const aiMesh *mesh, const aiScene *scene,
+                                            uint32_t vertexStart, uint32_t indexStart,
+                                            StaticMeshVertex *outVertices, VertexIndexType *outIndices,
+                                            StaticMeshSubMesh &outSubMesh)
     {
         VT_CORE_ASSERT(mesh->HasPositions(), "The model file does not have position information");
         VT_CORE_ASSERT(mesh->HasNormals(), "The model file does not have normal information");
 
-        m_vertices.reserve(mesh->mNumVertices);
         for (uint32_t i = 0; i < mesh->mNumVertices; ++i)
         {
-            StaticMeshVertex vertex{};
+            StaticMeshVertex &vertex = outVertices[vertexStart + i];
+            vertex = StaticMeshVertex{};
 
             vertex.position = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
             vertex.normal = { mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z };
@@ -130,62 +114,43 @@ namespace VT
             // Tangent and bitangent
             if (mesh->HasTangentsAndBitangents())
             {
-//                glm::vec4 tangentVec = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z, 1.0f };
-//
-//                glm::vec3 vector = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z };
-//
-//                glm::vec3 bitangent = { mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z };
-//
-//                // Tangent sign process
-//                tangentVec.w = glm::sign(
-//                        glm::dot(glm::normalize(bitangent), glm::normalize(glm::cross(vertex.normal, vector))));
-//
-//                vertex.tangent = tangentVec;
                 vertex.tangent = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z };
                 vertex.bitangent = { mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z };
             }
-
-            m_vertices.push_back(vertex);
         }
 
-        m_indices.reserve(3 * mesh->mNumFaces);
+        // Sub-meshes share one vertex buffer, rebase indices to the sub-mesh first vertex
+        VertexIndexType *indices = outIndices + indexStart;
         for (uint32_t i = 0; i < mesh->mNumFaces; ++i)
         {
             VT_CORE_ASSERT(mesh->mFaces[i].mNumIndices == 3, "Ensure the model is triangle face");
-            m_indices.push_back(mesh->mFaces[i].mIndices[0]);
-            m_indices.push_back(mesh->mFaces[i].mIndices[1]);
-            m_indices.push_back(mesh->mFaces[i].mIndices[2]);
+            indices[3 * i + 0] = vertexStart + mesh->mFaces[i].mIndices[0];
+            indices[3 * i + 1] = vertexStart + mesh->mFaces[i].mIndices[1];
+            indices[3 * i + 2] = vertexStart + mesh->mFaces[i].mIndices[2];
         }
 
-        StaticMeshSubMesh subMeshInfo{};
-        subMeshInfo.indexCount = static_cast<uint32_t>(m_indices.size());
+        outSubMesh.indexStartPosition = indexStart;
+        outSubMesh.indexCount = 3 * mesh->mNumFaces;
 
         // AABB bound process
         auto aabbMax = mesh->mAABB.mMax;
         auto aabbMin = mesh->mAABB.mMin;
         auto aabbExt = (aabbMax - aabbMin) * 0.5f;
         auto aabbCenter = aabbExt + aabbMin;
-        subMeshInfo.renderBound.extent[0] = aabbExt.x;
-        subMeshInfo.renderBound.extent[1] = aabbExt.y;
-        subMeshInfo.renderBound.extent[2] = aabbExt.z;
-        subMeshInfo.renderBound.origin[0] = aabbCenter.x;
-        subMeshInfo.renderBound.origin[1] = aabbCenter.y;
-        subMeshInfo.renderBound.origin[2] = aabbCenter.z;
-        subMeshInfo.renderBound.radius = glm::distance(
-                glm::vec3(aabbMax.x, aabbMax.y, aabbMax.x),
+        outSubMesh.renderBound.extent[0] = aabbExt.x;
+        outSubMesh.renderBound.extent[1] = aabbExt.y;
+        outSubMesh.renderBound.extent[2] = aabbExt.z;
+        outSubMesh.renderBound.origin[0] = aabbCenter.x;
+        outSubMesh.renderBound.origin[1] = aabbCenter.y;
+        outSubMesh.renderBound.origin[2] = aabbCenter.z;
+        outSubMesh.renderBound.radius = glm::distance(
+                glm::vec3(aabbMax.x, aabbMax.y, aabbMax.z),
                 glm::vec3(aabbCenter.x, aabbCenter.y, aabbCenter.z));
 
-        subMeshInfo.material = {};
-
-        m_subMeshInfos.emplace_back(subMeshInfo);
+        outSubMesh.material = {};
+        if (mesh->mMaterialIndex < scene->mNumMaterials)
+        {
+            outSubMesh.material = scene->mMaterials[mesh->mMaterialIndex]->GetName().C_Str();
+        }
     }
 }
-
-
-
-
-
-
-
-
-
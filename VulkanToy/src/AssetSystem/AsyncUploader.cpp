@@ -0,0 +1,516 @@
+//
+// Created by ZHIKANG on 2023/4/3.
+//
+
+#include <VulkanToy/AssetSystem/AsyncUploader.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+
+namespace VT
+{
+    static VkDeviceSize alignUploadSize(VkDeviceSize size)
+    {
+        return (size + GUploaderOffsetAlignment - 1) & ~(GUploaderOffsetAlignment - 1);
+    }
+
+    static VkFence createUploadFence()
+    {
+        VkFenceCreateInfo fenceCreateInfo{};
+        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence = VK_NULL_HANDLE;
+        RHICheck(vkCreateFence(VulkanRHI::Device, &fenceCreateInfo, nullptr, &fence));
+        return fence;
+    }
+
+    // Uploader base
+    AsyncUploaderBase::AsyncUploaderBase(const std::string &name, AsyncUploaderManager &manager,
+                                        VkQueue queue, VkCommandPool commandPool)
+    : m_name(name), m_manager(manager), m_queue(queue), m_commandPool(commandPool),
+        m_queueFamily(VulkanRHI::get()->getCopyFamily())
+    {
+
+    }
+
+    void AsyncUploaderBase::start()
+    {
+        m_thread = std::thread([this]() { loop(); });
+    }
+
+    void AsyncUploaderBase::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isShutdown = true;
+        }
+        m_condition.notify_all();
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    void AsyncUploaderBase::addTask(Ref<AssetLoadTask> inTask)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pendingTasks.push(std::move(inTask));
+        }
+        m_condition.notify_one();
+    }
+
+    bool AsyncUploaderBase::waitTasks(std::queue<Ref<AssetLoadTask>> &outTasks, bool isPolling)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto predicate = [this]() { return m_isShutdown || !m_pendingTasks.empty(); };
+        if (isPolling)
+        {
+            m_condition.wait_for(lock, std::chrono::milliseconds(1), predicate);
+        } else
+        {
+            m_condition.wait(lock, predicate);
+        }
+
+        if (m_isShutdown)
+        {
+            return false;
+        }
+
+        while (!m_pendingTasks.empty())
+        {
+            outTasks.push(std::move(m_pendingTasks.front()));
+            m_pendingTasks.pop();
+        }
+        return true;
+    }
+
+    CommandBufferBase AsyncUploaderBase::allocateCommandBuffer()
+    {
+        VkCommandBufferAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandPool = m_commandPool;
+        allocateInfo.commandBufferCount = 1;
+
+        CommandBufferBase commandBuffer{};
+        commandBuffer.pool = m_commandPool;
+        commandBuffer.queueFamily = m_queueFamily;
+        RHICheck(vkAllocateCommandBuffers(VulkanRHI::Device, &allocateInfo, &commandBuffer.cmd));
+        return commandBuffer;
+    }
+
+    void AsyncUploaderBase::freeCommandBuffer(CommandBufferBase &commandBuffer)
+    {
+        vkFreeCommandBuffers(VulkanRHI::Device, commandBuffer.pool, 1, &commandBuffer.cmd);
+        commandBuffer.cmd = VK_NULL_HANDLE;
+    }
+
+    void AsyncUploaderBase::beginCommandBuffer(CommandBufferBase &commandBuffer)
+    {
+        VkCommandBufferBeginInfo beginInfo = Initializers::initCommandBufferBeginInfo();
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        RHICheck(vkBeginCommandBuffer(commandBuffer.cmd, &beginInfo));
+        VulkanRHI::setPerfMarkerBegin(commandBuffer.cmd, m_name.c_str(), { 0.5f, 1.0f, 0.5f, 1.0f });
+    }
+
+    void AsyncUploaderBase::submitCommandBuffer(CommandBufferBase &commandBuffer, VkFence fence)
+    {
+        VulkanRHI::setPerfMarkerEnd(commandBuffer.cmd);
+        RHICheck(vkEndCommandBuffer(commandBuffer.cmd));
+
+        VulkanSubmitInfo submitInfo{};
+        submitInfo.setCommandBuffer(&commandBuffer.cmd, 1);
+        RHICheck(vkResetFences(VulkanRHI::Device, 1, &fence));
+        RHICheck(vkQueueSubmit(m_queue, 1, &submitInfo.getSubmitInfo(), fence));
+    }
+
+    // Static uploader
+    StaticAsyncUploader::StaticAsyncUploader(AsyncUploaderManager &manager, VkQueue queue, VkCommandPool commandPool)
+    : AsyncUploaderBase("StaticAsyncUploader", manager, queue, commandPool)
+    {
+
+    }
+
+    void StaticAsyncUploader::init()
+    {
+        m_stageBuffer = VulkanBuffer::create(
+                "StaticUploaderStageBuffer",
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                VMAUsageFlags::StageCopyForUpload,
+                GStaticUploaderMaxSize);
+        RHICheck(m_stageBuffer->map());
+
+        for (uint32_t index = 0; index < GStaticUploaderMaxInFlight; ++index)
+        {
+            m_batches[index].commandBuffer = allocateCommandBuffer();
+            m_batches[index].fence = createUploadFence();
+            m_freeBatches.push_back(index);
+        }
+    }
+
+    void StaticAsyncUploader::release()
+    {
+        while (!m_inFlightBatches.empty())
+        {
+            retireOldestBatch(true);
+        }
+
+        for (auto& batch : m_batches)
+        {
+            freeCommandBuffer(batch.commandBuffer);
+            vkDestroyFence(VulkanRHI::Device, batch.fence, nullptr);
+            batch.tasks.clear();
+        }
+
+        m_stageBuffer->unmap();
+        m_stageBuffer->release();
+        m_stageBuffer.reset();
+    }
+
+    void StaticAsyncUploader::loop()
+    {
+        VT_PROFILE_THREAD(m_name);
+        init();
+
+        std::queue<Ref<AssetLoadTask>> workingTasks;
+        while (waitTasks(workingTasks, !m_inFlightBatches.empty()))
+        {
+            // Retire finished batches without blocking
+            while (!m_inFlightBatches.empty() && retireOldestBatch(false)) {}
+
+            while (!workingTasks.empty())
+            {
+                if (m_recordingBatch == ~0u)
+                {
+                    beginBatch();
+                }
+
+                auto& task = workingTasks.front();
+                VkDeviceSize offset = 0;
+                if (!tryAllocate(task->getUploadSize(), offset))
+                {
+                    // Ring full, submit what we have or wait the oldest batch to free space
+                    if (!m_batches[m_recordingBatch].tasks.empty())
+                    {
+                        submitBatch();
+                    } else if (!m_inFlightBatches.empty())
+                    {
+                        retireOldestBatch(true);
+                    } else
+                    {
+                        VT_CORE_CRITICAL("Upload task size '{0}' exceeds static stage buffer", task->getUploadSize());
+                    }
+                    continue;
+                }
+
+                auto& batch = m_batches[m_recordingBatch];
+                task->uploadDevice(static_cast<uint32_t>(offset),
+                                    static_cast<char *>(m_stageBuffer->getMapped()) + offset,
+                                    batch.commandBuffer,
+                                    *m_stageBuffer);
+                batch.tasks.push_back(std::move(task));
+                workingTasks.pop();
+            }
+
+            if (m_recordingBatch != ~0u && !m_batches[m_recordingBatch].tasks.empty())
+            {
+                submitBatch();
+            }
+        }
+
+        release();
+    }
+
+    bool StaticAsyncUploader::tryAllocate(VkDeviceSize size, VkDeviceSize &outOffset)
+    {
+        const VkDeviceSize capacity = m_stageBuffer->getMemorySize();
+        size = alignUploadSize(size);
+
+        if (m_ringUsed == 0)
+        {
+            m_ringHead = 0;
+            m_ringTail = 0;
+        }
+        if (m_ringUsed + size > capacity)
+        {
+            return false;
+        }
+
+        auto& batch = m_batches[m_recordingBatch];
+        if (m_ringHead >= m_ringTail)
+        {
+            // Free space is [head, capacity) and [0, tail)
+            if (m_ringHead + size <= capacity)
+            {
+                outOffset = m_ringHead;
+                m_ringHead += size;
+                m_ringUsed += size;
+                batch.ringSize += size;
+                return true;
+            }
+            if (size <= m_ringTail)
+            {
+                // Wrap around, tail fragment is wasted until this batch retires
+                const VkDeviceSize wasted = capacity - m_ringHead;
+                outOffset = 0;
+                m_ringHead = size;
+                m_ringUsed += wasted + size;
+                batch.ringSize += wasted + size;
+                return true;
+            }
+        } else if (m_ringHead + size <= m_ringTail)
+        {
+            // Free space is [head, tail)
+            outOffset = m_ringHead;
+            m_ringHead += size;
+            m_ringUsed += size;
+            batch.ringSize += size;
+            return true;
+        }
+        return false;
+    }
+
+    void StaticAsyncUploader::beginBatch()
+    {
+        while (m_freeBatches.empty())
+        {
+            retireOldestBatch(true);
+        }
+
+        m_recordingBatch = m_freeBatches.back();
+        m_freeBatches.pop_back();
+
+        auto& batch = m_batches[m_recordingBatch];
+        batch.ringSize = 0;
+        beginCommandBuffer(batch.commandBuffer);
+    }
+
+    void StaticAsyncUploader::submitBatch()
+    {
+        auto& batch = m_batches[m_recordingBatch];
+        batch.ringEnd = m_ringHead;
+        submitCommandBuffer(batch.commandBuffer, batch.fence);
+
+        m_inFlightBatches.push(m_recordingBatch);
+        m_recordingBatch = ~0u;
+    }
+
+    bool StaticAsyncUploader::retireOldestBatch(bool isWait)
+    {
+        const uint32_t batchIndex = m_inFlightBatches.front();
+        auto& batch = m_batches[batchIndex];
+        if (isWait)
+        {
+            RHICheck(vkWaitForFences(VulkanRHI::Device, 1, &batch.fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
+        } else if (vkGetFenceStatus(VulkanRHI::Device, batch.fence) != VK_SUCCESS)
+        {
+            return false;
+        }
+
+        // Batches retire in submit order, so tail moves to the end of this batch
+        m_ringTail = batch.ringEnd;
+        m_ringUsed -= batch.ringSize;
+        batch.ringSize = 0;
+
+        m_manager.onTasksFinished(batch.tasks);
+        batch.tasks.clear();
+
+        m_inFlightBatches.pop();
+        m_freeBatches.push_back(batchIndex);
+        return true;
+    }
+
+    // Dynamic uploader
+    DynamicAsyncUploader::DynamicAsyncUploader(AsyncUploaderManager &manager, VkQueue queue, VkCommandPool commandPool)
+    : AsyncUploaderBase("DynamicAsyncUploader", manager, queue, commandPool)
+    {
+
+    }
+
+    void DynamicAsyncUploader::loop()
+    {
+        VT_PROFILE_THREAD(m_name);
+        m_commandBuffer = allocateCommandBuffer();
+        m_fence = createUploadFence();
+
+        std::queue<Ref<AssetLoadTask>> workingTasks;
+        while (waitTasks(workingTasks, false))
+        {
+            while (!workingTasks.empty())
+            {
+                std::vector<Ref<AssetLoadTask>> finishedTasks{ std::move(workingTasks.front()) };
+                workingTasks.pop();
+
+                auto& task = finishedTasks.front();
+                const VkDeviceSize uploadSize = task->getUploadSize();
+                if (m_stageBuffer == nullptr || m_stageBuffer->getMemorySize() < uploadSize)
+                {
+                    releaseStageBuffer();
+                    m_stageBuffer = VulkanBuffer::create(
+                            "DynamicUploaderStageBuffer",
+                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            VMAUsageFlags::StageCopyForUpload,
+                            std::max<VkDeviceSize>(uploadSize, GDynamicUploaderMinSize));
+                    RHICheck(m_stageBuffer->map());
+                }
+
+                beginCommandBuffer(m_commandBuffer);
+                task->uploadDevice(0, m_stageBuffer->getMapped(), m_commandBuffer, *m_stageBuffer);
+                submitCommandBuffer(m_commandBuffer, m_fence);
+
+                // Worker thread, wait here does not stall render thread
+                RHICheck(vkWaitForFences(VulkanRHI::Device, 1, &m_fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
+                m_manager.onTasksFinished(finishedTasks);
+            }
+
+            // Release stage buffer when no task
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_pendingTasks.empty())
+            {
+                releaseStageBuffer();
+            }
+        }
+
+        releaseStageBuffer();
+        freeCommandBuffer(m_commandBuffer);
+        vkDestroyFence(VulkanRHI::Device, m_fence, nullptr);
+    }
+
+    void DynamicAsyncUploader::releaseStageBuffer()
+    {
+        if (m_stageBuffer != nullptr)
+        {
+            m_stageBuffer->unmap();
+            m_stageBuffer->release();
+            m_stageBuffer.reset();
+        }
+    }
+
+    // Uploader manager
+    void AsyncUploaderManager::init()
+    {
+        // Static and dynamic uploaders work on different copy queues, device ensures more than one
+        const auto& copyPools = VulkanRHI::get()->getAsyncCopyCommandPools();
+        VT_CORE_ASSERT(copyPools.size() > 1, "Async uploader needs at least two copy queues");
+
+        m_staticUploader = CreateScope<StaticAsyncUploader>(*this, copyPools.front().queue, copyPools.front().pool);
+        m_dynamicUploader = CreateScope<DynamicAsyncUploader>(*this, copyPools.back().queue, copyPools.back().pool);
+
+        m_staticUploader->start();
+        m_dynamicUploader->start();
+    }
+
+    void AsyncUploaderManager::release()
+    {
+        m_staticUploader->stop();
+        m_dynamicUploader->stop();
+        m_staticUploader.reset();
+        m_dynamicUploader.reset();
+
+        {
+            std::lock_guard<std::mutex> lock(m_finishMutex);
+            m_finishedTasks.clear();
+        }
+        m_workingTaskCount.store(0);
+
+        recycleAcquireSubmissions(true);
+    }
+
+    void AsyncUploaderManager::addTask(Ref<AssetLoadTask> inTask)
+    {
+        m_workingTaskCount.fetch_add(1);
+        if (inTask->getUploadSize() >= GDynamicUploaderMinSize)
+        {
+            m_dynamicUploader->addTask(std::move(inTask));
+        } else
+        {
+            m_staticUploader->addTask(std::move(inTask));
+        }
+    }
+
+    void AsyncUploaderManager::onTasksFinished(std::vector<Ref<AssetLoadTask>> &tasks)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_finishMutex);
+            m_finishedTasks.insert(m_finishedTasks.end(), tasks.begin(), tasks.end());
+        }
+        m_finishCondition.notify_all();
+    }
+
+    void AsyncUploaderManager::tick()
+    {
+        recycleAcquireSubmissions(false);
+
+        std::vector<Ref<AssetLoadTask>> finishedTasks;
+        {
+            std::lock_guard<std::mutex> lock(m_finishMutex);
+            finishedTasks.swap(m_finishedTasks);
+        }
+        if (finishedTasks.empty())
+        {
+            return;
+        }
+
+        // Queue family ownership acquire, later submits on the same queue see uploaded data
+        AcquireSubmission submission{};
+        VkCommandBufferAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandPool = VulkanRHI::get()->getMajorGraphicsCommandPool();
+        allocateInfo.commandBufferCount = 1;
+        RHICheck(vkAllocateCommandBuffers(VulkanRHI::Device, &allocateInfo, &submission.cmd));
+
+        VkCommandBufferBeginInfo beginInfo = Initializers::initCommandBufferBeginInfo();
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        RHICheck(vkBeginCommandBuffer(submission.cmd, &beginInfo));
+
+        CommandBufferBase commandBuffer{ submission.cmd, allocateInfo.commandPool, VulkanRHI::get()->getGraphicsFamily() };
+        for (auto& task : finishedTasks)
+        {
+            task->acquireOwnership(commandBuffer);
+        }
+
+        RHICheck(vkEndCommandBuffer(submission.cmd));
+        VulkanSubmitInfo submitInfo{};
+        submitInfo.setCommandBuffer(&submission.cmd, 1);
+        // Signals frame timeline, no fence of its own
+        submission.timelineValue = VulkanRHI::get()->submitWithTimeline(submitInfo.getSubmitInfo());
+        m_acquireSubmissions.push_back(submission);
+
+        for (auto& task : finishedTasks)
+        {
+            task->finishCallback();
+        }
+        m_workingTaskCount.fetch_sub(static_cast<uint32_t>(finishedTasks.size()));
+    }
+
+    void AsyncUploaderManager::flush()
+    {
+        while (isBusy())
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_finishMutex);
+                m_finishCondition.wait(lock, [this]() { return !m_finishedTasks.empty(); });
+            }
+            tick();
+        }
+    }
+
+    void AsyncUploaderManager::recycleAcquireSubmissions(bool isWait)
+    {
+        std::erase_if(m_acquireSubmissions, [isWait](const AcquireSubmission &submission)
+        {
+            if (isWait)
+            {
+                VulkanRHI::get()->waitTimeline(submission.timelineValue, DEFAULT_FENCE_TIMEOUT);
+            } else if (!VulkanRHI::get()->isTimelineReached(submission.timelineValue))
+            {
+                return false;
+            }
+
+            vkFreeCommandBuffers(VulkanRHI::Device, VulkanRHI::get()->getMajorGraphicsCommandPool(), 1, &submission.cmd);
+            return true;
+        });
+    }
+}
@@ -5,14 +5,17 @@
 
 #include <VulkanToy/AssetSystem/MeshManager.h>
 #include <VulkanToy/AssetSystem/AssimpModelProcess.h>
+#include <VulkanToy/AssetSystem/MeshOptimizer.h>
+#include <VulkanToy/AssetSystem/MeshSimplifier.h>
+#include <VulkanToy/AssetSystem/AssetSystem.h>
 #include <VulkanToy/VulkanRHI/VulkanRHI.h>
 
 namespace VT
 {
-    const UUID EngineMeshes::GBoxUUID = "12a68c4e-8352-4d97-a914-a0f4f4d1fd28";
-    const UUID EngineMeshes::GSphereUUID = "45f0d878-6d3f-11ed-a1eb-0242ac120002";
-    const UUID EngineMeshes::GCerberusUUID = "76f0v327-6d3e-41ui-n92j-9733lk128178";
-    const UUID EngineMeshes::GSkyBoxUUID = "90nhgo521-pxki-ilfg-kh43-0ui6lk163e3";
+    const UUID EngineMeshes::GBoxUUID = UUID::fromString("12a68c4e-8352-4d97-a914-a0f4f4d1fd28").value();
+    const UUID EngineMeshes::GSphereUUID = UUID::fromString("45f0d878-6d3f-11ed-a1eb-0242ac120002").value();
+    const UUID EngineMeshes::GCerberusUUID = UUID::fromString("76f0a327-6d3e-41c1-b92f-9733ac128178").value();
+    const UUID EngineMeshes::GSkyBoxUUID = UUID::fromString("90b4a521-5d2c-4e1f-8f43-0c16ad163e3a").value();
 
     std::weak_ptr<GPUMeshAsset> EngineMeshes::GBoxPtrRef = {};
     std::weak_ptr<GPUMeshAsset> EngineMeshes::GSpherePtrRef = {};
@@ -26,17 +29,25 @@ namespace VT
         return "MeshAssetId:" + std::to_string(GRuntimeId) + in;
     }
 
-    static uint32_t indexTypeToSize(VkIndexType type)
+    // Queue family ownership transfer from copy queue to graphics queue
+    static void recordBufferOwnershipBarrier(VkCommandBuffer cmd, VkBuffer buffer,
+                                            VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
+                                            VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
     {
-        switch (type)
-        {
-            case VK_INDEX_TYPE_UINT16:    return sizeof(uint16_t);
-            case VK_INDEX_TYPE_UINT32:    return sizeof(uint32_t);
-            case VK_INDEX_TYPE_UINT8_EXT: return sizeof(uint8_t);
-            default:
-                VT_CORE_CRITICAL("Unknown VkIndexType");
-        }
-        return 0;
+        const uint32_t copyFamily = VulkanRHI::get()->getCopyFamily();
+        const uint32_t graphicsFamily = VulkanRHI::get()->getGraphicsFamily();
+        const bool isSameFamily = copyFamily == graphicsFamily;
+
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccessMask;
+        barrier.dstAccessMask = dstAccessMask;
+        barrier.srcQueueFamilyIndex = isSameFamily ? VK_QUEUE_FAMILY_IGNORED : copyFamily;
+        barrier.dstQueueFamilyIndex = isSameFamily ? VK_QUEUE_FAMILY_IGNORED : graphicsFamily;
+        barrier.buffer = buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
     }
 
     // Immediately build GPU mesh asset
@@ -48,7 +59,8 @@ namespace VT
         VT_CORE_ASSERT(m_vertexBuffer == nullptr, "Ensure that GPU mesh asset initialized only once");
         VT_CORE_ASSERT(m_indexBuffer == nullptr, "Ensure that GPU mesh asset initialized only once");
 
-        auto bufferFlagBasic = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        // Storage usage lets shaders fetch mesh data through bindless heap
+        auto bufferFlagBasic = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
         VmaAllocationCreateFlags vmaBufferFlags{};
 
         m_vertexBuffer = VulkanBuffer::create2(
@@ -72,6 +84,14 @@ namespace VT
         m_singleVertexSize = uint32_t(singleVertexSize);
         m_vertexCount = uint32_t(vertexSize) / m_singleVertexSize;
         m_vertexFloat32Count = uint32_t(vertexSize) / sizeof(float);
+
+        StaticMeshSubMesh wholeMesh{};
+        wholeMesh.indexCount = m_indexCount;
+        m_subMeshes.push_back(wholeMesh);
+
+        StaticMeshLod wholeLod{};
+        wholeLod.indexCount = m_indexCount;
+        m_lods.push_back(wholeLod);
     }
 
     GPUMeshAsset::GPUMeshAsset(const std::string &name, bool isPersistent)
@@ -82,9 +102,10 @@ namespace VT
 
     GPUMeshAsset::~GPUMeshAsset()
     {
+        // Transient asset is evicted from cache, release when last reference drops
         if (!m_isPersistent)
         {
-            // TODO
+            release();
         }
 
         m_vertexBuffer.reset();
@@ -93,48 +114,73 @@ namespace VT
 
     void GPUMeshAsset::release()
     {
-        m_vertexBuffer->release();
-        m_indexBuffer->release();
+        auto &bindlessHeap = VulkanRHI::get()->getBindlessHeap();
+        bindlessHeap.releaseStorageBuffer(m_vertexBindlessIndex);
+        bindlessHeap.releaseStorageBuffer(m_indexBindlessIndex);
+        m_vertexBindlessIndex = std::numeric_limits<uint32_t>::max();
+        m_indexBindlessIndex = std::numeric_limits<uint32_t>::max();
+
+        if (m_vertexBuffer != nullptr)
+        {
+            m_vertexBuffer->release();
+        }
+        if (m_indexBuffer != nullptr)
+        {
+            m_indexBuffer->release();
+        }
     }
 
-    void GPUMeshAsset::prepareToUpload()
+    void GPUMeshAsset::setSubMeshes(std::vector<StaticMeshSubMesh> subMeshes)
     {
-        // TODO
+        if (subMeshes.empty())
+        {
+            return;
+        }
+        m_subMeshes = std::move(subMeshes);
+        m_renderBound = StaticMeshSubMesh::mergeBounds(m_subMeshes);
     }
 
-    void GPUMeshAsset::finishUpload()
+    void GPUMeshAsset::setLods(std::vector<StaticMeshLod> lods)
     {
-        // TODO: separate
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = m_vertexBuffer->getBuffer();
-        bufferInfo.offset = 0;
-        bufferInfo.range  = m_vertexBuffer->getMemorySize();    // TODO: fix
-        VkWriteDescriptorSet write{};
-        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        VkDescriptorSet descriptorSetUpdateAfterBind{};
-        write.dstSet = descriptorSetUpdateAfterBind;
-        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        write.dstBinding = 0;
-        write.pBufferInfo = &bufferInfo;
-        write.descriptorCount = 1;
-        write.dstArrayElement = 0;  // TODO: fix
-        vkUpdateDescriptorSets(VulkanRHI::Device, 1, &write, 0, nullptr);
-
-        // TODO: separate
-        VkDescriptorBufferInfo bufferInfo2{};
-        bufferInfo2.buffer = m_indexBuffer->getBuffer();
-        bufferInfo2.offset = 0;
-        bufferInfo2.range  = m_indexBuffer->getMemorySize();
-        VkWriteDescriptorSet write2{};
-        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        VkDescriptorSet descriptorSetUpdateAfterBind2{};
-        write.dstSet = descriptorSetUpdateAfterBind2;
-        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        write.dstBinding = 0;
-        write.pBufferInfo = &bufferInfo2;
-        write.descriptorCount = 1;
-        write.dstArrayElement = 0;  // TODO: fix
-        vkUpdateDescriptorSets(VulkanRHI::Device, 1, &write2, 0, nullptr);
+        if (lods.empty())
+        {
+            return;
+        }
+        m_lods = std::move(lods);
+    }
+
+    void GPUMeshAsset::prepareToUpload(CommandBufferBase &cmd)
+    {
+        // New buffers, no previous access to wait
+    }
+
+    void GPUMeshAsset::finishUpload(CommandBufferBase &cmd)
+    {
+        recordBufferOwnershipBarrier(cmd.cmd, m_vertexBuffer->getBuffer(), VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+        recordBufferOwnershipBarrier(cmd.cmd, m_indexBuffer->getBuffer(), VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    }
+
+    void GPUMeshAsset::acquireOwnership(CommandBufferBase &cmd)
+    {
+        recordBufferOwnershipBarrier(cmd.cmd, m_vertexBuffer->getBuffer(), 0, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+        recordBufferOwnershipBarrier(cmd.cmd, m_indexBuffer->getBuffer(), 0, VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+                                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+    }
+
+    void GPUMeshAsset::registerBindless()
+    {
+        auto &bindlessHeap = VulkanRHI::get()->getBindlessHeap();
+        if (m_vertexBindlessIndex == std::numeric_limits<uint32_t>::max())
+        {
+            m_vertexBindlessIndex = bindlessHeap.registerStorageBuffer(m_vertexBuffer->getBuffer());
+        }
+        if (m_indexBindlessIndex == std::numeric_limits<uint32_t>::max())
+        {
+            m_indexBindlessIndex = bindlessHeap.registerStorageBuffer(m_indexBuffer->getBuffer());
+        }
     }
 
     void MeshContext::init()
@@ -142,51 +188,348 @@ namespace VT
         m_GPUCache = CreateScope<GPUAssetCache<GPUMeshAsset>>(512, 256);
     }
 
+    void MeshContext::tick()
+    {
+        m_GPUCache->tick();
+    }
+
     void MeshContext::release()
     {
         m_GPUCache->clear();
         m_GPUCache.reset();
     }
 
-    void StaticMeshRawDataLoadTask::uploadDevice(uint32_t stageBufferOffset, void *mapped,
-                                                CommandBufferBase &commandBuffer, VulkanBuffer &stageBuffer)
+    // Copy index and vertex data into stage buffer and record copies to mesh buffers
+    static void recordMeshUpload(GPUMeshAsset &meshAsset,
+                                const uint8_t *indexData, size_t indexSize,
+                                const uint8_t *vertexData, size_t vertexSize,
+                                uint32_t stageBufferOffset, void *mapped,
+                                CommandBufferBase &commandBuffer, VulkanBuffer &stageBuffer)
     {
-        VT_CORE_ASSERT(AssetMeshLoadTask::getUploadSize() == static_cast<uint32_t>(cacheVertexData.size() + cacheIndexData.size()), "Upload device size mismatch");
-
-        uint32_t indexOffsetInSrcBuffer = 0;
-        uint32_t vertexOffsetInSrcBuffer = indexOffsetInSrcBuffer + static_cast<uint32_t>(cacheIndexData.size());
+        // Mapped points to stage buffer offset already, copy regions need the absolute offset
+        uint32_t indexOffsetInMapped = 0;
+        uint32_t vertexOffsetInMapped = indexOffsetInMapped + static_cast<uint32_t>(indexSize);
 
-        std::memcpy((void *)((char *)mapped + indexOffsetInSrcBuffer), cacheIndexData.data(), cacheIndexData.size());
-        std::memcpy((void *)((char *)mapped + vertexOffsetInSrcBuffer), cacheVertexData.data(), cacheVertexData.size());
+        std::memcpy((void *)((char *)mapped + indexOffsetInMapped), indexData, indexSize);
+        std::memcpy((void *)((char *)mapped + vertexOffsetInMapped), vertexData, vertexSize);
 
-        // TODO: check
-        meshAssetGPU->prepareToUpload();
+        meshAsset.prepareToUpload(commandBuffer);
 
         {
             VkBufferCopy regionIndex{};
-            regionIndex.size = VkDeviceSize(cacheIndexData.size());
-            regionIndex.srcOffset = indexOffsetInSrcBuffer;
+            regionIndex.size = VkDeviceSize(indexSize);
+            regionIndex.srcOffset = stageBufferOffset + indexOffsetInMapped;
             regionIndex.dstOffset = 0;
-            vkCmdCopyBuffer(commandBuffer.cmd, stageBuffer.getBuffer(), meshAssetGPU->getIndexBuffer(), 1, &regionIndex);
+            vkCmdCopyBuffer(commandBuffer.cmd, stageBuffer.getBuffer(), meshAsset.getIndexBuffer(), 1, &regionIndex);
         }
 
         {
             VkBufferCopy regionVertex{};
-            regionVertex.size = VkDeviceSize(cacheVertexData.size());
-            regionVertex.srcOffset = vertexOffsetInSrcBuffer;
+            regionVertex.size = VkDeviceSize(vertexSize);
+            regionVertex.srcOffset = stageBufferOffset + vertexOffsetInMapped;
             regionVertex.dstOffset = 0;
-            vkCmdCopyBuffer(commandBuffer.cmd, stageBuffer.getBuffer(), meshAssetGPU->getVertexBuffer(), 1, &regionVertex);
+            vkCmdCopyBuffer(commandBuffer.cmd, stageBuffer.getBuffer(), meshAsset.getVertexBuffer(), 1, &regionVertex);
         }
 
-        // TODO: check
-        meshAssetGPU->finishUpload();
+        meshAsset.finishUpload(commandBuffer);
+    }
+
+    static uint64_t alignCookedOffset(uint64_t offset)
+    {
+        return (offset + GCookedMeshAlignment - 1) & ~(GCookedMeshAlignment - 1);
+    }
+
+    StaticMeshAssetBin::StaticMeshAssetBin(const std::string &name,
+                                        std::vector<StaticMeshVertex> vertices,
+                                        std::vector<VertexIndexType> indices,
+                                        std::vector<StaticMeshSubMesh> subMeshes,
+                                        std::vector<StaticMeshLod> lods)
+    : AssetBinInterface(buildUUID(), name),
+    m_vertices(std::move(vertices)), m_indices(std::move(indices)), m_subMeshes(std::move(subMeshes)), m_lods(std::move(lods))
+    {
+        m_renderBound = StaticMeshSubMesh::mergeBounds(m_subMeshes);
+        if (m_lods.empty())
+        {
+            m_lods.push_back(StaticMeshLod{ .indexCount = static_cast<uint32_t>(m_indices.size()) });
+        }
+    }
+
+    Ref<StaticMeshAssetBin> StaticMeshAssetBin::importFromModel(const std::string &name, const std::filesystem::path &path)
+    {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path.string(),
+            aiProcessPreset_TargetRealtime_Fast | aiProcess_FlipUVs | aiProcess_GenBoundingBoxes |
+                aiProcess_PreTransformVertices | aiProcess_OptimizeMeshes | aiProcess_Debone | aiProcess_ValidateDataStructure);
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        {
+            VT_CORE_ERROR("Error::Assimp::{0}", importer.GetErrorString());
+            return nullptr;
+        }
+
+        AssimpModelProcess processor{ path.parent_path() };
+        processor.processScene(scene);
+        if (processor.m_indices.empty())
+        {
+            VT_CORE_ERROR("Model '{0}' has no triangle to import", path.string());
+            return nullptr;
+        }
+
+        // Append LOD chain, then reorder every range for post transform cache, overdraw and vertex fetch
+        // Cooked file keeps the result
+        auto lods = MeshSimplifier::buildLodChain(name, processor.m_vertices, processor.m_indices, processor.m_subMeshInfos);
+        MeshOptimizer::optimize(name, processor.m_vertices, processor.m_indices, processor.m_subMeshInfos, lods);
+
+        return CreateRef<StaticMeshAssetBin>(name,
+                                            std::move(processor.m_vertices),
+                                            std::move(processor.m_indices),
+                                            std::move(processor.m_subMeshInfos),
+                                            std::move(lods));
+    }
+
+    std::vector<StaticMeshCompactVertex> StaticMeshAssetBin::getCompactVertices(glm::vec3 &outPositionOffset,
+                                                                                glm::vec3 &outPositionScale) const
+    {
+        StaticMeshCompactVertex::computeQuantization(m_vertices, outPositionOffset, outPositionScale);
+
+        std::vector<StaticMeshCompactVertex> compactVertices(m_vertices.size());
+        for (size_t index = 0; index < m_vertices.size(); ++index)
+        {
+            compactVertices[index] = StaticMeshCompactVertex::encode(m_vertices[index], outPositionOffset, outPositionScale);
+        }
+        return compactVertices;
+    }
+
+    bool StaticMeshAssetBin::saveCooked(const std::filesystem::path &path, VertexFormat vertexFormat) const
+    {
+        // Material names are packed into one blob referenced by sub-mesh table
+        std::string nameBlob{};
+        std::vector<CookedSubMesh> cookedSubMeshes(m_subMeshes.size());
+        for (size_t index = 0; index < m_subMeshes.size(); ++index)
+        {
+            cookedSubMeshes[index].renderBound = m_subMeshes[index].renderBound;
+            cookedSubMeshes[index].indexStartPosition = m_subMeshes[index].indexStartPosition;
+            cookedSubMeshes[index].indexCount = m_subMeshes[index].indexCount;
+            cookedSubMeshes[index].materialNameOffset = static_cast<uint32_t>(nameBlob.size());
+            cookedSubMeshes[index].materialNameSize = static_cast<uint32_t>(m_subMeshes[index].material.size());
+            nameBlob += m_subMeshes[index].material;
+        }
+
+        CookedMeshHeader header{};
+        std::vector<StaticMeshCompactVertex> compactVertices{};
+        const void *vertexData = m_vertices.data();
+        if (vertexFormat == VertexFormat::Compact)
+        {
+            compactVertices = getCompactVertices(header.positionOffset, header.positionScale);
+            vertexData = compactVertices.data();
+        }
+        const uint32_t vertexStride = getVertexFormatStride(vertexFormat);
+
+        std::vector<uint16_t> narrowedIndices{};
+        const void *indexData = m_indices.data();
+        const VkIndexType indexType = getIndexTypeForVertexCount(m_vertices.size());
+        if (indexType == VK_INDEX_TYPE_UINT16)
+        {
+            narrowedIndices = narrowIndices(m_indices);
+            indexData = narrowedIndices.data();
+        }
+        const uint32_t indexStride = indexTypeToSize(indexType);
+
+        header.vertexFormat = static_cast<uint32_t>(vertexFormat);
+        header.vertexStride = vertexStride;
+        header.indexStride = indexStride;
+        header.vertexCount = static_cast<uint32_t>(m_vertices.size());
+        header.indexCount = static_cast<uint32_t>(m_indices.size());
+        header.subMeshCount = static_cast<uint32_t>(cookedSubMeshes.size());
+        header.renderBound = m_renderBound;
+        header.lodCount = static_cast<uint32_t>(std::min<size_t>(m_lods.size(), GMaxMeshLodCount));
+        std::copy_n(m_lods.begin(), header.lodCount, header.lods);
+        header.vertexOffset = alignCookedOffset(sizeof(CookedMeshHeader));
+        header.indexOffset = alignCookedOffset(header.vertexOffset + m_vertices.size() * vertexStride);
+        header.subMeshOffset = alignCookedOffset(header.indexOffset + m_indices.size() * indexStride);
+        header.nameOffset = alignCookedOffset(header.subMeshOffset + cookedSubMeshes.size() * sizeof(CookedSubMesh));
+        header.nameSize = nameBlob.size();
+
+        // Write to temporary file first, a broken cook never shadows the model file
+        auto tempPath = path;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                VT_CORE_WARN("Fail to open cooked mesh file '{0}' for writing", tempPath.string());
+                return false;
+            }
+
+            auto writeSection = [&file](uint64_t offset, const void *data, size_t size)
+            {
+                static constexpr char zeros[GCookedMeshAlignment] = {};
+                const auto position = static_cast<uint64_t>(file.tellp());
+                file.write(zeros, static_cast<std::streamsize>(offset - position));
+                file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            };
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            writeSection(header.vertexOffset, vertexData, m_vertices.size() * vertexStride);
+            writeSection(header.indexOffset, indexData, m_indices.size() * indexStride);
+            writeSection(header.subMeshOffset, cookedSubMeshes.data(), cookedSubMeshes.size() * sizeof(CookedSubMesh));
+            writeSection(header.nameOffset, nameBlob.data(), nameBlob.size());
+
+            if (!file.good())
+            {
+                VT_CORE_WARN("Fail to write cooked mesh file '{0}'", tempPath.string());
+                return false;
+            }
+        }
+
+        std::error_code errorCode{};
+        std::filesystem::rename(tempPath, path, errorCode);
+        if (errorCode)
+        {
+            VT_CORE_WARN("Fail to replace cooked mesh file '{0}': {1}", path.string(), errorCode.message());
+            std::filesystem::remove(tempPath, errorCode);
+            return false;
+        }
+        return true;
+    }
+
+    bool StaticMeshAssetBin::cook(const std::filesystem::path &modelPath, const std::filesystem::path &cookedPath,
+                                VertexFormat vertexFormat)
+    {
+        auto meshBin = importFromModel(modelPath.filename().string(), modelPath);
+        if (meshBin == nullptr)
+        {
+            return false;
+        }
+        return meshBin->saveCooked(cookedPath, vertexFormat);
+    }
+
+    std::filesystem::path StaticMeshAssetBin::getCookedPath(const std::filesystem::path &modelPath, VertexFormat vertexFormat)
+    {
+        auto cookedPath = modelPath;
+        if (vertexFormat == VertexFormat::Compact)
+        {
+            cookedPath += ".compact";
+        }
+        cookedPath += GCookedMeshExtension;
+        return cookedPath;
+    }
+
+    void StaticMeshRawDataLoadTask::uploadDevice(uint32_t stageBufferOffset, void *mapped,
+                                                CommandBufferBase &commandBuffer, VulkanBuffer &stageBuffer)
+    {
+        VT_CORE_ASSERT(AssetMeshLoadTask::getUploadSize() >= getUploadSize(), "Upload device size mismatch");
+
+        recordMeshUpload(*meshAssetGPU, cacheIndexData.data(), cacheIndexData.size(),
+                        cacheVertexData.data(), cacheVertexData.size(),
+                        stageBufferOffset, mapped, commandBuffer, stageBuffer);
+    }
+
+    void StaticMeshCookedLoadTask::uploadDevice(uint32_t stageBufferOffset, void *mapped,
+                                                CommandBufferBase &commandBuffer, VulkanBuffer &stageBuffer)
+    {
+        VT_CORE_ASSERT(AssetMeshLoadTask::getUploadSize() >= getUploadSize(), "Upload device size mismatch");
+
+        // Page faults of file mapping happen here on uploader thread, not on the thread requested the mesh
+        recordMeshUpload(*meshAssetGPU, indexData, indexSize, vertexData, vertexSize,
+                        stageBufferOffset, mapped, commandBuffer, stageBuffer);
+    }
+
+    Ref<StaticMeshCookedLoadTask> StaticMeshCookedLoadTask::buildFromCooked(const std::string &name,
+                                                                            const std::filesystem::path &cookedPath,
+                                                                            const UUID &uuid, bool isPersistent,
+                                                                            VertexFormat vertexFormat)
+    {
+        auto mappedFile = MappedFile::create(cookedPath);
+        if (mappedFile == nullptr)
+        {
+            return nullptr;
+        }
+
+        const uint8_t *data = mappedFile->getData();
+        const uint64_t fileSize = mappedFile->getSize();
+        if (fileSize < sizeof(CookedMeshHeader))
+        {
+            VT_CORE_WARN("Cooked mesh file '{0}' is truncated", cookedPath.string());
+            return nullptr;
+        }
+
+        CookedMeshHeader header{};
+        std::memcpy(&header, data, sizeof(header));
+        const uint64_t vertexSize = uint64_t(header.vertexCount) * getVertexFormatStride(vertexFormat);
+        const VkIndexType indexType = getIndexTypeForVertexCount(header.vertexCount);
+        const uint64_t indexSize = uint64_t(header.indexCount) * indexTypeToSize(indexType);
+        const uint64_t subMeshSize = uint64_t(header.subMeshCount) * sizeof(CookedSubMesh);
+        const bool isValid = header.magic == GCookedMeshMagic && header.version == GCookedMeshVersion &&
+            header.vertexFormat == static_cast<uint32_t>(vertexFormat) &&
+            header.vertexStride == getVertexFormatStride(vertexFormat) && header.indexStride == indexTypeToSize(indexType) &&
+            header.vertexCount > 0 && header.indexCount > 0 && header.lodCount > 0 && header.lodCount <= GMaxMeshLodCount &&
+            header.vertexOffset + vertexSize <= fileSize && header.indexOffset + indexSize <= fileSize &&
+            header.subMeshOffset + subMeshSize <= fileSize && header.nameOffset + header.nameSize <= fileSize;
+        if (!isValid)
+        {
+            VT_CORE_WARN("Cooked mesh file '{0}' is invalid or out of date", cookedPath.string());
+            return nullptr;
+        }
+
+        // Sub-mesh table is tiny, everything else stays in the mapping
+        std::vector<StaticMeshSubMesh> subMeshes(header.subMeshCount);
+        const char *nameBlob = reinterpret_cast<const char *>(data + header.nameOffset);
+        for (uint32_t index = 0; index < header.subMeshCount; ++index)
+        {
+            CookedSubMesh cookedSubMesh{};
+            std::memcpy(&cookedSubMesh, data + header.subMeshOffset + index * sizeof(CookedSubMesh), sizeof(CookedSubMesh));
+            if (uint64_t(cookedSubMesh.indexStartPosition) + cookedSubMesh.indexCount > header.indexCount ||
+                uint64_t(cookedSubMesh.materialNameOffset) + cookedSubMesh.materialNameSize > header.nameSize)
+            {
+                VT_CORE_WARN("Cooked mesh file '{0}' has invalid sub-mesh", cookedPath.string());
+                return nullptr;
+            }
+
+            subMeshes[index].renderBound = cookedSubMesh.renderBound;
+            subMeshes[index].indexStartPosition = cookedSubMesh.indexStartPosition;
+            subMeshes[index].indexCount = cookedSubMesh.indexCount;
+            subMeshes[index].material.assign(nameBlob + cookedSubMesh.materialNameOffset, cookedSubMesh.materialNameSize);
+        }
+
+        std::vector<StaticMeshLod> lods(header.lods, header.lods + header.lodCount);
+        for (const auto& lod : lods)
+        {
+            if (uint64_t(lod.indexStartPosition) + lod.indexCount > header.indexCount)
+            {
+                VT_CORE_WARN("Cooked mesh file '{0}' has invalid LOD", cookedPath.string());
+                return nullptr;
+            }
+        }
+
+        auto newTask = CreateRef<StaticMeshCookedLoadTask>();
+        newTask->vertexData = data + header.vertexOffset;
+        newTask->vertexSize = vertexSize;
+        newTask->indexData = data + header.indexOffset;
+        newTask->indexSize = indexSize;
+        newTask->mappedFile = std::move(mappedFile);
+
+        auto newAsset = CreateRef<GPUMeshAsset>(
+                name,
+                isPersistent,
+                vertexSize,
+                getVertexFormatStride(vertexFormat),
+                indexSize,
+                indexType);
+        newAsset->setSubMeshes(std::move(subMeshes));
+        newAsset->setLods(std::move(lods));
+        newAsset->setVertexFormat(vertexFormat, header.positionOffset, header.positionScale);
+        MeshManager::Get()->insertGPUAsset(uuid, newAsset);
+        newTask->meshAssetGPU = newAsset;
+
+        return newTask;
     }
 
     Ref<StaticMeshRawDataLoadTask> StaticMeshRawDataLoadTask::buildFromData(const std::string &name, const UUID &uuid,
                                                                             bool isPersistent, uint8_t *indices,
                                                                             size_t indexSize, VkIndexType indexType,
                                                                             uint8_t *vertices, size_t vertexSize,
-                                                                            size_t singleVertexSize)
+                                                                            size_t singleVertexSize,
+                                                                            std::vector<StaticMeshSubMesh> subMeshes,
+                                                                            std::vector<StaticMeshLod> lods)
     {
         if (isPersistent)
         {
@@ -213,6 +556,8 @@ namespace VT
                 singleVertexSize,
                 indexSize,
                 indexType);
+        newAsset->setSubMeshes(std::move(subMeshes));
+        newAsset->setLods(std::move(lods));
         MeshManager::Get()->insertGPUAsset(uuid, newAsset);
         newTask->meshAssetGPU = newAsset;
 
@@ -220,8 +565,10 @@ namespace VT
     }
 
     void StaticMeshRawDataLoadTask::buildFromPath(const std::string &name, const std::filesystem::path &path,
-                                                                            const UUID &uuid, bool isPersistent)
+                                                                            const UUID &uuid, bool isPersistent,
+                                                                            VertexFormat vertexFormat)
     {
+        VT_PROFILE_SCOPE_DYNAMIC(name);
         if (isPersistent)
         {
             if (MeshManager::Get()->isAssetExist(uuid))
@@ -231,69 +578,77 @@ namespace VT
             }
         }
 
-        Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path.string(),
-            aiProcessPreset_TargetRealtime_Fast | aiProcess_FlipUVs | aiProcess_GenBoundingBoxes |
-                aiProcess_PreTransformVertices | aiProcess_OptimizeMeshes | aiProcess_Debone | aiProcess_ValidateDataStructure);
-        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        // Cooked container is up to date, or shipped without model file
+        const auto cookedPath = StaticMeshAssetBin::getCookedPath(path, vertexFormat);
+        std::error_code modelError{};
+        std::error_code cookedError{};
+        const auto modelTime = std::filesystem::last_write_time(path, modelError);
+        const auto cookedTime = std::filesystem::last_write_time(cookedPath, cookedError);
+        const bool isCookedValid = !cookedError && (modelError || cookedTime >= modelTime);
+
+        if (isCookedValid)
         {
-            VT_CORE_ERROR("Error::Assimp::{0}", importer.GetErrorString());
-            return;
+            if (auto cookedTask = StaticMeshCookedLoadTask::buildFromCooked(name, cookedPath, uuid, isPersistent, vertexFormat))
+            {
+                AssetSystemHandle::Get()->addUploadTask(cookedTask);
+                return;
+            }
         }
 
-        AssimpModelProcess processor{ path.parent_path() };
-        processor.processMesh(scene->mMeshes[0], scene);
-
-        // Create staging vertex and index buffers, and copy vertex and index data from model
-        VkDeviceSize vertexBufferSize = sizeof(StaticMeshVertex) * processor.m_vertices.size();
-        VkDeviceSize indexBufferSize = sizeof(VertexIndexType) * processor.m_indices.size();
-
-        auto stagingVertexBuffer = VulkanBuffer::create2("Staging vertex buffer",
-                                                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                    VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT,
-                                                    vertexBufferSize);
-        auto stagingIndexBuffer = VulkanBuffer::create2("Staging index buffer",
-                                                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                                        VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT,
-                                                        indexBufferSize);
-
-        RHICheck(stagingVertexBuffer->map());
-        stagingVertexBuffer->copyData(processor.m_vertices.data(), static_cast<size_t>(vertexBufferSize));
-        stagingVertexBuffer->unmap();
-        RHICheck(stagingIndexBuffer->map());
-        stagingIndexBuffer->copyData(processor.m_indices.data(), static_cast<size_t>(indexBufferSize));
-        stagingIndexBuffer->unmap();
-
-        // Create mesh asset
-        VT_CORE_ASSERT(sizeof(VertexIndexType) == 4, "Currently VertexIndexType must be uint32_t");
-        auto newMeshAsset = CreateRef<GPUMeshAsset>(
-                name,
-                isPersistent,
-                processor.m_vertices.size() * sizeof(processor.m_vertices[0]),
-                sizeof(processor.m_vertices[0]),
-                processor.m_indices.size() * sizeof(processor.m_indices[0]),
-                VK_INDEX_TYPE_UINT32);
-
-        // Copy vertex and index buffers into mesh asset
-        VulkanRHI::executeImmediatelyMajorGraphics([stagingVertexBuffer, stagingIndexBuffer, newMeshAsset] (VkCommandBuffer cmd)
+        auto meshBin = StaticMeshAssetBin::importFromModel(name, path);
+        if (meshBin == nullptr)
         {
-            VkBufferCopy  copyRegionVertex{};
-            copyRegionVertex.size = stagingVertexBuffer->getMemorySize();
-            vkCmdCopyBuffer(cmd, stagingVertexBuffer->getBuffer(), newMeshAsset->getVertexBuffer(), 1, &copyRegionVertex);
+            return;
+        }
 
-            VkBufferCopy copyRegionIndex{};
-            copyRegionIndex.size = stagingIndexBuffer->getMemorySize();
-            vkCmdCopyBuffer(cmd, stagingIndexBuffer->getBuffer(), newMeshAsset->getIndexBuffer(), 1, &copyRegionIndex);
-        });
+        // Cook once, later launches map the container directly
+        if (meshBin->saveCooked(cookedPath, vertexFormat))
+        {
+            if (auto cookedTask = StaticMeshCookedLoadTask::buildFromCooked(name, cookedPath, uuid, isPersistent, vertexFormat))
+            {
+                AssetSystemHandle::Get()->addUploadTask(cookedTask);
+                return;
+            }
+        }
 
-        // Release staging vertex and index buffers
-        stagingVertexBuffer->release();
-        stagingIndexBuffer->release();
+        // Build load task and insert GPU mesh asset, asset keep loading state until upload finish
+        const auto& indices = meshBin->getIndices();
+        std::vector<uint16_t> narrowedIndices{};
+        const uint8_t *indexData = reinterpret_cast<const uint8_t *>(indices.data());
+        const VkIndexType indexType = getIndexTypeForVertexCount(meshBin->getVertices().size());
+        if (indexType == VK_INDEX_TYPE_UINT16)
+        {
+            narrowedIndices = narrowIndices(indices);
+            indexData = reinterpret_cast<const uint8_t *>(narrowedIndices.data());
+        }
+        glm::vec3 positionOffset{ 0.0f };
+        glm::vec3 positionScale{ 1.0f };
+        std::vector<StaticMeshCompactVertex> compactVertices{};
+        const uint8_t *vertexData = reinterpret_cast<const uint8_t *>(meshBin->getVertices().data());
+        if (vertexFormat == VertexFormat::Compact)
+        {
+            compactVertices = meshBin->getCompactVertices(positionOffset, positionScale);
+            vertexData = reinterpret_cast<const uint8_t *>(compactVertices.data());
+        }
+        const uint32_t vertexStride = getVertexFormatStride(vertexFormat);
 
-        // Insert GPU mesh asset
-        MeshManager::Get()->insertGPUAsset(uuid, newMeshAsset);
+        auto newTask = buildFromData(
+                name,
+                uuid,
+                isPersistent,
+                const_cast<uint8_t *>(indexData),
+                indices.size() * indexTypeToSize(indexType),
+                indexType,
+                const_cast<uint8_t *>(vertexData),
+                meshBin->getVertices().size() * vertexStride,
+                vertexStride,
+                meshBin->getSubMeshes(),
+                meshBin->getLods());
+        if (newTask != nullptr)
+        {
+            newTask->meshAssetGPU->setVertexFormat(vertexFormat, positionOffset, positionScale);
+            AssetSystemHandle::Get()->addUploadTask(newTask);
+        }
     }
 }
 
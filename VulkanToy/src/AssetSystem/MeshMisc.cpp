@@ -3,6 +3,7 @@
 //
 
 #include <VulkanToy/AssetSystem/MeshMisc.h>
+#include <glm/gtc/packing.hpp>
 
 namespace VT
 {
@@ -10,6 +11,55 @@ namespace VT
     std::vector<VkVertexInputAttributeDescription> StaticMeshVertex::vertexInputAttributeDescriptions;
     VkPipelineVertexInputStateCreateInfo StaticMeshVertex::pipelineVertexInputStateCreateInfo;
 
+    VkVertexInputBindingDescription StaticMeshCompactVertex::vertexInputBindingDescription;
+    std::vector<VkVertexInputAttributeDescription> StaticMeshCompactVertex::vertexInputAttributeDescriptions;
+    VkPipelineVertexInputStateCreateInfo StaticMeshCompactVertex::pipelineVertexInputStateCreateInfo;
+
+    // Below this L1 norm a normal or tangent is degenerate and encodes as +Z
+    constexpr float GOctahedralMinNorm = 1e-8f;
+
+    // Octahedral mapping of unit vector, fold lower hemisphere onto upper
+    static glm::vec2 octahedralEncode(glm::vec3 v)
+    {
+        const float norm = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+        if (!(norm > GOctahedralMinNorm) || !std::isfinite(norm))
+        {
+            return glm::vec2{ 0.0f, 0.0f };
+        }
+        v /= norm;
+        glm::vec2 result{ v.x, v.y };
+        if (v.z < 0.0f)
+        {
+            result.x = (1.0f - std::abs(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f);
+            result.y = (1.0f - std::abs(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f);
+        }
+        return result;
+    }
+
+    static glm::vec3 octahedralDecode(glm::vec2 e)
+    {
+        glm::vec3 v{ e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y) };
+        const float t = std::max(-v.z, 0.0f);
+        v.x += v.x >= 0.0f ? -t : t;
+        v.y += v.y >= 0.0f ? -t : t;
+        return glm::normalize(v);
+    }
+
+    static int16_t packSnorm16(float value)
+    {
+        // NaN survives clamp and round, its cast to int16_t is undefined
+        if (std::isnan(value))
+        {
+            return 0;
+        }
+        return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    static float unpackSnorm16(int16_t value)
+    {
+        return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+    }
+
     VkVertexInputBindingDescription StaticMeshVertex::getInputBindingDescription(uint32_t binding)
     {
         return VkVertexInputBindingDescription{ .binding = binding,
@@ -72,6 +122,143 @@ namespace VT
         return &pipelineVertexInputStateCreateInfo;
     }
 
+    VkVertexInputBindingDescription StaticMeshCompactVertex::getInputBindingDescription(uint32_t binding)
+    {
+        return VkVertexInputBindingDescription{ .binding = binding,
+                .stride = sizeof(StaticMeshCompactVertex),
+                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX };
+    }
+
+    VkVertexInputAttributeDescription StaticMeshCompactVertex::getInputAttributeDescription(uint32_t binding,
+                                        uint32_t location, VertexComponent component)
+    {
+        switch (component)
+        {
+            case VertexComponent::Position:
+                return VkVertexInputAttributeDescription{ .location = location, .binding = binding,
+                        .format = VK_FORMAT_R16G16B16A16_UNORM, .offset = static_cast<uint32_t>(offsetof(StaticMeshCompactVertex, position)) };
+            case VertexComponent::Normal:
+                return VkVertexInputAttributeDescription{ .location = location, .binding = binding,
+                        .format = VK_FORMAT_R16G16_SNORM, .offset = static_cast<uint32_t>(offsetof(StaticMeshCompactVertex, normal)) };
+            case VertexComponent::UV:
+                return VkVertexInputAttributeDescription{ .location = location, .binding = binding,
+                        .format = VK_FORMAT_R16G16_SFLOAT, .offset = static_cast<uint32_t>(offsetof(StaticMeshCompactVertex, uv)) };
+            case VertexComponent::Tangent:
+                return VkVertexInputAttributeDescription{ .location = location, .binding = binding,
+                        .format = VK_FORMAT_R16G16_SNORM, .offset = static_cast<uint32_t>(offsetof(StaticMeshCompactVertex, tangent)) };
+            case VertexComponent::Bitangent:
+                // No storage, alias tangent so the shader input stays fed, decode rebuilds bitangent
+                return VkVertexInputAttributeDescription{ .location = location, .binding = binding,
+                        .format = VK_FORMAT_R16G16_SNORM, .offset = static_cast<uint32_t>(offsetof(StaticMeshCompactVertex, tangent)) };
+            default:
+                return VkVertexInputAttributeDescription{};
+        }
+    }
+
+    std::vector<VkVertexInputAttributeDescription> StaticMeshCompactVertex::getInputAttributeDescriptions(uint32_t binding,
+                                                        const std::vector<VertexComponent> &components)
+    {
+        uint32_t location = 0;
+        std::vector<VkVertexInputAttributeDescription> result;
+        result.reserve(components.size());
+        for (VertexComponent vertexComponent : components)
+        {
+            result.push_back(StaticMeshCompactVertex::getInputAttributeDescription(binding, location, vertexComponent));
+            ++location;
+        }
+        return result;
+    }
+
+    VkPipelineVertexInputStateCreateInfo* StaticMeshCompactVertex::getPipelineVertexInputState(
+            const std::vector<VertexComponent> &components, uint32_t binding)
+    {
+        vertexInputBindingDescription = StaticMeshCompactVertex::getInputBindingDescription(binding);
+        vertexInputAttributeDescriptions = StaticMeshCompactVertex::getInputAttributeDescriptions(binding, components);
+
+        pipelineVertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
+        pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = &vertexInputBindingDescription;
+        pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexInputAttributeDescriptions.size());
+        pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions = vertexInputAttributeDescriptions.data();
+
+        return &pipelineVertexInputStateCreateInfo;
+    }
+
+    StaticMeshCompactVertex StaticMeshCompactVertex::encode(const StaticMeshVertex &vertex,
+                                                            const glm::vec3 &positionOffset, const glm::vec3 &positionScale)
+    {
+        StaticMeshCompactVertex result{};
+
+        const glm::vec3 normalized = glm::clamp((vertex.position - positionOffset) / positionScale, 0.0f, 1.0f);
+        result.position[0] = static_cast<uint16_t>(std::round(normalized.x * 65535.0f));
+        result.position[1] = static_cast<uint16_t>(std::round(normalized.y * 65535.0f));
+        result.position[2] = static_cast<uint16_t>(std::round(normalized.z * 65535.0f));
+
+        // Mirrored uv islands flip bitangent
+        const bool isFlipped = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0.0f;
+        result.position[3] = isFlipped ? 65535 : 0;
+
+        const glm::vec2 normal = octahedralEncode(vertex.normal);
+        result.normal[0] = packSnorm16(normal.x);
+        result.normal[1] = packSnorm16(normal.y);
+
+        const glm::vec2 tangent = octahedralEncode(vertex.tangent);
+        result.tangent[0] = packSnorm16(tangent.x);
+        result.tangent[1] = packSnorm16(tangent.y);
+
+        result.uv[0] = glm::packHalf1x16(vertex.uv.x);
+        result.uv[1] = glm::packHalf1x16(vertex.uv.y);
+
+        return result;
+    }
+
+    StaticMeshVertex StaticMeshCompactVertex::decode(const StaticMeshCompactVertex &vertex,
+                                                    const glm::vec3 &positionOffset, const glm::vec3 &positionScale)
+    {
+        StaticMeshVertex result{};
+
+        const glm::vec3 normalized{ vertex.position[0] / 65535.0f, vertex.position[1] / 65535.0f, vertex.position[2] / 65535.0f };
+        result.position = positionOffset + normalized * positionScale;
+        result.normal = octahedralDecode({ unpackSnorm16(vertex.normal[0]), unpackSnorm16(vertex.normal[1]) });
+        result.tangent = octahedralDecode({ unpackSnorm16(vertex.tangent[0]), unpackSnorm16(vertex.tangent[1]) });
+        result.bitangent = glm::cross(result.normal, result.tangent) * (vertex.position[3] > 32767 ? -1.0f : 1.0f);
+        result.uv = { glm::unpackHalf1x16(vertex.uv[0]), glm::unpackHalf1x16(vertex.uv[1]) };
+
+        return result;
+    }
+
+    void StaticMeshCompactVertex::computeQuantization(const std::vector<StaticMeshVertex> &vertices,
+                                                    glm::vec3 &outPositionOffset, glm::vec3 &outPositionScale)
+    {
+        glm::vec3 boundMin{ std::numeric_limits<float>::max() };
+        glm::vec3 boundMax{ std::numeric_limits<float>::lowest() };
+        for (const auto& vertex : vertices)
+        {
+            boundMin = glm::min(boundMin, vertex.position);
+            boundMax = glm::max(boundMax, vertex.position);
+        }
+        if (vertices.empty())
+        {
+            boundMin = glm::vec3{ 0.0f };
+            boundMax = glm::vec3{ 1.0f };
+        }
+
+        outPositionOffset = boundMin;
+        // Flat axis still needs a non zero scale
+        outPositionScale = glm::max(boundMax - boundMin, glm::vec3{ 1e-6f });
+    }
+
+    std::vector<uint16_t> narrowIndices(const std::vector<VertexIndexType> &indices)
+    {
+        std::vector<uint16_t> narrowed(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            VT_CORE_ASSERT(indices[i] <= std::numeric_limits<uint16_t>::max(), "Index does not fit in 16-bit");
+            narrowed[i] = static_cast<uint16_t>(indices[i]);
+        }
+        return narrowed;
+    }
+
     void StaticMeshRenderBound::toExtents(const StaticMeshRenderBound &inBound, float &zmin, float &zmax, float &ymin,
                                             float &ymax, float &xmin, float &xmax, float scale)
     {
@@ -111,6 +298,28 @@ namespace VT
 
         return ret;
     }
+
+    StaticMeshRenderBound StaticMeshSubMesh::mergeBounds(const std::vector<StaticMeshSubMesh> &subMeshes)
+    {
+        if (subMeshes.empty())
+        {
+            return StaticMeshRenderBound{};
+        }
+
+        glm::vec3 boundMin = subMeshes.front().renderBound.origin - subMeshes.front().renderBound.extent;
+        glm::vec3 boundMax = subMeshes.front().renderBound.origin + subMeshes.front().renderBound.extent;
+        for (const auto& subMesh : subMeshes)
+        {
+            boundMin = glm::min(boundMin, subMesh.renderBound.origin - subMesh.renderBound.extent);
+            boundMax = glm::max(boundMax, subMesh.renderBound.origin + subMesh.renderBound.extent);
+        }
+
+        StaticMeshRenderBound ret{};
+        ret.origin = (boundMax + boundMin) * 0.5f;
+        ret.extent = (boundMax - boundMin) * 0.5f;
+        ret.radius = glm::length(ret.extent);
+        return ret;
+    }
 }
 
 
@@ -0,0 +1,397 @@
+//
+// Created by ZHIKANG on 2023/4/14.
+//
+
+#include <VulkanToy/AssetSystem/MeshOptimizer.h>
+
+namespace VT
+{
+    // FIFO cache with time stamps, vertex is resident while less than cache size misses happened after it
+    class VertexCacheSimulator
+    {
+    private:
+        std::vector<uint32_t> m_timeStamps;
+        uint32_t m_cacheSize;
+        uint32_t m_time;
+
+    public:
+        VertexCacheSimulator(uint32_t vertexCount, uint32_t cacheSize)
+            : m_timeStamps(vertexCount, 0), m_cacheSize(cacheSize), m_time(cacheSize + 1)
+        {
+
+        }
+
+        // Return true when vertex missed the cache
+        bool access(uint32_t vertex)
+        {
+            if (m_time - m_timeStamps[vertex] > m_cacheSize)
+            {
+                m_timeStamps[vertex] = m_time++;
+                return true;
+            }
+            return false;
+        }
+
+        // Evict everything without touching time stamps
+        void flush()
+        {
+            m_time += m_cacheSize + 1;
+        }
+    };
+
+    void MeshOptimizer::optimize(const std::string &name,
+                                std::vector<StaticMeshVertex> &vertices,
+                                std::vector<VertexIndexType> &indices,
+                                const std::vector<StaticMeshSubMesh> &subMeshes,
+                                const std::vector<StaticMeshLod> &lods)
+    {
+        if (indices.empty())
+        {
+            return;
+        }
+
+        const size_t lodIndexCount = lods.empty() ? indices.size() : lods[0].indexCount;
+        const auto before = analyzeVertexCache(indices.data(), lodIndexCount);
+
+        // Reorder inside each sub-mesh and LOD range, ranges stay where their tables point
+        std::vector<std::pair<uint32_t, uint32_t>> ranges{};
+        for (const auto& subMesh : subMeshes)
+        {
+            ranges.emplace_back(subMesh.indexStartPosition, subMesh.indexCount);
+        }
+        if (ranges.empty())
+        {
+            ranges.emplace_back(0, static_cast<uint32_t>(lodIndexCount));
+        }
+        for (size_t lodIndex = 1; lodIndex < lods.size(); ++lodIndex)
+        {
+            ranges.emplace_back(lods[lodIndex].indexStartPosition, lods[lodIndex].indexCount);
+        }
+        std::vector<uint32_t> clusters{};
+        for (const auto& [start, count] : ranges)
+        {
+            VT_CORE_ASSERT(start + count <= indices.size(), "Index range out of bound");
+            VertexIndexType *rangeIndices = indices.data() + start;
+            optimizeVertexCache(rangeIndices, count, &clusters);
+            optimizeOverdraw(rangeIndices, count, vertices.data(), clusters);
+        }
+
+        // LOD 0 comes first in index buffer, its vertices lead the vertex buffer
+        optimizeVertexFetch(vertices, indices);
+
+        const auto after = analyzeVertexCache(indices.data(), lodIndexCount);
+        VT_CORE_INFO("Optimize mesh '{0}': {1} triangles, {2} vertices, ACMR {3:.3f} -> {4:.3f}, ATVR {5:.3f} -> {6:.3f}",
+                    name, after.triangleCount, after.vertexCount, before.acmr, after.acmr, before.atvr, after.atvr);
+    }
+
+    void MeshOptimizer::optimizeVertexCache(VertexIndexType *indices, size_t indexCount,
+                                            std::vector<uint32_t> *outClusters, uint32_t cacheSize)
+    {
+        if (outClusters != nullptr)
+        {
+            outClusters->clear();
+        }
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        // Sub-mesh only touches its own vertex range, size every table by that range
+        const auto [minIndex, maxIndex] = std::minmax_element(indices, indices + indexCount);
+        const VertexIndexType baseVertex = *minIndex;
+        const uint32_t vertexCount = *maxIndex - baseVertex + 1;
+
+        // Vertex to triangle adjacency, compressed rows
+        std::vector<uint32_t> liveTriangles(vertexCount, 0);
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            liveTriangles[indices[i] - baseVertex]++;
+        }
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveTriangles[vertex];
+        }
+        std::vector<uint32_t> adjacency(indexCount);
+        std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            adjacency[adjacencyFill[indices[i] - baseVertex]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<uint32_t> cacheTimeStamps(vertexCount, 0);
+        std::vector<uint8_t> isEmitted(triangleCount, 0);
+        std::vector<uint32_t> deadEndStack{};
+        std::vector<uint32_t> candidates{};
+        std::vector<VertexIndexType> output{};
+        deadEndStack.reserve(indexCount);
+        output.reserve(indexCount);
+
+        uint32_t time = cacheSize + 1;
+        uint32_t cursor = 0;
+        int64_t fanningVertex = 0;
+        if (outClusters != nullptr)
+        {
+            outClusters->push_back(0);
+        }
+
+        while (fanningVertex >= 0)
+        {
+            // Emit all remaining triangles around fanning vertex
+            candidates.clear();
+            const auto fanning = static_cast<uint32_t>(fanningVertex);
+            for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a)
+            {
+                const uint32_t triangle = adjacency[a];
+                if (isEmitted[triangle] != 0)
+                {
+                    continue;
+                }
+                isEmitted[triangle] = 1;
+
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    const uint32_t vertex = indices[3 * triangle + k] - baseVertex;
+                    output.push_back(indices[3 * triangle + k]);
+                    deadEndStack.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveTriangles[vertex]--;
+                    if (time - cacheTimeStamps[vertex] > cacheSize)
+                    {
+                        cacheTimeStamps[vertex] = time++;
+                    }
+                }
+            }
+
+            // Prefer 1-ring vertex that stays in cache after fanning all its triangles
+            int64_t bestVertex = -1;
+            int64_t bestPriority = -1;
+            for (uint32_t vertex : candidates)
+            {
+                if (liveTriangles[vertex] == 0)
+                {
+                    continue;
+                }
+                int64_t priority = 0;
+                if (time - cacheTimeStamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+                {
+                    priority = time - cacheTimeStamps[vertex];
+                }
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    bestVertex = vertex;
+                }
+            }
+
+            if (bestVertex < 0)
+            {
+                // Dead end, recently used vertices first, then next vertex in input order
+                while (!deadEndStack.empty() && bestVertex < 0)
+                {
+                    const uint32_t vertex = deadEndStack.back();
+                    deadEndStack.pop_back();
+                    if (liveTriangles[vertex] > 0)
+                    {
+                        bestVertex = vertex;
+                    }
+                }
+                while (cursor < vertexCount && bestVertex < 0)
+                {
+                    if (liveTriangles[cursor] > 0)
+                    {
+                        bestVertex = cursor;
+                    }
+                    ++cursor;
+                }
+
+                // Hard boundary, cache locality breaks here
+                const auto clusterStart = static_cast<uint32_t>(output.size() / 3);
+                if (bestVertex >= 0 && outClusters != nullptr && outClusters->back() != clusterStart)
+                {
+                    outClusters->push_back(clusterStart);
+                }
+            }
+
+            fanningVertex = bestVertex;
+        }
+
+        VT_CORE_ASSERT(output.size() == triangleCount * 3, "Vertex cache optimization lost triangles");
+        std::copy(output.begin(), output.end(), indices);
+    }
+
+    void MeshOptimizer::optimizeOverdraw(VertexIndexType *indices, size_t indexCount,
+                                        const StaticMeshVertex *vertices,
+                                        const std::vector<uint32_t> &hardClusters,
+                                        float threshold, uint32_t cacheSize)
+    {
+        const auto triangleCount = static_cast<uint32_t>(indexCount / 3);
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        const auto [minIndex, maxIndex] = std::minmax_element(indices, indices + indexCount);
+        const VertexIndexType baseVertex = *minIndex;
+        const uint32_t vertexCount = *maxIndex - baseVertex + 1;
+
+        // Soft boundaries: cut cluster once its own miss ratio drops near the optimized ratio,
+        // each cluster is simulated with cold cache since it may land anywhere after sorting
+        const float acmrLimit = analyzeVertexCache(indices, indexCount, cacheSize).acmr * threshold;
+        std::vector<uint32_t> clusters{};
+        {
+            VertexCacheSimulator cache{ vertexCount, cacheSize };
+            for (size_t clusterIndex = 0; clusterIndex < std::max<size_t>(hardClusters.size(), 1); ++clusterIndex)
+            {
+                const uint32_t start = hardClusters.empty() ? 0 : hardClusters[clusterIndex];
+                const uint32_t end = clusterIndex + 1 < hardClusters.size() ? hardClusters[clusterIndex + 1] : triangleCount;
+                clusters.push_back(start);
+                cache.flush();
+
+                uint32_t clusterMisses = 0;
+                uint32_t clusterTriangles = 0;
+                for (uint32_t triangle = start; triangle < end; ++triangle)
+                {
+                    for (uint32_t k = 0; k < 3; ++k)
+                    {
+                        clusterMisses += cache.access(indices[3 * triangle + k] - baseVertex) ? 1 : 0;
+                    }
+                    clusterTriangles++;
+
+                    if (triangle + 1 < end && static_cast<float>(clusterMisses) <= acmrLimit * static_cast<float>(clusterTriangles))
+                    {
+                        clusters.push_back(triangle + 1);
+                        cache.flush();
+                        clusterMisses = 0;
+                        clusterTriangles = 0;
+                    }
+                }
+            }
+        }
+        if (clusters.size() < 2)
+        {
+            return;
+        }
+
+        // Area weighted centroid and normal of each cluster
+        struct ClusterInfo
+        {
+            uint32_t start = 0;
+            uint32_t end = 0;
+            glm::vec3 centroid{ 0.0f };
+            glm::vec3 normal{ 0.0f };
+            float area = 0.0f;
+            float sortKey = 0.0f;
+        };
+        std::vector<ClusterInfo> clusterInfos(clusters.size());
+        glm::vec3 meshCentroid{ 0.0f };
+        float meshArea = 0.0f;
+        for (size_t clusterIndex = 0; clusterIndex < clusters.size(); ++clusterIndex)
+        {
+            auto& info = clusterInfos[clusterIndex];
+            info.start = clusters[clusterIndex];
+            info.end = clusterIndex + 1 < clusters.size() ? clusters[clusterIndex + 1] : triangleCount;
+            for (uint32_t triangle = info.start; triangle < info.end; ++triangle)
+            {
+                const glm::vec3 &p0 = vertices[indices[3 * triangle + 0]].position;
+                const glm::vec3 &p1 = vertices[indices[3 * triangle + 1]].position;
+                const glm::vec3 &p2 = vertices[indices[3 * triangle + 2]].position;
+                const glm::vec3 crossProduct = glm::cross(p1 - p0, p2 - p0);
+                const float area = glm::length(crossProduct);
+
+                info.centroid += (p0 + p1 + p2) * (area / 3.0f);
+                info.normal += crossProduct;
+                info.area += area;
+            }
+            meshCentroid += info.centroid;
+            meshArea += info.area;
+            if (info.area > 0.0f)
+            {
+                info.centroid /= info.area;
+            }
+        }
+        if (meshArea > 0.0f)
+        {
+            meshCentroid /= meshArea;
+        }
+
+        // Outward facing clusters occlude the rest, draw them first
+        for (auto& info : clusterInfos)
+        {
+            const float normalLength = glm::length(info.normal);
+            info.sortKey = normalLength > 0.0f ? glm::dot(info.centroid - meshCentroid, info.normal / normalLength) : 0.0f;
+        }
+        std::stable_sort(clusterInfos.begin(), clusterInfos.end(),
+                        [](const ClusterInfo &a, const ClusterInfo &b) { return a.sortKey > b.sortKey; });
+
+        std::vector<VertexIndexType> output{};
+        output.reserve(indexCount);
+        for (const auto& info : clusterInfos)
+        {
+            output.insert(output.end(), indices + 3 * info.start, indices + 3 * info.end);
+        }
+        std::copy(output.begin(), output.end(), indices);
+    }
+
+    void MeshOptimizer::optimizeVertexFetch(std::vector<StaticMeshVertex> &vertices, std::vector<VertexIndexType> &indices)
+    {
+        constexpr auto unused = std::numeric_limits<VertexIndexType>::max();
+        std::vector<VertexIndexType> remap(vertices.size(), unused);
+
+        VertexIndexType nextVertex = 0;
+        for (auto& index : indices)
+        {
+            VT_CORE_ASSERT(index < vertices.size(), "Vertex index out of bound");
+            if (remap[index] == unused)
+            {
+                remap[index] = nextVertex++;
+            }
+            index = remap[index];
+        }
+        for (auto& target : remap)
+        {
+            if (target == unused)
+            {
+                target = nextVertex++;
+            }
+        }
+
+        std::vector<StaticMeshVertex> output(vertices.size());
+        for (size_t vertex = 0; vertex < vertices.size(); ++vertex)
+        {
+            output[remap[vertex]] = vertices[vertex];
+        }
+        vertices.swap(output);
+    }
+
+    MeshCacheStatistics MeshOptimizer::analyzeVertexCache(const VertexIndexType *indices, size_t indexCount, uint32_t cacheSize)
+    {
+        MeshCacheStatistics statistics{};
+        statistics.triangleCount = static_cast<uint32_t>(indexCount / 3);
+        if (indexCount == 0)
+        {
+            return statistics;
+        }
+
+        const auto [minIndex, maxIndex] = std::minmax_element(indices, indices + indexCount);
+        const uint32_t vertexCount = *maxIndex - *minIndex + 1;
+
+        VertexCacheSimulator cache{ vertexCount, cacheSize };
+        std::vector<uint8_t> isReferenced(vertexCount, 0);
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            const uint32_t vertex = indices[i] - *minIndex;
+            statistics.cacheMissCount += cache.access(vertex) ? 1 : 0;
+            if (isReferenced[vertex] == 0)
+            {
+                isReferenced[vertex] = 1;
+                statistics.vertexCount++;
+            }
+        }
+
+        statistics.acmr = static_cast<float>(statistics.cacheMissCount) / static_cast<float>(statistics.triangleCount);
+        statistics.atvr = static_cast<float>(statistics.cacheMissCount) / static_cast<float>(statistics.vertexCount);
+        return statistics;
+    }
+}
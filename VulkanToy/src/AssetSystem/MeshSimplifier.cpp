@@ -0,0 +1,371 @@
+//
+// Created by ZHIKANG on 2023/4/15.
+//
+
+#include <VulkanToy/AssetSystem/MeshSimplifier.h>
+
+namespace VT
+{
+    // Sum of area weighted plane quadrics, evaluate to weighted squared distance
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double weight = 0.0;
+
+        static Quadric fromTriangle(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2)
+        {
+            Quadric quadric{};
+            const glm::vec3 crossProduct = glm::cross(p1 - p0, p2 - p0);
+            const double area = glm::length(crossProduct);
+            if (area <= 0.0)
+            {
+                return quadric;
+            }
+
+            const double nx = crossProduct.x / area, ny = crossProduct.y / area, nz = crossProduct.z / area;
+            const double d = -(nx * p0.x + ny * p0.y + nz * p0.z);
+            quadric.a00 = area * nx * nx; quadric.a01 = area * nx * ny; quadric.a02 = area * nx * nz;
+            quadric.a11 = area * ny * ny; quadric.a12 = area * ny * nz; quadric.a22 = area * nz * nz;
+            quadric.b0 = area * nx * d; quadric.b1 = area * ny * d; quadric.b2 = area * nz * d;
+            quadric.c = area * d * d;
+            quadric.weight = area;
+            return quadric;
+        }
+
+        Quadric& operator+=(const Quadric &other)
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02;
+            a11 += other.a11; a12 += other.a12; a22 += other.a22;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+            return *this;
+        }
+
+        // Average squared distance from the accumulated planes
+        [[nodiscard]] double evaluate(const glm::vec3 &p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            const double result = x * (a00 * x + a01 * y + a02 * z) +
+                                y * (a01 * x + a11 * y + a12 * z) +
+                                z * (a02 * x + a12 * y + a22 * z) +
+                                2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return weight > 0.0 ? std::max(result, 0.0) / weight : 0.0;
+        }
+    };
+
+    float MeshSimplifier::simplify(const std::vector<StaticMeshVertex> &vertices,
+                                    const VertexIndexType *indices, size_t indexCount,
+                                    size_t targetIndexCount, std::vector<VertexIndexType> &outIndices)
+    {
+        outIndices.assign(indices, indices + indexCount);
+        if (indexCount <= targetIndexCount || indexCount < 3)
+        {
+            return 0.0f;
+        }
+
+        // Work in local vertex range of this sub-mesh
+        const auto [minIndex, maxIndex] = std::minmax_element(indices, indices + indexCount);
+        const VertexIndexType baseVertex = *minIndex;
+        const uint32_t vertexCount = *maxIndex - baseVertex + 1;
+        auto getPosition = [&](uint32_t vertex) -> const glm::vec3& { return vertices[vertex + baseVertex].position; };
+
+        // Weld vertices sharing position, wedges of one position differ in attributes only
+        constexpr uint32_t invalid = ~0u;
+        std::vector<uint32_t> positionIds(vertexCount, invalid);
+        std::vector<uint32_t> sortedVertices{};
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            const uint32_t vertex = indices[i] - baseVertex;
+            if (positionIds[vertex] == invalid)
+            {
+                positionIds[vertex] = 0;
+                sortedVertices.push_back(vertex);
+            }
+        }
+        std::sort(sortedVertices.begin(), sortedVertices.end(), [&](uint32_t a, uint32_t b)
+        {
+            const glm::vec3 &pa = getPosition(a);
+            const glm::vec3 &pb = getPosition(b);
+            return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+        });
+        uint32_t positionCount = 0;
+        std::vector<uint32_t> wedgeCounts{};
+        for (size_t i = 0; i < sortedVertices.size(); ++i)
+        {
+            if (i == 0 || getPosition(sortedVertices[i]) != getPosition(sortedVertices[i - 1]))
+            {
+                positionCount++;
+                wedgeCounts.push_back(0);
+            }
+            positionIds[sortedVertices[i]] = positionCount - 1;
+            wedgeCounts.back()++;
+        }
+
+        // Lock attribute seams, borders and non-manifold edges, collapse only moves interior vertices
+        std::vector<uint8_t> isLocked(positionCount, 0);
+        for (uint32_t position = 0; position < positionCount; ++position)
+        {
+            isLocked[position] = wedgeCounts[position] > 1 ? 1 : 0;
+        }
+        {
+            std::unordered_map<uint64_t, uint32_t> edgeUseCounts{};
+            edgeUseCounts.reserve(indexCount);
+            for (size_t i = 0; i < indexCount; i += 3)
+            {
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    const uint32_t a = positionIds[indices[i + k] - baseVertex];
+                    const uint32_t b = positionIds[indices[i + (k + 1) % 3] - baseVertex];
+                    edgeUseCounts[(uint64_t(std::min(a, b)) << 32) | std::max(a, b)]++;
+                }
+            }
+            for (const auto& [edge, useCount] : edgeUseCounts)
+            {
+                if (useCount != 2)
+                {
+                    isLocked[uint32_t(edge >> 32)] = 1;
+                    isLocked[uint32_t(edge & 0xFFFFFFFF)] = 1;
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(positionCount);
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            const uint32_t v0 = indices[i + 0] - baseVertex;
+            const uint32_t v1 = indices[i + 1] - baseVertex;
+            const uint32_t v2 = indices[i + 2] - baseVertex;
+            const Quadric quadric = Quadric::fromTriangle(getPosition(v0), getPosition(v1), getPosition(v2));
+            quadrics[positionIds[v0]] += quadric;
+            quadrics[positionIds[v1]] += quadric;
+            quadrics[positionIds[v2]] += quadric;
+        }
+
+        struct Collapse
+        {
+            uint32_t from;
+            uint32_t to;
+            double error;
+        };
+        std::vector<Collapse> collapses{};
+        std::vector<uint32_t> adjacencyOffsets(positionCount + 1);
+        std::vector<uint32_t> adjacency{};
+        std::vector<uint8_t> isTouched(positionCount);
+        std::vector<uint32_t> remap(vertexCount);
+        double maxError = 0.0;
+
+        // Every pass collapses a set of independent edges, cheapest first
+        while (outIndices.size() > targetIndexCount)
+        {
+            const size_t triangleCount = outIndices.size() / 3;
+
+            // Position to triangle adjacency, compressed rows
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (auto index : outIndices)
+            {
+                adjacencyOffsets[positionIds[index - baseVertex] + 1]++;
+            }
+            for (uint32_t position = 0; position < positionCount; ++position)
+            {
+                adjacencyOffsets[position + 1] += adjacencyOffsets[position];
+            }
+            adjacency.resize(outIndices.size());
+            std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < outIndices.size(); ++i)
+            {
+                adjacency[adjacencyFill[positionIds[outIndices[i] - baseVertex]]++] = static_cast<uint32_t>(i / 3);
+            }
+
+            collapses.clear();
+            for (size_t i = 0; i < outIndices.size(); i += 3)
+            {
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    const uint32_t a = outIndices[i + k] - baseVertex;
+                    const uint32_t b = outIndices[i + (k + 1) % 3] - baseVertex;
+                    const uint32_t positionA = positionIds[a];
+                    const uint32_t positionB = positionIds[b];
+                    if (positionA == positionB)
+                    {
+                        continue;
+                    }
+
+                    Quadric quadric = quadrics[positionA];
+                    quadric += quadrics[positionB];
+                    if (isLocked[positionA] == 0)
+                    {
+                        collapses.push_back({ a, b, quadric.evaluate(getPosition(b)) });
+                    }
+                    if (isLocked[positionB] == 0)
+                    {
+                        collapses.push_back({ b, a, quadric.evaluate(getPosition(a)) });
+                    }
+                }
+            }
+            if (collapses.empty())
+            {
+                break;
+            }
+            std::sort(collapses.begin(), collapses.end(),
+                    [](const Collapse &a, const Collapse &b) { return a.error < b.error; });
+
+            std::fill(isTouched.begin(), isTouched.end(), 0);
+            std::iota(remap.begin(), remap.end(), 0);
+            const size_t removeBudget = (outIndices.size() - targetIndexCount + 2) / 3;
+            size_t removedCount = 0;
+            for (const auto& collapse : collapses)
+            {
+                if (removedCount >= removeBudget)
+                {
+                    break;
+                }
+                const uint32_t positionFrom = positionIds[collapse.from];
+                const uint32_t positionTo = positionIds[collapse.to];
+                if (isTouched[positionFrom] != 0 || isTouched[positionTo] != 0)
+                {
+                    continue;
+                }
+
+                // Reject collapse that flips any triangle left around source vertex
+                const glm::vec3 &target = getPosition(collapse.to);
+                bool isFlipped = false;
+                size_t collapsedCount = 0;
+                for (uint32_t a = adjacencyOffsets[positionFrom]; a < adjacencyOffsets[positionFrom + 1] && !isFlipped; ++a)
+                {
+                    const uint32_t triangle = adjacency[a];
+                    glm::vec3 corners[3];
+                    uint32_t cornerFrom = 0;
+                    bool hasTarget = false;
+                    for (uint32_t k = 0; k < 3; ++k)
+                    {
+                        const uint32_t vertex = outIndices[3 * triangle + k] - baseVertex;
+                        corners[k] = getPosition(vertex);
+                        cornerFrom = positionIds[vertex] == positionFrom ? k : cornerFrom;
+                        hasTarget = hasTarget || positionIds[vertex] == positionTo;
+                    }
+                    if (hasTarget)
+                    {
+                        collapsedCount++;
+                        continue;
+                    }
+
+                    const glm::vec3 normalBefore = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                    corners[cornerFrom] = target;
+                    const glm::vec3 normalAfter = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                    isFlipped = glm::dot(normalBefore, normalAfter) <= 0.0f;
+                }
+                if (isFlipped)
+                {
+                    continue;
+                }
+
+                // Lock one-ring, later collapses in this pass never see stale triangles
+                for (uint32_t a = adjacencyOffsets[positionFrom]; a < adjacencyOffsets[positionFrom + 1]; ++a)
+                {
+                    const uint32_t triangle = adjacency[a];
+                    for (uint32_t k = 0; k < 3; ++k)
+                    {
+                        isTouched[positionIds[outIndices[3 * triangle + k] - baseVertex]] = 1;
+                    }
+                }
+
+                // Source is not on a seam, its only wedge moves onto target wedge
+                remap[collapse.from] = collapse.to;
+                quadrics[positionTo] += quadrics[positionFrom];
+                maxError = std::max(maxError, collapse.error);
+                removedCount += collapsedCount;
+            }
+            if (removedCount == 0)
+            {
+                break;
+            }
+
+            // Rewrite triangles, drop the degenerate ones
+            size_t writeIndex = 0;
+            for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+            {
+                const uint32_t v0 = remap[outIndices[3 * triangle + 0] - baseVertex];
+                const uint32_t v1 = remap[outIndices[3 * triangle + 1] - baseVertex];
+                const uint32_t v2 = remap[outIndices[3 * triangle + 2] - baseVertex];
+                if (positionIds[v0] == positionIds[v1] || positionIds[v1] == positionIds[v2] || positionIds[v0] == positionIds[v2])
+                {
+                    continue;
+                }
+                outIndices[writeIndex++] = v0 + baseVertex;
+                outIndices[writeIndex++] = v1 + baseVertex;
+                outIndices[writeIndex++] = v2 + baseVertex;
+            }
+            outIndices.resize(writeIndex);
+        }
+
+        return static_cast<float>(std::sqrt(maxError));
+    }
+
+    std::vector<StaticMeshLod> MeshSimplifier::buildLodChain(const std::string &name,
+                                                            const std::vector<StaticMeshVertex> &vertices,
+                                                            std::vector<VertexIndexType> &indices,
+                                                            const std::vector<StaticMeshSubMesh> &subMeshes)
+    {
+        std::vector<StaticMeshLod> lods{};
+        lods.push_back(StaticMeshLod{ .indexCount = static_cast<uint32_t>(indices.size()) });
+
+        // Index ranges of previous LOD, one per sub-mesh
+        std::vector<std::pair<uint32_t, uint32_t>> ranges{};
+        for (const auto& subMesh : subMeshes)
+        {
+            ranges.emplace_back(subMesh.indexStartPosition, subMesh.indexCount);
+        }
+        if (ranges.empty())
+        {
+            ranges.emplace_back(0, static_cast<uint32_t>(indices.size()));
+        }
+
+        std::vector<VertexIndexType> lodIndices{};
+        std::vector<VertexIndexType> rangeIndices{};
+        for (uint32_t lodIndex = 1; lodIndex < GMaxMeshLodCount; ++lodIndex)
+        {
+            const auto& previous = lods.back();
+            const auto targetTriangleCount = static_cast<uint32_t>(float(previous.indexCount / 3) * GMeshLodReduction);
+            if (targetTriangleCount < GMeshLodMinTriangleCount)
+            {
+                break;
+            }
+
+            // Simplify from previous LOD, error accumulates along the chain
+            lodIndices.clear();
+            float lodError = 0.0f;
+            std::vector<std::pair<uint32_t, uint32_t>> lodRanges{};
+            for (const auto& [start, count] : ranges)
+            {
+                const auto targetIndexCount = static_cast<size_t>(float(count / 3) * GMeshLodReduction) * 3;
+                lodError = std::max(lodError, simplify(vertices, indices.data() + start, count, targetIndexCount, rangeIndices));
+                lodRanges.emplace_back(static_cast<uint32_t>(indices.size() + lodIndices.size()), static_cast<uint32_t>(rangeIndices.size()));
+                lodIndices.insert(lodIndices.end(), rangeIndices.begin(), rangeIndices.end());
+            }
+
+            // Locked seams and borders keep most triangles, such LOD is not worth memory
+            if (float(lodIndices.size()) > float(previous.indexCount) * (GMeshLodReduction + 1.0f) * 0.5f)
+            {
+                break;
+            }
+
+            StaticMeshLod lod{};
+            lod.indexStartPosition = static_cast<uint32_t>(indices.size());
+            lod.indexCount = static_cast<uint32_t>(lodIndices.size());
+            lod.error = previous.error + lodError;
+            lods.push_back(lod);
+            indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+            ranges = std::move(lodRanges);
+        }
+
+        for (size_t lodIndex = 0; lodIndex < lods.size(); ++lodIndex)
+        {
+            VT_CORE_INFO("Mesh '{0}' LOD {1}: {2} triangles, error {3:.5f}",
+                        name, lodIndex, lods[lodIndex].indexCount / 3, lods[lodIndex].error);
+        }
+        return lods;
+    }
+}
@@ -3,6 +3,7 @@
 //
 
 #include <VulkanToy/AssetSystem/TextureManager.h>
+#include <VulkanToy/AssetSystem/AssetSystem.h>
 #include <VulkanToy/VulkanRHI/VulkanRHI.h>
 
 #include <VulkanToy/AssetSystem/ImageProcess.h>
@@ -11,16 +12,16 @@
 
 namespace VT
 {
-    const UUID EngineImages::GAlbedoImageUUID = "5albedo01-xb71-8d2y-a98f-a0f4fdje20gg";
+    const UUID EngineImages::GAlbedoImageUUID = UUID::fromString("5a1bed01-eb71-4d2e-a98f-a0f4fd0e20aa").value();
     std::weak_ptr<GPUImageAsset>  EngineImages::GAlbedoImageAsset = {};
 
-    const UUID EngineImages::GNormalImageUUID = "3normal75-0002-7d7y-a98f-a0f4f4d1fd53";
+    const UUID EngineImages::GNormalImageUUID = UUID::fromString("3a0e4a75-0002-4d7e-a98f-a0f4f4d1fd53").value();
     std::weak_ptr<GPUImageAsset>  EngineImages::GNormalImageAsset = {};
 
-    const UUID EngineImages::GMetallicImageUUID = "5metallic82-0853-7d7y-q21-a0fpi91fdid";
+    const UUID EngineImages::GMetallicImageUUID = UUID::fromString("5e7a1182-0853-4d7e-b021-a0f0e91fd1d0").value();
     std::weak_ptr<GPUImageAsset>  EngineImages::GMetallicImageAsset = {};
 
-    const UUID EngineImages::GRoughnessImageUUID = "9roughness-u612-7d7y-a98f-a0f4f4d1fd53";
+    const UUID EngineImages::GRoughnessImageUUID = UUID::fromString("9c0a6e55-e612-4d7e-a98f-a0f4f4d1fd54").value();
     std::weak_ptr<GPUImageAsset>  EngineImages::GRoughnessImageAsset = {};
 
     static std::string getRuntimeUniqueImageAssetName(const std::string &in)
@@ -62,25 +63,88 @@ namespace VT
 
     GPUImageAsset::~GPUImageAsset() noexcept
     {
+        // Transient asset is evicted from cache, release when last reference drops
         if (!m_isPersistent)
         {
-            // TODO:
+            release();
         }
     }
 
     void GPUImageAsset::release()
     {
-        m_image->release();
+        if (m_bindlessIndex != std::numeric_limits<uint32_t>::max())
+        {
+            VulkanRHI::get()->getBindlessHeap().releaseSampledImage(m_bindlessIndex);
+            m_bindlessIndex = std::numeric_limits<uint32_t>::max();
+        }
+        if (m_image != nullptr && m_image->getImage() != VK_NULL_HANDLE)
+        {
+            m_image->release();
+        }
     }
 
     void GPUImageAsset::prepareToUpload(CommandBufferBase &cmd, VkImageSubresourceRange range)
     {
-
+        const auto barrier = ImageMemoryBarrier{ m_image->getImage(), 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL }
+                                                .mipLevels(range.baseMipLevel, range.levelCount)
+                                                .arrayLayers(range.baseArrayLayer, range.layerCount);
+        vkCmdPipelineBarrier(cmd.cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr,
+                                0, nullptr, 1, &barrier.barrier);
     }
 
     void GPUImageAsset::finishUpload(CommandBufferBase &cmd, VkImageSubresourceRange range)
     {
+        // Mipmaps need blit on graphics queue, so keep uploaded level as transfer source
+        const bool isGenerateMipmaps = m_image->getInfo().mipLevels > 1;
+        const uint32_t graphicsFamily = VulkanRHI::get()->getGraphicsFamily();
+
+        auto barrier = ImageMemoryBarrier{ m_image->getImage(), VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                            isGenerateMipmaps ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
+                                            .mipLevels(range.baseMipLevel, range.levelCount)
+                                            .arrayLayers(range.baseArrayLayer, range.layerCount);
+        if (cmd.queueFamily != graphicsFamily)
+        {
+            barrier.barrier.srcQueueFamilyIndex = cmd.queueFamily;
+            barrier.barrier.dstQueueFamilyIndex = graphicsFamily;
+        }
+        vkCmdPipelineBarrier(cmd.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                                0, nullptr, 1, &barrier.barrier);
+    }
+
+    void GPUImageAsset::acquireOwnership(CommandBufferBase &cmd, VkImageSubresourceRange range)
+    {
+        const bool isGenerateMipmaps = m_image->getInfo().mipLevels > 1;
+        const uint32_t copyFamily = VulkanRHI::get()->getCopyFamily();
+
+        auto barrier = ImageMemoryBarrier{ m_image->getImage(), 0,
+                                            isGenerateMipmaps ? VK_ACCESS_TRANSFER_READ_BIT : VK_ACCESS_SHADER_READ_BIT,
+                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                            isGenerateMipmaps ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
+                                            .mipLevels(range.baseMipLevel, range.levelCount)
+                                            .arrayLayers(range.baseArrayLayer, range.layerCount);
+        if (cmd.queueFamily != copyFamily)
+        {
+            barrier.barrier.srcQueueFamilyIndex = copyFamily;
+            barrier.barrier.dstQueueFamilyIndex = cmd.queueFamily;
+        }
+        vkCmdPipelineBarrier(cmd.cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                isGenerateMipmaps ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                0, 0, nullptr, 0, nullptr, 1, &barrier.barrier);
 
+        if (isGenerateMipmaps)
+        {
+            m_image->generateMipmaps(cmd.cmd);
+        }
+    }
+
+    void GPUImageAsset::registerBindless()
+    {
+        if (m_bindlessIndex == std::numeric_limits<uint32_t>::max())
+        {
+            m_bindlessIndex = VulkanRHI::get()->getBindlessHeap().registerSampledImage(m_image->getView());
+        }
     }
 
     void TextureContext::init()
@@ -88,6 +152,11 @@ namespace VT
         m_GPUCache = CreateScope<GPUAssetCache<GPUImageAsset>>(1024, 512);
     }
 
+    void TextureContext::tick()
+    {
+        m_GPUCache->tick();
+    }
+
     void TextureContext::release()
     {
         m_GPUCache->clear();
@@ -102,8 +171,9 @@ namespace VT
 
         std::memcpy(mapped, cacheRawData.data(), cacheRawData.size());
 
-        // TODO: check
-        imageAssetGPU->prepareToUpload(commandBuffer, Initializers::initBasicImageSubresource());
+        // Upload mip 0 only, the rest mip chain is generated after graphics queue acquire
+        VkImageSubresourceRange range{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        imageAssetGPU->prepareToUpload(commandBuffer, range);
 
         VkBufferImageCopy region{};
         region.bufferOffset = stageBufferOffset;
@@ -123,11 +193,12 @@ namespace VT
                                 1,
                                 &region);
 
-        imageAssetGPU->finishUpload(commandBuffer, Initializers::initBasicImageSubresource());
+        imageAssetGPU->finishUpload(commandBuffer, range);
     }
 
     void TextureRawDataLoadTask::buildFromPath(const std::filesystem::path &path, const UUID &uuid, VkFormat format, TextureType textureType)
     {
+        VT_PROFILE_SCOPE_DYNAMIC(path.filename().string());
         if (TextureManager::Get()->isAssetExist(uuid))
         {
             VT_CORE_WARN("Persistent asset has existed, do not register again");
@@ -147,17 +218,6 @@ namespace VT
         uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
         if (textureType == TextureType::HDR) mipLevels = 1;
 
-        // Staging buffer
-        auto stagingBuffer = VulkanBuffer::create2(
-                "Staging buffer",
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT,
-                imageSize);
-        RHICheck(stagingBuffer->map());
-        stagingBuffer->copyData(imageProcess.getPixels(), static_cast<size_t>(imageSize));
-        stagingBuffer->unmap();
-
         // Create image buffer
         auto newImageAsset = CreateRef<GPUImageAsset>(
                 path.stem().string(),
@@ -190,32 +250,15 @@ namespace VT
             samplerCI.unnormalizedCoordinates = VK_FALSE;
             VulkanRHI::SamplerManager->createSampler(samplerCI, static_cast<uint8_t>(textureType));
         }
-        // Transition image layout
-        {
-            const auto barrier = ImageMemoryBarrier{ newImageAsset->getImage(), 0, VK_ACCESS_TRANSFER_WRITE_BIT,
-                                                            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL }.mipLevels(0, 1);
-            VulkanImage::transitionImageLayout(barrier, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-        }
-        // Copy staging buffer to image
-        newImageAsset->getVulkanImage()->copyFromStagingBuffer(stagingBuffer->getBuffer(), texWidth, texHeight);
-        // Generate mipmaps, otherwise transition image layout only
-        if (mipLevels > 1)
-        {
-            const auto barrier = ImageMemoryBarrier{newImageAsset->getImage(), VK_ACCESS_TRANSFER_WRITE_BIT, 0,
-                                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL}.mipLevels(0, 1);
-            VulkanImage::transitionImageLayout(barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+        // Keep raw pixels in task, copy to stage buffer on uploader thread
+        auto newTask = CreateRef<TextureRawDataLoadTask>();
+        newTask->imageAssetGPU = newImageAsset;
+        newTask->cacheRawData.resize(imageSize);
+        std::memcpy(newTask->cacheRawData.data(), imageProcess.getPixels(), static_cast<size_t>(imageSize));
 
-            newImageAsset->getVulkanImage()->generateMipmaps();
-        } else
-        {
-            const auto barrier = ImageMemoryBarrier{ newImageAsset->getImage(), VK_ACCESS_TRANSFER_WRITE_BIT, 0,
-                                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }.mipLevels(0, 1);
-            VulkanImage::transitionImageLayout(barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
-        }
-        // Release staging buffer
-        stagingBuffer->release();
-        // Insert GPU image asset
+        // Insert GPU image asset, asset keep loading state until upload finish
         TextureManager::Get()->insertGPUAsset(uuid, newImageAsset);
+        AssetSystemHandle::Get()->addUploadTask(newTask);
     }
 
     Ref<TextureRawDataLoadTask> TextureRawDataLoadTask::buildFromPath2(const std::filesystem::path &path,
@@ -4,16 +4,41 @@
 
 #include <VulkanToy/Core/Engine.h>
 #include <VulkanToy/Core/Input.h>
+#include <VulkanToy/Core/JobSystem.h>
 #include <VulkanToy/VulkanRHI/VulkanRHI.h>
 #include <VulkanToy/Renderer/Renderer.h>
 #include <VulkanToy/AssetSystem/AssetSystem.h>
 #include <VulkanToy/Scene/Scene.h>
 #include <VulkanToy/Renderer/SceneCamera.h>
+#include <cstdlib>
 
 namespace VT
 {
     Engine* GEngine = Singleton<Engine>::Get();
 
+    EngineSettings EngineSettings::fromCommandLine(int argc, char **argv)
+    {
+        EngineSettings settings{};
+        for (int index = 1; index < argc; ++index)
+        {
+            const std::string_view option{ argv[index] };
+            if (option == "--cpu-culling")
+            {
+                settings.cpuCulling = true;
+            } else if (option == "--serial-recording")
+            {
+                settings.serialRecording = true;
+            } else if (option == "--frames-in-flight" && index + 1 < argc)
+            {
+                settings.framesInFlight = static_cast<uint32_t>(std::strtoul(argv[++index], nullptr, 10));
+            } else if (option == "--trace" && index + 1 < argc)
+            {
+                settings.traceExportPath = argv[++index];
+            }
+        }
+        return settings;
+    }
+
     Engine::Engine()
     {
 
@@ -21,15 +46,58 @@ namespace VT
 
     void Engine::init()
     {
-        WindowProps props{ "VulkanToy", 1600, 900 };
-        m_window = Window::Create(props);
-        m_window->setEventCallback(VT_BIND_EVENT_FN(Engine::onEvent));
+#ifdef VT_ENABLE_PROFILER
+        if (!m_settings.traceExportPath.empty())
+        {
+            ProfilerHandle::Get()->startCapture(GProfilerStartupCaptureFrames);
+        }
+#else
+        if (!m_settings.traceExportPath.empty())
+        {
+            VT_CORE_WARN("Trace export needs a build with VULKAN_TOY_PROFILER on, ignoring --trace");
+        }
+#endif
+        VT_PROFILE_THREAD("Main");
+        VT_PROFILE_SCOPE("Engine::init");
+
+        {
+            VT_PROFILE_SCOPE("Window");
+            WindowProps props{ "VulkanToy", 1600, 900 };
+            m_window = Window::Create(props);
+            m_window->setEventCallback(VT_BIND_EVENT_FN(Engine::onEvent));
+        }
 
-        SceneCameraHandle::Get()->init();
-        VulkanRHI::get()->init(static_cast<GLFWwindow *>(m_window->getNativeWindow()));
-        AssetSystemHandle::Get()->init();
-        RendererHandle::Get()->init();
-        SceneHandle::Get()->init();
+        // Workers are needed by every module below
+        {
+            VT_PROFILE_SCOPE("JobSystem::init");
+            JobSystemHandle::Get()->init();
+        }
+        {
+            VT_PROFILE_SCOPE("SceneCamera::init");
+            SceneCameraHandle::Get()->init();
+        }
+        {
+            VT_PROFILE_SCOPE("VulkanRHI::init");
+            VulkanRHI::get()->init(static_cast<GLFWwindow *>(m_window->getNativeWindow()));
+            if (m_settings.framesInFlight != 0)
+            {
+                VulkanRHI::get()->setFramesInFlight(m_settings.framesInFlight);
+            }
+        }
+        {
+            VT_PROFILE_SCOPE("AssetSystem::init");
+            AssetSystemHandle::Get()->init();
+        }
+        {
+            VT_PROFILE_SCOPE("Renderer::init");
+            RendererHandle::Get()->init();
+            RendererHandle::Get()->setParallelRecording(!m_settings.serialRecording);
+        }
+        {
+            VT_PROFILE_SCOPE("Scene::init");
+            SceneHandle::Get()->init();
+            SceneHandle::Get()->setGPUCulling(!m_settings.cpuCulling);
+        }
 
         m_isInitialized = true;
     }
@@ -40,6 +108,15 @@ namespace VT
         AssetSystemHandle::Get()->release();
         RendererHandle::Get()->release();
         VulkanRHI::get()->release();
+        JobSystemHandle::Get()->release();
+
+#ifdef VT_ENABLE_PROFILER
+        // Startup capture, or the last one started from profiler panel
+        if (!m_settings.traceExportPath.empty())
+        {
+            ProfilerHandle::Get()->exportChromeTrace(m_settings.traceExportPath);
+        }
+#endif
     }
 
     void Engine::run()
@@ -55,16 +132,46 @@ namespace VT
             tickData.windowWidth = m_window->getWidth();
             tickData.windowHeight = m_window->getHeight();
 
-            for (auto& layer : m_layerStack)
+            // Asset system only talks to uploaders and graphics queue, it overlaps layers and camera,
+            // which stay on main thread for window input
+            JobCounter assetTick{};
+            JobSystemHandle::Get()->run(assetTick, [&tickData]()
+            {
+                VT_PROFILE_SCOPE("AssetSystem::tick");
+                AssetSystemHandle::Get()->tick(tickData);
+            });
+            {
+                VT_PROFILE_SCOPE("Layers tick");
+                for (auto& layer : m_layerStack)
+                {
+                    layer->tick(tickData);
+                }
+            }
+            {
+                VT_PROFILE_SCOPE("SceneCamera::tick");
+                SceneCameraHandle::Get()->tick(tickData);
+            }
+            {
+                VT_PROFILE_SCOPE("Wait asset tick");
+                JobSystemHandle::Get()->wait(assetTick);
+            }
+
+            // Scene and renderer split their own work into jobs
+            {
+                VT_PROFILE_SCOPE("Scene::tick");
+                SceneHandle::Get()->tick(tickData);
+            }
+            {
+                VT_PROFILE_SCOPE("Renderer::tick");
+                RendererHandle::Get()->tick(tickData);
+            }
             {
-                layer->tick(tickData);
+                VT_PROFILE_SCOPE("Window::tick");
+                m_window->tick();
             }
-            SceneCameraHandle::Get()->tick(tickData);
-            SceneHandle::Get()->tick(tickData);
-            AssetSystemHandle::Get()->tick(tickData);
-            RendererHandle::Get()->tick(tickData);
 
-            m_window->tick();
+            // Drain zones of every thread into frame statistics
+            VT_PROFILE_FRAME();
         }
 
         vkDeviceWaitIdle(VulkanRHI::Device);
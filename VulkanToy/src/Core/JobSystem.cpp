@@ -0,0 +1,245 @@
+//
+// Created by ZHIKANG on 2023/4/22.
+//
+
+#include <VulkanToy/Core/JobSystem.h>
+
+namespace VT
+{
+    static thread_local uint32_t GJobThreadIndex = 0;
+
+    void JobSystem::init(uint32_t workerCount)
+    {
+        if (workerCount == 0)
+        {
+            workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        }
+
+        m_isShutdown = false;
+        m_queues.resize(workerCount + 1);
+        for (auto& queue : m_queues)
+        {
+            queue = CreateScope<JobQueue>();
+        }
+
+        m_workers.reserve(workerCount);
+        for (uint32_t workerIndex = 0; workerIndex < workerCount; ++workerIndex)
+        {
+            m_workers.emplace_back([this, workerIndex]() { workerLoop(workerIndex + 1); });
+        }
+        VT_CORE_INFO("Job system starts with {0} workers", workerCount);
+    }
+
+    void JobSystem::release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_isShutdown = true;
+        }
+        m_sleepCondition.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+        m_workers.clear();
+        m_queues.clear();
+    }
+
+    void JobSystem::workerLoop(uint32_t queueIndex)
+    {
+        GJobThreadIndex = queueIndex;
+
+        JobEntry entry{};
+        while (true)
+        {
+            if (tryPop(entry))
+            {
+                execute(entry);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_sleepCondition.wait(lock, [this]() { return m_isShutdown || m_queuedJobCount.load(std::memory_order_acquire) > 0; });
+            if (m_isShutdown)
+            {
+                return;
+            }
+        }
+    }
+
+    void JobSystem::push(JobEntry &&entry)
+    {
+        // Worker keeps its jobs local, external threads share queue 0
+        const uint32_t queueIndex = GJobThreadIndex < m_queues.size() ? GJobThreadIndex : 0;
+        {
+            std::lock_guard<std::mutex> lock(m_queues[queueIndex]->mutex);
+            m_queues[queueIndex]->jobs.push_back(std::move(entry));
+        }
+        m_queuedJobCount.fetch_add(1, std::memory_order_release);
+
+        // Sleeping worker checks count under this lock, so wakeup is never lost
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_sleepCondition.notify_one();
+    }
+
+    bool JobSystem::tryPop(JobEntry &outEntry)
+    {
+        if (m_queuedJobCount.load(std::memory_order_acquire) == 0)
+        {
+            return false;
+        }
+
+        const auto queueCount = static_cast<uint32_t>(m_queues.size());
+        const uint32_t ownIndex = GJobThreadIndex < queueCount ? GJobThreadIndex : 0;
+
+        // Newest own job is hot in cache
+        {
+            auto& queue = *m_queues[ownIndex];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                outEntry = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+                m_queuedJobCount.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        // Oldest job of victim is usually the largest piece of work left
+        for (uint32_t offset = 1; offset < queueCount; ++offset)
+        {
+            auto& queue = *m_queues[(ownIndex + offset) % queueCount];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                outEntry = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+                m_queuedJobCount.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void JobSystem::execute(JobEntry &entry)
+    {
+        entry.job();
+        entry.job = nullptr;
+        entry.counter->m_pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void JobSystem::run(JobCounter &counter, Job &&job)
+    {
+        counter.m_pending.fetch_add(1, std::memory_order_relaxed);
+
+        // Not initialized, run inline
+        if (m_queues.empty())
+        {
+            JobEntry entry{ std::move(job), &counter };
+            execute(entry);
+            return;
+        }
+        push(JobEntry{ std::move(job), &counter });
+    }
+
+    void JobSystem::wait(JobCounter &counter)
+    {
+        JobEntry entry{};
+        while (!counter.isDone())
+        {
+            if (tryPop(entry))
+            {
+                execute(entry);
+            } else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)> &func)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        grainSize = std::max(grainSize, 1u);
+        const uint32_t chunkCount = std::min((count + grainSize - 1) / grainSize, getConcurrency() * GJobsPerThread);
+        if (chunkCount <= 1)
+        {
+            func(0, count);
+            return;
+        }
+
+        const uint32_t itemsPerChunk = (count + chunkCount - 1) / chunkCount;
+        JobCounter counter{};
+        for (uint32_t chunk = 1; chunk < chunkCount; ++chunk)
+        {
+            const uint32_t begin = std::min(chunk * itemsPerChunk, count);
+            const uint32_t end = std::min(begin + itemsPerChunk, count);
+            run(counter, [&func, begin, end]() { func(begin, end); });
+        }
+        func(0, std::min(itemsPerChunk, count));
+        wait(counter);
+    }
+
+    uint32_t JobSystem::getThreadIndex()
+    {
+        return GJobThreadIndex;
+    }
+
+    JobGraph::NodeId JobGraph::addNode(Job &&job)
+    {
+        auto& node = m_nodes.emplace_back();
+        node.job = std::move(job);
+        return static_cast<NodeId>(m_nodes.size() - 1);
+    }
+
+    void JobGraph::addDependency(NodeId node, NodeId dependency)
+    {
+        VT_CORE_ASSERT(node < m_nodes.size() && dependency < m_nodes.size() && node != dependency, "Invalid job graph dependency");
+        m_nodes[dependency].successors.push_back(node);
+        m_nodes[node].dependencyCount++;
+    }
+
+    void JobGraph::schedule(JobSystem &jobSystem, JobCounter &counter, NodeId nodeId)
+    {
+        jobSystem.run(counter, [this, &jobSystem, &counter, nodeId]()
+        {
+            auto& node = m_nodes[nodeId];
+            node.job();
+
+            // Last finished dependency starts successor
+            for (NodeId successor : node.successors)
+            {
+                if (m_nodes[successor].remainingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    schedule(jobSystem, counter, successor);
+                }
+            }
+        });
+    }
+
+    void JobGraph::run(JobSystem &jobSystem)
+    {
+        for (auto& node : m_nodes)
+        {
+            node.remainingDependencies.store(node.dependencyCount, std::memory_order_relaxed);
+        }
+
+        // Successors are scheduled before their predecessor job returns, counter never drops to zero early
+        JobCounter counter{};
+        for (NodeId nodeId = 0; nodeId < m_nodes.size(); ++nodeId)
+        {
+            if (m_nodes[nodeId].dependencyCount == 0)
+            {
+                schedule(jobSystem, counter, nodeId);
+            }
+        }
+        jobSystem.wait(counter);
+    }
+}
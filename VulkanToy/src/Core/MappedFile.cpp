@@ -0,0 +1,126 @@
+//
+// Created by ZHIKANG on 2023/4/10.
+//
+
+#include <VulkanToy/Core/MappedFile.h>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace VT
+{
+    MappedFile::MappedFile(const std::filesystem::path &path)
+    : m_path(path)
+    {
+#ifdef _WIN32
+        HANDLE fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+        m_fileHandle = fileHandle;
+
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        {
+            release();
+            return;
+        }
+
+        m_mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mappingHandle == nullptr)
+        {
+            release();
+            return;
+        }
+
+        m_data = static_cast<const uint8_t *>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        m_size = m_data != nullptr ? static_cast<size_t>(fileSize.QuadPart) : 0;
+#else
+        m_fileDescriptor = ::open(path.c_str(), O_RDONLY);
+        if (m_fileDescriptor < 0)
+        {
+            return;
+        }
+
+        struct stat fileStat{};
+        if (::fstat(m_fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            release();
+            return;
+        }
+
+        void *mapped = ::mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+        if (mapped == MAP_FAILED)
+        {
+            release();
+            return;
+        }
+        // Whole file is consumed once by upload, ask kernel to read ahead
+        ::madvise(mapped, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+        m_data = static_cast<const uint8_t *>(mapped);
+        m_size = static_cast<size_t>(fileStat.st_size);
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+        release();
+    }
+
+    Ref<MappedFile> MappedFile::create(const std::filesystem::path &path)
+    {
+        auto mappedFile = CreateRef<MappedFile>(path);
+        if (!mappedFile->isValid())
+        {
+            return nullptr;
+        }
+        return mappedFile;
+    }
+
+    void MappedFile::release()
+    {
+#ifdef _WIN32
+        if (m_data != nullptr)
+        {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mappingHandle != nullptr)
+        {
+            CloseHandle(m_mappingHandle);
+            m_mappingHandle = nullptr;
+        }
+        if (m_fileHandle != nullptr)
+        {
+            CloseHandle(m_fileHandle);
+            m_fileHandle = nullptr;
+        }
+#else
+        if (m_data != nullptr)
+        {
+            ::munmap(const_cast<uint8_t *>(m_data), m_size);
+        }
+        if (m_fileDescriptor >= 0)
+        {
+            ::close(m_fileDescriptor);
+            m_fileDescriptor = -1;
+        }
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
@@ -0,0 +1,326 @@
+//
+// Created by ZHIKANG on 2023/4/23.
+//
+
+#include <VulkanToy/Core/Profiler.h>
+#include <VulkanToy/Core/JobSystem.h>
+#include <cstring>
+#include <iomanip>
+
+namespace VT
+{
+    static thread_local void *GProfilerThreadBuffer = nullptr;
+
+    static void writeJsonString(std::ofstream &file, const char *text)
+    {
+        file << '"';
+        for (const char *c = text; *c != '\0'; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                file << '\\';
+            }
+            file << *c;
+        }
+        file << '"';
+    }
+
+    Profiler::Profiler()
+    {
+        m_frameHistoryMs.resize(GProfilerFrameHistorySize, 0.0f);
+    }
+
+    uint64_t Profiler::getTimeNs() const
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count());
+    }
+
+    Profiler::ThreadBuffer& Profiler::getThreadBuffer()
+    {
+        if (GProfilerThreadBuffer == nullptr)
+        {
+            auto buffer = CreateScope<ThreadBuffer>();
+            const uint32_t jobThreadIndex = JobSystem::getThreadIndex();
+            std::lock_guard<std::mutex> lock{ m_threadMutex };
+            buffer->threadId = static_cast<uint32_t>(m_threadBuffers.size());
+            buffer->name = jobThreadIndex > 0 ? "Job Worker " + std::to_string(jobThreadIndex) : "Thread " + std::to_string(buffer->threadId);
+            GProfilerThreadBuffer = buffer.get();
+            m_threadBuffers.push_back(std::move(buffer));
+        }
+        return *static_cast<ThreadBuffer *>(GProfilerThreadBuffer);
+    }
+
+    void Profiler::beginZone()
+    {
+        getThreadBuffer().depth++;
+    }
+
+    void Profiler::endZone(const char *name, uint64_t beginNs)
+    {
+        const uint64_t endNs = getTimeNs();
+        auto& buffer = getThreadBuffer();
+        buffer.depth--;
+
+        const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        if (head - buffer.tail.load(std::memory_order_acquire) >= GProfilerThreadEventCapacity)
+        {
+            buffer.droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.events[head % GProfilerThreadEventCapacity] = ProfilerEvent{ name, beginNs, endNs, buffer.depth };
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Profiler::setThreadName(const std::string &name)
+    {
+        auto& buffer = getThreadBuffer();
+        std::lock_guard<std::mutex> lock{ m_threadMutex };
+        buffer.name = name;
+    }
+
+    const char* Profiler::internName(std::string_view name)
+    {
+        std::lock_guard<std::mutex> lock{ m_nameMutex };
+        return m_internedNames.emplace(name).first->c_str();
+    }
+
+    void Profiler::aggregate(std::vector<ProfilerEvent> &events, ProfilerThreadFrame &outFrame)
+    {
+        // Events arrive in end order, children before parents
+        std::sort(events.begin(), events.end(), [](const ProfilerEvent &a, const ProfilerEvent &b)
+        {
+            return a.beginNs != b.beginNs ? a.beginNs < b.beginNs : a.depth < b.depth;
+        });
+
+        struct OpenZone
+        {
+            uint32_t node;
+            uint32_t depth;
+            uint64_t endNs;
+        };
+        std::vector<OpenZone> openZones{};
+        auto& nodes = outFrame.nodes;
+        for (const auto& event : events)
+        {
+            // Parent zone may have started in an earlier frame, then event hangs at top level
+            while (!openZones.empty() && (openZones.back().depth >= event.depth || openZones.back().endNs <= event.beginNs))
+            {
+                openZones.pop_back();
+            }
+            const uint32_t parent = openZones.empty() ? UINT32_MAX : openZones.back().node;
+
+            uint32_t nodeIndex = UINT32_MAX;
+            for (uint32_t index = parent == UINT32_MAX ? 0 : parent + 1; index < nodes.size(); ++index)
+            {
+                if (nodes[index].parent == parent && std::strcmp(nodes[index].name, event.name) == 0)
+                {
+                    nodeIndex = index;
+                    break;
+                }
+            }
+            if (nodeIndex == UINT32_MAX)
+            {
+                nodeIndex = static_cast<uint32_t>(nodes.size());
+                auto& node = nodes.emplace_back();
+                node.name = event.name;
+                node.parent = parent;
+                node.depth = parent == UINT32_MAX ? 0 : nodes[parent].depth + 1;
+            }
+
+            const uint64_t durationNs = event.endNs - event.beginNs;
+            nodes[nodeIndex].callCount++;
+            nodes[nodeIndex].totalNs += durationNs;
+            if (parent != UINT32_MAX)
+            {
+                nodes[parent].childNs += durationNs;
+            }
+            openZones.push_back(OpenZone{ nodeIndex, event.depth, event.endNs });
+        }
+
+        // A child first seen in a later call lands after its parent's siblings, reorder depth first
+        std::vector<std::vector<uint32_t>> children(nodes.size());
+        std::vector<uint32_t> pending{};
+        for (uint32_t index = static_cast<uint32_t>(nodes.size()); index-- > 0;)
+        {
+            if (nodes[index].parent == UINT32_MAX)
+            {
+                pending.push_back(index);
+            } else
+            {
+                children[nodes[index].parent].push_back(index);
+            }
+        }
+
+        std::vector<ProfilerZoneNode> sortedNodes{};
+        std::vector<uint32_t> remap(nodes.size());
+        sortedNodes.reserve(nodes.size());
+        while (!pending.empty())
+        {
+            const uint32_t index = pending.back();
+            pending.pop_back();
+            remap[index] = static_cast<uint32_t>(sortedNodes.size());
+            auto& node = sortedNodes.emplace_back(nodes[index]);
+            if (node.parent != UINT32_MAX)
+            {
+                node.parent = remap[node.parent];
+            }
+            pending.insert(pending.end(), children[index].begin(), children[index].end());
+        }
+        nodes = std::move(sortedNodes);
+    }
+
+    void Profiler::markFrame()
+    {
+        const uint64_t nowNs = getTimeNs();
+
+        std::vector<ThreadBuffer *> buffers{};
+        {
+            std::lock_guard<std::mutex> lock{ m_threadMutex };
+            buffers.reserve(m_threadBuffers.size());
+            for (auto& buffer : m_threadBuffers)
+            {
+                buffers.push_back(buffer.get());
+            }
+        }
+
+        ProfilerFrame frame{};
+        frame.durationNs = nowNs - m_frameBeginNs;
+        std::vector<ProfilerEvent> events{};
+        std::lock_guard<std::mutex> lock{ m_frameMutex };
+        for (auto* buffer : buffers)
+        {
+            const uint64_t head = buffer->head.load(std::memory_order_acquire);
+            const uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+            frame.droppedEventCount += buffer->droppedCount.exchange(0, std::memory_order_relaxed);
+            if (head == tail)
+            {
+                continue;
+            }
+
+            events.clear();
+            for (uint64_t index = tail; index < head; ++index)
+            {
+                events.push_back(buffer->events[index % GProfilerThreadEventCapacity]);
+            }
+            buffer->tail.store(head, std::memory_order_release);
+
+            if (m_isCapturing)
+            {
+                for (const auto& event : events)
+                {
+                    if (m_captureEvents.size() >= GProfilerMaxCaptureEvents)
+                    {
+                        break;
+                    }
+                    m_captureEvents.push_back(CaptureEvent{ event, buffer->threadId });
+                }
+            }
+
+            auto& threadFrame = frame.threads.emplace_back();
+            {
+                std::lock_guard<std::mutex> threadLock{ m_threadMutex };
+                threadFrame.threadName = buffer->name;
+            }
+            aggregate(events, threadFrame);
+        }
+
+        frame.frameNumber = m_frameNumber++;
+        m_frameHistoryMs[m_frameHistoryOffset] = static_cast<float>(frame.durationNs) / 1e6f;
+        m_frameHistoryOffset = (m_frameHistoryOffset + 1) % GProfilerFrameHistorySize;
+        if (frame.droppedEventCount > 0)
+        {
+            VT_CORE_WARN("Profiler dropped {0} events in frame {1}", frame.droppedEventCount, frame.frameNumber);
+        }
+        if (m_isCapturing && m_frameNumber >= m_captureEndFrame)
+        {
+            m_isCapturing = false;
+        }
+
+        m_lastFrame = std::move(frame);
+        m_frameBeginNs = nowNs;
+    }
+
+    ProfilerFrame Profiler::getLastFrame()
+    {
+        std::lock_guard<std::mutex> lock{ m_frameMutex };
+        return m_lastFrame;
+    }
+
+    std::vector<float> Profiler::getFrameHistory()
+    {
+        std::lock_guard<std::mutex> lock{ m_frameMutex };
+        std::vector<float> history{};
+        history.reserve(GProfilerFrameHistorySize);
+        for (uint32_t index = 0; index < GProfilerFrameHistorySize; ++index)
+        {
+            history.push_back(m_frameHistoryMs[(m_frameHistoryOffset + index) % GProfilerFrameHistorySize]);
+        }
+        return history;
+    }
+
+    void Profiler::startCapture(uint32_t frameCount)
+    {
+        std::lock_guard<std::mutex> lock{ m_frameMutex };
+        m_captureEvents.clear();
+        m_captureEndFrame = m_frameNumber + frameCount;
+        m_isCapturing = true;
+    }
+
+    void Profiler::stopCapture()
+    {
+        std::lock_guard<std::mutex> lock{ m_frameMutex };
+        m_isCapturing = false;
+    }
+
+    bool Profiler::isCapturing()
+    {
+        std::lock_guard<std::mutex> lock{ m_frameMutex };
+        return m_isCapturing;
+    }
+
+    bool Profiler::exportChromeTrace(const std::filesystem::path &path)
+    {
+        std::ofstream file{ path, std::ios::out | std::ios::trunc };
+        if (!file.is_open())
+        {
+            VT_CORE_ERROR("Fail to open profiler trace file {0}", path.string());
+            return false;
+        }
+
+        std::vector<std::pair<uint32_t, std::string>> threadNames{};
+        {
+            std::lock_guard<std::mutex> lock{ m_threadMutex };
+            for (auto& buffer : m_threadBuffers)
+            {
+                threadNames.emplace_back(buffer->threadId, buffer->name);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock{ m_frameMutex };
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool isFirst = true;
+        for (const auto& [threadId, name] : threadNames)
+        {
+            file << (isFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << threadId << ",\"args\":{\"name\":";
+            writeJsonString(file, name.c_str());
+            file << "}}";
+            isFirst = false;
+        }
+
+        // Complete events, time stamps in microseconds
+        file << std::fixed << std::setprecision(3);
+        for (const auto& captured : m_captureEvents)
+        {
+            file << (isFirst ? "" : ",\n") << "{\"name\":";
+            writeJsonString(file, captured.event.name);
+            file << ",\"cat\":\"CPU\",\"ph\":\"X\",\"pid\":0,\"tid\":" << captured.threadId
+                << ",\"ts\":" << static_cast<double>(captured.event.beginNs) / 1e3
+                << ",\"dur\":" << static_cast<double>(captured.event.endNs - captured.event.beginNs) / 1e3 << "}";
+            isFirst = false;
+        }
+        file << "\n]}\n";
+
+        VT_CORE_INFO("Profiler trace with {0} events exported to {1}", m_captureEvents.size(), path.string());
+        return true;
+    }
+}
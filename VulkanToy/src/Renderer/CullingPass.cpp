@@ -0,0 +1,77 @@
+//
+// Created by ZHIKANG on 2023/4/17.
+//
+
+#include <VulkanToy/Renderer/CullingPass.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+#include <VulkanToy/Scene/Scene.h>
+
+namespace VT
+{
+    void CullingPass::init(const PassAttachmentFormats &formats)
+    {
+        VT_PROFILE_SCOPE("CullingPass::init");
+        // Same bindings as instance set of mesh pipelines, so one descriptor set serves both
+        const std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = InstanceBatcher::getDescriptorSetLayoutBindings();
+        VkDescriptorSetLayoutCreateInfo descriptorLayout = Initializers::initDescriptorSetLayoutCreateInfo(setLayoutBindings);
+        RHICheck(vkCreateDescriptorSetLayout(VulkanRHI::Device, &descriptorLayout, nullptr, &m_instanceDescriptorSetLayout));
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = Initializers::initPipelineLayout(&m_instanceDescriptorSetLayout, 1);
+        VkPushConstantRange pushConstantRange = Initializers::initPushConstantRange(VK_SHADER_STAGE_COMPUTE_BIT, sizeof(GPUCullingPushConstants), 0);
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        RHICheck(vkCreatePipelineLayout(VulkanRHI::Device, &pipelineLayoutCreateInfo, nullptr, &m_cullingPipelineLayout));
+
+        auto shaderModuleComp = VulkanRHI::ShaderManager->getShader("GPUCulling.comp.spv");
+        const VkPipelineShaderStageCreateInfo shaderStage{ VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0,
+                                                            VK_SHADER_STAGE_COMPUTE_BIT, shaderModuleComp, "main", nullptr };
+        VkComputePipelineCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        createInfo.stage = shaderStage;
+        createInfo.layout = m_cullingPipelineLayout;
+        m_cullingPipeline = VulkanRHI::get()->getPipelineCache().createComputePipeline(createInfo, "GPUCulling");
+    }
+
+    void CullingPass::release()
+    {
+        if (m_instanceDescriptorSetLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(VulkanRHI::Device, m_instanceDescriptorSetLayout, nullptr);
+        }
+        if (m_cullingPipelineLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(VulkanRHI::Device, m_cullingPipelineLayout, nullptr);
+        }
+        if (m_cullingPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(VulkanRHI::Device, m_cullingPipeline, nullptr);
+        }
+    }
+
+    void CullingPass::addToRenderGraph(RenderGraph &graph, PassFrameResources &resources)
+    {
+        VT_PROFILE_SCOPE("CullingPass::addToRenderGraph");
+        auto scene = SceneHandle::Get();
+        scene->prepareDrawBatches(resources.frameIndex);
+
+        const auto& batcher = scene->getInstanceBatcher();
+        if (batcher.getInstanceCount() == 0)
+        {
+            return;
+        }
+
+        resources.instanceIndirectBuffer = graph.importBuffer("InstanceIndirect", batcher.getIndirectBuffer());
+        resources.instanceVisibleBuffer = graph.importBuffer("InstanceVisible", batcher.getVisibleBuffer());
+
+        graph.addPass("GPUCulling", [&resources] (RenderGraphPassBuilder &builder)
+        {
+            builder.write(resources.instanceIndirectBuffer, RenderGraphAccess::ComputeStorageWrite);
+            builder.write(resources.instanceVisibleBuffer, RenderGraphAccess::ComputeStorageWrite);
+        }, [this] (VkCommandBuffer cmd, const RenderGraph &graph)
+        {
+            auto scene = SceneHandle::Get();
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullingPipeline);
+            scene->getInstanceBatcher().cull(cmd, m_cullingPipelineLayout, scene->getFrustum().m_Plane);
+        });
+    }
+}
@@ -0,0 +1,197 @@
+//
+// Created by ZHIKANG on 2023/4/16.
+//
+
+#include <VulkanToy/Renderer/FrustumCuller.h>
+#include <VulkanToy/Core/JobSystem.h>
+
+#if defined(__AVX__)
+    #define VT_CULLING_AVX 1
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define VT_CULLING_SSE 1
+    #include <emmintrin.h>
+#endif
+
+namespace VT
+{
+    // Padding entries sit far behind every plane
+    constexpr float GCulledRadius = -std::numeric_limits<float>::max();
+
+    void CullingBoundsTable::resize(uint32_t count)
+    {
+        const uint32_t paddedCount = (count + GCullingBatchSize - 1) / GCullingBatchSize * GCullingBatchSize;
+        for (auto* array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ })
+        {
+            array->resize(paddedCount, 0.0f);
+        }
+        m_radius.resize(paddedCount, GCulledRadius);
+        std::fill(m_radius.begin() + count, m_radius.end(), GCulledRadius);
+        std::fill(m_extentX.begin() + count, m_extentX.end(), 0.0f);
+        std::fill(m_extentY.begin() + count, m_extentY.end(), 0.0f);
+        std::fill(m_extentZ.begin() + count, m_extentZ.end(), 0.0f);
+        m_count = count;
+    }
+
+    void CullingBoundsTable::set(uint32_t index, const glm::vec3 &center, const glm::vec3 &extent, float radius)
+    {
+        VT_CORE_ASSERT(index < m_count, "Culling bound index out of range");
+        m_centerX[index] = center.x;
+        m_centerY[index] = center.y;
+        m_centerZ[index] = center.z;
+        m_extentX[index] = extent.x;
+        m_extentY[index] = extent.y;
+        m_extentZ[index] = extent.z;
+        m_radius[index] = radius;
+    }
+
+    void CullingBoundsTable::setAlwaysVisible(uint32_t index)
+    {
+        // Large but finite, plane distance plus radius never overflows to NaN
+        constexpr float huge = 1e30f;
+        set(index, glm::vec3{ 0.0f }, glm::vec3{ huge }, huge);
+    }
+
+    uint32_t FrustumCuller::cull(const Frustum &frustum, const CullingBoundsTable &bounds,
+                                uint32_t begin, uint32_t end, uint32_t *outVisible)
+    {
+        VT_CORE_ASSERT(begin % GCullingBatchSize == 0 && end <= bounds.getCount(), "Invalid culling range");
+
+#if defined(VT_CULLING_AVX) || defined(VT_CULLING_SSE)
+    #if defined(VT_CULLING_AVX)
+        using Lane = __m256;
+        constexpr uint32_t laneCount = 8;
+        auto broadcast = [](float value) { return _mm256_set1_ps(value); };
+        auto load = [](const float *data) { return _mm256_loadu_ps(data); };
+        auto add = [](Lane a, Lane b) { return _mm256_add_ps(a, b); };
+        auto mul = [](Lane a, Lane b) { return _mm256_mul_ps(a, b); };
+        auto min = [](Lane a, Lane b) { return _mm256_min_ps(a, b); };
+        auto bitAnd = [](Lane a, Lane b) { return _mm256_and_ps(a, b); };
+        auto greater = [](Lane a, Lane b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); };
+        auto moveMask = [](Lane a) { return static_cast<uint32_t>(_mm256_movemask_ps(a)); };
+        const Lane allVisible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    #else
+        using Lane = __m128;
+        constexpr uint32_t laneCount = 4;
+        auto broadcast = [](float value) { return _mm_set1_ps(value); };
+        auto load = [](const float *data) { return _mm_loadu_ps(data); };
+        auto add = [](Lane a, Lane b) { return _mm_add_ps(a, b); };
+        auto mul = [](Lane a, Lane b) { return _mm_mul_ps(a, b); };
+        auto min = [](Lane a, Lane b) { return _mm_min_ps(a, b); };
+        auto bitAnd = [](Lane a, Lane b) { return _mm_and_ps(a, b); };
+        auto greater = [](Lane a, Lane b) { return _mm_cmpgt_ps(a, b); };
+        auto moveMask = [](Lane a) { return static_cast<uint32_t>(_mm_movemask_ps(a)); };
+        const Lane allVisible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    #endif
+
+        // Planes broadcast once, absolute normal projects box extent onto plane normal
+        Lane planeX[6], planeY[6], planeZ[6], planeW[6];
+        Lane absPlaneX[6], absPlaneY[6], absPlaneZ[6];
+        for (uint32_t plane = 0; plane < 6; ++plane)
+        {
+            const glm::vec4 &p = frustum.m_Plane[plane];
+            planeX[plane] = broadcast(p.x);
+            planeY[plane] = broadcast(p.y);
+            planeZ[plane] = broadcast(p.z);
+            planeW[plane] = broadcast(p.w);
+            absPlaneX[plane] = broadcast(std::abs(p.x));
+            absPlaneY[plane] = broadcast(std::abs(p.y));
+            absPlaneZ[plane] = broadcast(std::abs(p.z));
+        }
+        const Lane zero = broadcast(0.0f);
+
+        uint32_t visibleCount = 0;
+        for (uint32_t base = begin; base < end; base += laneCount)
+        {
+            const Lane centerX = load(bounds.getCenterX() + base);
+            const Lane centerY = load(bounds.getCenterY() + base);
+            const Lane centerZ = load(bounds.getCenterZ() + base);
+            const Lane extentX = load(bounds.getExtentX() + base);
+            const Lane extentY = load(bounds.getExtentY() + base);
+            const Lane extentZ = load(bounds.getExtentZ() + base);
+            const Lane radius = load(bounds.getRadius() + base);
+
+            Lane visible = allVisible;
+            for (uint32_t plane = 0; plane < 6; ++plane)
+            {
+                const Lane distance = add(add(mul(planeX[plane], centerX), mul(planeY[plane], centerY)),
+                                        add(mul(planeZ[plane], centerZ), planeW[plane]));
+                const Lane boxRadius = add(add(mul(absPlaneX[plane], extentX), mul(absPlaneY[plane], extentY)),
+                                            mul(absPlaneZ[plane], extentZ));
+                visible = bitAnd(visible, greater(add(distance, min(radius, boxRadius)), zero));
+            }
+
+            // Branchless compaction, every lane writes and only visible lanes advance
+            const uint32_t mask = moveMask(visible);
+            for (uint32_t lane = 0; lane < laneCount; ++lane)
+            {
+                outVisible[visibleCount] = base + lane;
+                visibleCount += ((mask >> lane) & 1u) & static_cast<uint32_t>(base + lane < end);
+            }
+        }
+        return visibleCount;
+#else
+        return cullScalar(frustum, bounds, begin, end, outVisible);
+#endif
+    }
+
+    uint32_t FrustumCuller::cullScalar(const Frustum &frustum, const CullingBoundsTable &bounds,
+                                        uint32_t begin, uint32_t end, uint32_t *outVisible)
+    {
+        uint32_t visibleCount = 0;
+        for (uint32_t index = begin; index < end; ++index)
+        {
+            bool isVisible = true;
+            for (uint32_t plane = 0; plane < 6 && isVisible; ++plane)
+            {
+                const glm::vec4 &p = frustum.m_Plane[plane];
+                const float distance = p.x * bounds.getCenterX()[index] + p.y * bounds.getCenterY()[index] +
+                                        p.z * bounds.getCenterZ()[index] + p.w;
+                const float boxRadius = std::abs(p.x) * bounds.getExtentX()[index] +
+                                        std::abs(p.y) * bounds.getExtentY()[index] +
+                                        std::abs(p.z) * bounds.getExtentZ()[index];
+                isVisible = distance + std::min(bounds.getRadius()[index], boxRadius) > 0.0f;
+            }
+            if (isVisible)
+            {
+                outVisible[visibleCount++] = index;
+            }
+        }
+        return visibleCount;
+    }
+
+    void FrustumCuller::cullAll(const Frustum &frustum, const CullingBoundsTable &bounds,
+                                std::vector<uint32_t> &outVisible)
+    {
+        const uint32_t count = bounds.getCount();
+        outVisible.resize((count + GCullingBatchSize - 1) / GCullingBatchSize * GCullingBatchSize);
+
+        const uint32_t chunkCount = (count + GCullingChunkSize - 1) / GCullingChunkSize;
+        if (chunkCount <= 1)
+        {
+            outVisible.resize(cull(frustum, bounds, 0, count, outVisible.data()));
+            return;
+        }
+
+        // Each chunk writes at its own offset, then chunks are packed in order
+        std::vector<uint32_t> chunkVisibleCounts(chunkCount, 0);
+        JobSystemHandle::Get()->parallelFor(chunkCount, 1, [&](uint32_t beginChunk, uint32_t endChunk)
+        {
+            for (uint32_t chunk = beginChunk; chunk < endChunk; ++chunk)
+            {
+                const uint32_t begin = chunk * GCullingChunkSize;
+                const uint32_t end = std::min(begin + GCullingChunkSize, count);
+                chunkVisibleCounts[chunk] = cull(frustum, bounds, begin, end, outVisible.data() + begin);
+            }
+        });
+
+        uint32_t visibleCount = chunkVisibleCounts[0];
+        for (uint32_t chunk = 1; chunk < chunkCount; ++chunk)
+        {
+            const auto source = outVisible.begin() + chunk * GCullingChunkSize;
+            std::copy(source, source + chunkVisibleCounts[chunk], outVisible.begin() + visibleCount);
+            visibleCount += chunkVisibleCounts[chunk];
+        }
+        outVisible.resize(visibleCount);
+    }
+}
@@ -14,7 +14,7 @@ namespace VT
         initInfo->Device = VulkanRHI::Device;
         initInfo->QueueFamily = VulkanRHI::get()->getGraphicsFamily();
         initInfo->Queue = VulkanRHI::get()->getMajorGraphicsQueue();
-        initInfo->PipelineCache = VK_NULL_HANDLE;
+        initInfo->PipelineCache = VulkanRHI::get()->getPipelineCache().get();
         initInfo->DescriptorPool = pool;
         initInfo->Allocator = nullptr;
         initInfo->MinImageCount = static_cast<uint32_t>(VulkanRHI::get()->getSwapChainImageViews().size());
@@ -28,18 +28,18 @@ namespace VT
     {
         vkDeviceWaitIdle(VulkanRHI::Device);
 
-        // Create render pass
+        // Create render pass, render graph moves swap chain image into color attachment layout and to present after
         if (m_renderResource.renderPass == VK_NULL_HANDLE)
         {
             VkAttachmentDescription attachmentDesc{};
-            attachmentDesc.format = m_drawUIFormat;
+            attachmentDesc.format = VulkanRHI::get()->getSwapChainFormat();
             attachmentDesc.samples = VK_SAMPLE_COUNT_1_BIT;
-            attachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
             attachmentDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
             attachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             attachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            attachmentDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            attachmentDesc.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;  // Blit to back buffer
+            attachmentDesc.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachmentDesc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
             VkAttachmentReference colorAttachment{};
             colorAttachment.attachment = 0;
@@ -50,48 +50,16 @@ namespace VT
             subpass.colorAttachmentCount = 1;
             subpass.pColorAttachments = &colorAttachment;
 
-            VkSubpassDependency dependency{};
-            dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-            dependency.dstSubpass = 0;
-            dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            dependency.srcAccessMask = 0;
-            dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
             VkRenderPassCreateInfo info{};
             info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
             info.attachmentCount = 1;
             info.pAttachments = &attachmentDesc;
             info.subpassCount = 1;
             info.pSubpasses = &subpass;
-            info.dependencyCount = 1;
-            info.pDependencies = &dependency;
             RHICheck(vkCreateRenderPass(VulkanRHI::Device, &info, nullptr, &m_renderResource.renderPass));
         }
 
-        {
-            VkImageCreateInfo imageCreateInfo{};
-            imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-            imageCreateInfo.flags = 0;
-            imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-            imageCreateInfo.format = VK_FORMAT_R16G16B16A16_SFLOAT;
-            imageCreateInfo.extent.width = VulkanRHI::get()->getSwapChainExtent().width;
-            imageCreateInfo.extent.height = VulkanRHI::get()->getSwapChainExtent().height;
-            imageCreateInfo.extent.depth = 1;
-            imageCreateInfo.mipLevels = 1;
-            imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-            imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-            imageCreateInfo.arrayLayers = 1;
-            imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-            imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-            imageCreateInfo.queueFamilyIndexCount = 0;
-            imageCreateInfo.pQueueFamilyIndices = nullptr;
-            imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
-            m_drawUIImages = VulkanImage::create("DrawUIImage", imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        }
-
-        // Create frame buffer and command buffer
+        // Create frame buffers
         {
             VkImageView attachment[1];
             VkFramebufferCreateInfo fbCreateInfo{};
@@ -103,43 +71,13 @@ namespace VT
             fbCreateInfo.height = VulkanRHI::get()->getSwapChainExtent().height;
             fbCreateInfo.layers = 1;
 
-            auto backBufferSize = VulkanRHI::get()->getSwapChainImageViews().size();
-            m_renderResource.frameBuffers.resize(backBufferSize);
-            m_renderResource.commandPools.resize(backBufferSize);
-            m_renderResource.commandBuffers.resize(backBufferSize);
-
-            for (uint32_t i = 0; i < backBufferSize; ++i)
+            const auto& swapChainImageViews = VulkanRHI::get()->getSwapChainImageViews();
+            m_renderResource.frameBuffers.resize(swapChainImageViews.size());
+            for (uint32_t i = 0; i < swapChainImageViews.size(); ++i)
             {
-                VkImageSubresourceRange range{};
-                range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                range.baseMipLevel = 0;
-                range.levelCount = VK_REMAINING_MIP_LEVELS;
-                range.baseArrayLayer = 0;
-                range.layerCount = VK_REMAINING_ARRAY_LAYERS;
-                attachment[0] = m_drawUIImages->getView(range);
+                attachment[0] = swapChainImageViews[i];
                 RHICheck(vkCreateFramebuffer(VulkanRHI::Device, &fbCreateInfo, nullptr, &m_renderResource.frameBuffers[i]));
             }
-
-            for (uint32_t i = 0; i < backBufferSize; ++i)
-            {
-                // Command pool
-                {
-                    VkCommandPoolCreateInfo poolCreateInfo{};
-                    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-                    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-                    poolCreateInfo.queueFamilyIndex = VulkanRHI::get()->getGraphicsFamily();
-                    RHICheck(vkCreateCommandPool(VulkanRHI::Device, &poolCreateInfo, nullptr, &m_renderResource.commandPools[i]));
-                }
-                // Command buffer
-                {
-                    VkCommandBufferAllocateInfo bufferAllocateInfo{};
-                    bufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-                    bufferAllocateInfo.commandPool = m_renderResource.commandPools[i];
-                    bufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-                    bufferAllocateInfo.commandBufferCount = 1;
-                    RHICheck(vkAllocateCommandBuffers(VulkanRHI::Device, &bufferAllocateInfo, &m_renderResource.commandBuffers[i]));
-                }
-            }
         }
     }
 
@@ -150,23 +88,24 @@ namespace VT
         if (isFullRelease)
         {
             vkDestroyRenderPass(VulkanRHI::Device, m_renderResource.renderPass, nullptr);
+            m_renderResource.renderPass = VK_NULL_HANDLE;
         }
 
-        auto backBufferSize = m_renderResource.frameBuffers.size();
-        for (uint32_t i = 0; i < backBufferSize; ++i)
+        for (auto frameBuffer : m_renderResource.frameBuffers)
         {
-            vkFreeCommandBuffers(VulkanRHI::Device, m_renderResource.commandPools[i], 1, &m_renderResource.commandBuffers[i]);
-            vkDestroyCommandPool(VulkanRHI::Device, m_renderResource.commandPools[i], nullptr);
-            vkDestroyFramebuffer(VulkanRHI::Device, m_renderResource.frameBuffers[i], nullptr);
+            vkDestroyFramebuffer(VulkanRHI::Device, frameBuffer, nullptr);
         }
-
         m_renderResource.frameBuffers.clear();
-        m_renderResource.commandPools.clear();
-        m_renderResource.commandBuffers.clear();
     }
 
     void ImGuiPass::init()
     {
+        // ImGui context, glfw backend chains to window callbacks installed before it
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGui::StyleColorsDark();
+        ImGui_ImplGlfw_InitForVulkan(VulkanRHI::get()->getWindow(), true);
+
         // prepare descriptor pool
         {
             VkDescriptorPoolSize poolSizes[]{
@@ -194,7 +133,13 @@ namespace VT
 
         buildRenderPass();
 
-        // Register swap chain rebuild function
+        // Register swap chain rebuild function, frame buffers reference swap chain image views
+        m_swapChainRebuildHandle = VulkanRHI::get()->onAfterSwapChainRebuild.subscribe([this] ()
+        {
+            releaseRenderPass(false);
+            buildRenderPass();
+            ImGui_ImplVulkan_SetMinImageCount(static_cast<uint32_t>(VulkanRHI::get()->getSwapChainImageViews().size()));
+        });
 
         // Initialize vulkan resource
         ImGui_ImplVulkan_InitInfo vkInitInfo{};
@@ -204,143 +149,237 @@ namespace VT
         ImGui_ImplVulkan_Init(&vkInitInfo, m_renderResource.renderPass);
 
         // Upload font texture
-        VkCommandPool commandPool = m_renderResource.commandPools[0];
-        VkCommandBuffer commandBuffer = m_renderResource.commandBuffers[0];
-        RHICheck(vkResetCommandPool(VulkanRHI::Device, commandPool, 0));
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-        RHICheck(vkBeginCommandBuffer(commandBuffer, &beginInfo));
-        ImGui_ImplVulkan_CreateFontsTexture(commandBuffer);
-        VkSubmitInfo endInfo{};
-        endInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        endInfo.commandBufferCount = 1;
-        endInfo.pCommandBuffers = &commandBuffer;
-        RHICheck(vkEndCommandBuffer(commandBuffer));
-        RHICheck(vkQueueSubmit(vkInitInfo.Queue, 1, &endInfo, VK_NULL_HANDLE));
-        RHICheck(vkDeviceWaitIdle(vkInitInfo.Device));
+        VulkanRHI::executeImmediatelyMajorGraphics([] (VkCommandBuffer commandBuffer)
+        {
+            ImGui_ImplVulkan_CreateFontsTexture(commandBuffer);
+        });
         ImGui_ImplVulkan_DestroyFontUploadObjects();
+
+        m_isInit = true;
     }
 
-    void ImGuiPass::renderFrame(uint32_t backBufferIndex)
+    void ImGuiPass::beginFrame()
     {
-        ImDrawData* mainDrawData = ImGui::GetDrawData();
+        ImGui_ImplVulkan_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+    }
+
+    void ImGuiPass::endFrame()
+    {
+        ImGui::Render();
+    }
+
+    void ImGuiPass::addToRenderGraph(RenderGraph &graph, PassFrameResources &resources)
+    {
+        VT_PROFILE_SCOPE("ImGuiPass::addToRenderGraph");
+        // Not a graph attachment, ImGui backend records its own render pass which loads tone mapped image
+        graph.addPass("ImGui", [&resources] (RenderGraphPassBuilder &builder)
         {
-            RHICheck(vkResetCommandPool(VulkanRHI::Device, m_renderResource.commandPools[backBufferIndex], 0));
-            VkCommandBufferBeginInfo info{};
-            info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-            RHICheck(vkBeginCommandBuffer(m_renderResource.commandBuffers[backBufferIndex], &info));
-            VulkanRHI::setPerfMarkerBegin(m_renderResource.commandBuffers[backBufferIndex], "ImGUI", { 1.0f, 1.0f, 0.0f, 1.0f });
-        }
+            builder.write(resources.swapChain, RenderGraphAccess::ColorAttachment);
+        }, [this, resources] (VkCommandBuffer cmd, const RenderGraph &graph)
         {
-            VkRenderPassBeginInfo rpBeginInfo{};
-            rpBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            rpBeginInfo.renderPass = m_renderResource.renderPass;
-            rpBeginInfo.framebuffer = m_renderResource.frameBuffers[backBufferIndex];
-            rpBeginInfo.renderArea.extent.width = VulkanRHI::get()->getSwapChainExtent().width;
-            rpBeginInfo.renderArea.extent.height = VulkanRHI::get()->getSwapChainExtent().height;
-            rpBeginInfo.clearValueCount = 1;
-
-            VkClearValue clearColor{};
-            clearColor.color.float32[0] = m_clearColor.x * m_clearColor.w;
-            clearColor.color.float32[1] = m_clearColor.y * m_clearColor.w;
-            clearColor.color.float32[2] = m_clearColor.z * m_clearColor.w;
-            clearColor.color.float32[3] = m_clearColor.w;
-            rpBeginInfo.pClearValues = &clearColor;
-            vkCmdBeginRenderPass(m_renderResource.commandBuffers[backBufferIndex], &rpBeginInfo, VK_SUBPASS_CONTENTS_INLINE);   // TODO: fix
-        }
-
-        ImGui_ImplVulkan_RenderDrawData(mainDrawData, m_renderResource.commandBuffers[backBufferIndex]);
-
-        vkCmdEndRenderPass(m_renderResource.commandBuffers[backBufferIndex]);
-        VulkanRHI::setPerfMarkerEnd(m_renderResource.commandBuffers[backBufferIndex]);
-
-        VkImageMemoryBarrier barrier{};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = VulkanRHI::get()->getSwapChainImages().at(backBufferIndex);
-        VkImageSubresourceRange range{};
-        range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        range.baseMipLevel = 0;
-        range.levelCount = VK_REMAINING_MIP_LEVELS;
-        range.baseArrayLayer = 0;
-        range.layerCount = VK_REMAINING_ARRAY_LAYERS;
-        barrier.subresourceRange = range;
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        vkCmdPipelineBarrier(m_renderResource.commandBuffers[backBufferIndex],
-                VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
-                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                {},
-                0,
-                nullptr,
-                0,
-                nullptr,
-                1,
-                &barrier);
-
-        VkImageSubresourceLayers copyLayer{
-            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-            .mipLevel = 0,
-            .baseArrayLayer = 0,
-            .layerCount = 1,};
-
-        VkImageBlit copyRegion{
-            .srcSubresource = copyLayer,
-            .dstSubresource = copyLayer,};
-
-        copyRegion.srcOffsets[0] = { 0, 0, 0 };
-        copyRegion.dstOffsets[0] = copyRegion.srcOffsets[0];
-        copyRegion.srcOffsets[1] = { (int)m_drawUIImages.get()->getExtent().width, (int)m_drawUIImages.get()->getExtent().height, 1 };
-        copyRegion.dstOffsets[1] = copyRegion.srcOffsets[1];
-
-        vkCmdBlitImage(m_renderResource.commandBuffers[backBufferIndex],
-                        m_drawUIImages->getImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                        VulkanRHI::get()->getSwapChainImages().at(backBufferIndex), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        1, &copyRegion, VK_FILTER_NEAREST);
-
-        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        vkCmdPipelineBarrier(m_renderResource.commandBuffers[backBufferIndex],
-                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                {},
-                0,
-                nullptr,
-                0,
-                nullptr,
-                1,
-                &barrier);
-
-        RHICheck(vkEndCommandBuffer(m_renderResource.commandBuffers[backBufferIndex]));
+            renderFrame(cmd, resources.imageIndex);
+        });
     }
 
-    void ImGuiPass::release()
+    void ImGuiPass::renderFrame(VkCommandBuffer cmd, uint32_t backBufferIndex)
     {
-        // unregister swap chain rebuild functions
+        ImDrawData* mainDrawData = ImGui::GetDrawData();
+        if (mainDrawData == nullptr)
+        {
+            return;
+        }
 
-        // shut down vulkan
-        ImGui_ImplVulkan_Shutdown();
+        VkRenderPassBeginInfo rpBeginInfo{};
+        rpBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        rpBeginInfo.renderPass = m_renderResource.renderPass;
+        rpBeginInfo.framebuffer = m_renderResource.frameBuffers[backBufferIndex];
+        rpBeginInfo.renderArea.extent.width = VulkanRHI::get()->getSwapChainExtent().width;
+        rpBeginInfo.renderArea.extent.height = VulkanRHI::get()->getSwapChainExtent().height;
+        vkCmdBeginRenderPass(cmd, &rpBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-        releaseRenderPass(true);
-        vkDestroyDescriptorPool(VulkanRHI::Device, m_renderResource.descriptorPool, nullptr);
+        ImGui_ImplVulkan_RenderDrawData(mainDrawData, cmd);
+
+        vkCmdEndRenderPass(cmd);
     }
-}
 
+    void ImGuiPass::drawProfilerPanel(bool *isOpen)
+    {
+        if (!ImGui::Begin("Profiler", isOpen))
+        {
+            ImGui::End();
+            return;
+        }
 
+        auto profiler = ProfilerHandle::Get();
+        if (!m_isProfilerPaused)
+        {
+            m_profilerFrame = profiler->getLastFrame();
+        }
 
+        const auto history = profiler->getFrameHistory();
+        const float frameMs = static_cast<float>(m_profilerFrame.durationNs) / 1e6f;
+        ImGui::Text("Frame %llu: %.3f ms", static_cast<unsigned long long>(m_profilerFrame.frameNumber), frameMs);
+        ImGui::PlotLines("##FrameTimes", history.data(), static_cast<int>(history.size()), 0, nullptr, 0.0f, 33.3f, ImVec2{ 0.0f, 60.0f });
+        if (m_profilerFrame.droppedEventCount > 0)
+        {
+            ImGui::TextColored(ImVec4{ 1.0f, 0.4f, 0.4f, 1.0f }, "%u events dropped", m_profilerFrame.droppedEventCount);
+        }
 
+        ImGui::Checkbox("Pause", &m_isProfilerPaused);
+        ImGui::SameLine();
+        if (profiler->isCapturing())
+        {
+            if (ImGui::Button("Stop capture"))
+            {
+                profiler->stopCapture();
+            }
+        } else if (ImGui::Button("Capture"))
+        {
+            profiler->startCapture(m_profilerCaptureFrames);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Export trace"))
+        {
+            profiler->exportChromeTrace("VulkanToyTrace.json");
+        }
 
+        constexpr ImGuiTableFlags tableFlags = ImGuiTableFlags_BordersV | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+        if (ImGui::BeginTable("##ProfilerZones", 4, tableFlags))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("Total ms", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+            ImGui::TableSetupColumn("Self ms", ImGuiTableColumnFlags_WidthFixed, 70.0f);
+            ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+            ImGui::TableHeadersRow();
+
+            for (const auto& thread : m_profilerFrame.threads)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                if (!ImGui::TreeNodeEx(thread.threadName.c_str(), ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_SpanFullWidth))
+                {
+                    continue;
+                }
 
+                // Nodes are in call order with parents first, skip subtrees of collapsed nodes
+                uint32_t openDepth = 0;
+                for (uint32_t index = 0; index < thread.nodes.size(); ++index)
+                {
+                    const auto& node = thread.nodes[index];
+                    while (openDepth > node.depth)
+                    {
+                        ImGui::TreePop();
+                        openDepth--;
+                    }
+                    if (node.depth > openDepth)
+                    {
+                        continue;
+                    }
+
+                    const bool isLeaf = index + 1 >= thread.nodes.size() || thread.nodes[index + 1].parent != index;
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::PushID(static_cast<int>(index));
+                    const bool isOpen = ImGui::TreeNodeEx(node.name, isLeaf ?
+                            ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_SpanFullWidth :
+                            ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_SpanFullWidth);
+                    ImGui::PopID();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", static_cast<double>(node.totalNs) / 1e6);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", static_cast<double>(node.getSelfNs()) / 1e6);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%u", node.callCount);
+
+                    if (!isLeaf && isOpen)
+                    {
+                        openDepth++;
+                    }
+                }
+                while (openDepth > 0)
+                {
+                    ImGui::TreePop();
+                    openDepth--;
+                }
+                ImGui::TreePop();
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
 
+    void ImGuiPass::drawGPUProfilerOverlay(bool *isOpen)
+    {
+        const auto& gpuProfiler = VulkanRHI::get()->getGPUProfiler();
+
+        constexpr ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings |
+                                                ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
+        const ImGuiViewport *viewport = ImGui::GetMainViewport();
+        ImGui::SetNextWindowPos(ImVec2{ viewport->WorkPos.x + viewport->WorkSize.x - 10.0f, viewport->WorkPos.y + 10.0f }, ImGuiCond_Always, ImVec2{ 1.0f, 0.0f });
+        ImGui::SetNextWindowBgAlpha(0.35f);
+        if (!ImGui::Begin("GPU Profiler", isOpen, windowFlags))
+        {
+            ImGui::End();
+            return;
+        }
+
+        if (!gpuProfiler.isSupported())
+        {
+            ImGui::TextUnformatted("GPU timestamps are not supported");
+            ImGui::End();
+            return;
+        }
 
+        if (ImGui::BeginTable("##GPUZones", 5, ImGuiTableFlags_SizingFixedFit))
+        {
+            ImGui::TableSetupColumn("GPU zone");
+            ImGui::TableSetupColumn("Last ms");
+            ImGui::TableSetupColumn("Min ms");
+            ImGui::TableSetupColumn("Avg ms");
+            ImGui::TableSetupColumn("Max ms");
+            ImGui::TableHeadersRow();
+
+            for (const auto& timing : gpuProfiler.getZoneTimings())
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Indent(static_cast<float>(timing.depth) * 10.0f);
+                ImGui::TextUnformatted(timing.name.c_str());
+                ImGui::Unindent(static_cast<float>(timing.depth) * 10.0f);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", timing.lastMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", timing.minMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", timing.avgMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", timing.maxMs);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
 
+    void ImGuiPass::release()
+    {
+        if (!m_isInit)
+        {
+            return;
+        }
 
+        // unregister swap chain rebuild functions
+        VulkanRHI::get()->onAfterSwapChainRebuild.unsubscribe(m_swapChainRebuildHandle);
 
+        // shut down vulkan and glfw backends
+        ImGui_ImplVulkan_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
 
+        releaseRenderPass(true);
+        vkDestroyDescriptorPool(VulkanRHI::Device, m_renderResource.descriptorPool, nullptr);
+        m_isInit = false;
+    }
+}
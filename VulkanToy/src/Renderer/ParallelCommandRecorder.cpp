@@ -0,0 +1,143 @@
+//
+// Created by ZHIKANG on 2023/4/18.
+//
+
+#include <VulkanToy/Renderer/ParallelCommandRecorder.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+#include <VulkanToy/Core/JobSystem.h>
+
+namespace VT
+{
+    void ParallelCommandRecorder::init(uint32_t threadCount)
+    {
+        m_threadCount = threadCount != 0 ? threadCount : JobSystemHandle::Get()->getConcurrency();
+
+        m_inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        m_inheritanceInfo.pNext = &m_renderingInfo;
+        m_renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        m_renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    }
+
+    void ParallelCommandRecorder::release()
+    {
+        for (auto& threadResources : m_frameResources)
+        {
+            for (auto& resource : threadResources)
+            {
+                // Command buffers are freed with their pool
+                vkDestroyCommandPool(VulkanRHI::Device, resource.pool, nullptr);
+            }
+        }
+        m_frameResources.clear();
+    }
+
+    void ParallelCommandRecorder::beginFrame(uint32_t frameIndex, const std::vector<VkFormat> &colorFormats, VkFormat depthFormat, VkFormat stencilFormat,
+                                            const VkViewport &viewport, const VkRect2D &scissor)
+    {
+        if (frameIndex >= m_frameResources.size())
+        {
+            m_frameResources.resize(frameIndex + 1);
+        }
+
+        auto& threadResources = m_frameResources[frameIndex];
+        if (threadResources.empty())
+        {
+            VkCommandPoolCreateInfo poolCreateInfo{};
+            poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolCreateInfo.queueFamilyIndex = VulkanRHI::get()->getGraphicsFamily();
+
+            threadResources.resize(m_threadCount);
+            for (auto& resource : threadResources)
+            {
+                RHICheck(vkCreateCommandPool(VulkanRHI::Device, &poolCreateInfo, nullptr, &resource.pool));
+            }
+        }
+
+        // Frame slot is acquired, GPU finished with command buffers of this frame
+        for (auto& resource : threadResources)
+        {
+            RHICheck(vkResetCommandPool(VulkanRHI::Device, resource.pool, 0));
+            resource.usedCount = 0;
+        }
+
+        m_frameIndex = frameIndex;
+        m_colorFormats = colorFormats;
+        m_renderingInfo.colorAttachmentCount = static_cast<uint32_t>(m_colorFormats.size());
+        m_renderingInfo.pColorAttachmentFormats = m_colorFormats.data();
+        m_renderingInfo.depthAttachmentFormat = depthFormat;
+        m_renderingInfo.stencilAttachmentFormat = stencilFormat;
+        m_viewport = viewport;
+        m_scissor = scissor;
+    }
+
+    VkCommandBuffer ParallelCommandRecorder::beginCommandBuffer(uint32_t threadIndex)
+    {
+        auto& resource = m_frameResources[m_frameIndex][threadIndex];
+        if (resource.usedCount == resource.commandBuffers.size())
+        {
+            VkCommandBufferAllocateInfo allocateInfo{};
+            allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocateInfo.commandPool = resource.pool;
+            allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocateInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            RHICheck(vkAllocateCommandBuffers(VulkanRHI::Device, &allocateInfo, &commandBuffer));
+            resource.commandBuffers.push_back(commandBuffer);
+        }
+        VkCommandBuffer cmd = resource.commandBuffers[resource.usedCount++];
+
+        VkCommandBufferBeginInfo beginInfo = Initializers::initCommandBufferBeginInfo();
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &m_inheritanceInfo;
+        RHICheck(vkBeginCommandBuffer(cmd, &beginInfo));
+
+        // Dynamic states are not inherited from primary command buffer
+        vkCmdSetViewport(cmd, 0, 1, &m_viewport);
+        vkCmdSetScissor(cmd, 0, 1, &m_scissor);
+
+        return cmd;
+    }
+
+    VkCommandBuffer ParallelCommandRecorder::record(const std::function<void(VkCommandBuffer cmd)> &func)
+    {
+        VkCommandBuffer cmd = beginCommandBuffer(0);
+        func(cmd);
+        RHICheck(vkEndCommandBuffer(cmd));
+        return cmd;
+    }
+
+    void ParallelCommandRecorder::recordParallel(uint32_t itemCount,
+                                                const std::function<void(VkCommandBuffer cmd, uint32_t beginItem, uint32_t endItem)> &func,
+                                                std::vector<VkCommandBuffer> &outCommandBuffers)
+    {
+        const uint32_t chunkCount = std::clamp((itemCount + GMinDrawItemsPerRecordChunk - 1) / GMinDrawItemsPerRecordChunk, 1u, m_threadCount);
+        const uint32_t itemsPerChunk = (itemCount + chunkCount - 1) / chunkCount;
+
+        const size_t firstOutput = outCommandBuffers.size();
+        outCommandBuffers.resize(firstOutput + chunkCount);
+
+        // Chunk index picks the pool, so chunks never share a pool whichever worker runs them
+        auto recordChunk = [&] (uint32_t chunkIndex)
+        {
+            VT_PROFILE_SCOPE("Record chunk");
+            const uint32_t beginItem = std::min(chunkIndex * itemsPerChunk, itemCount);
+            const uint32_t endItem = std::min(beginItem + itemsPerChunk, itemCount);
+
+            VkCommandBuffer cmd = beginCommandBuffer(chunkIndex);
+            func(cmd, beginItem, endItem);
+            RHICheck(vkEndCommandBuffer(cmd));
+            outCommandBuffers[firstOutput + chunkIndex] = cmd;
+        };
+
+        auto jobSystem = JobSystemHandle::Get();
+        JobCounter counter{};
+        for (uint32_t chunkIndex = 1; chunkIndex < chunkCount; ++chunkIndex)
+        {
+            jobSystem->run(counter, [&recordChunk, chunkIndex]() { recordChunk(chunkIndex); });
+        }
+        recordChunk(0);
+        jobSystem->wait(counter);
+    }
+}
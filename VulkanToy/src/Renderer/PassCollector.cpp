@@ -3,9 +3,11 @@
 //
 
 #include <VulkanToy/Renderer/PassCollector.h>
+#include <VulkanToy/Renderer/ParallelCommandRecorder.h>
 #include <VulkanToy/VulkanRHI/VulkanRHI.h>
 #include <VulkanToy/Scene/Scene.h>
 #include <VulkanToy/AssetSystem/AssetCommon.h>
+#include <VulkanToy/AssetSystem/MeshMisc.h>
 
 namespace VT
 {
@@ -14,7 +16,7 @@ namespace VT
     {
         // TODO: cube map and uniform parameters
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{
-            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0),
+            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 0),
             Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
         };
 
@@ -22,7 +24,7 @@ namespace VT
         RHICheck(vkCreateDescriptorSetLayout(VulkanRHI::Device, &descriptorLayout, nullptr, &skyboxDescriptorSetLayout));
     }
 
-    void SkyboxPass::setupPipeline(VkRenderPass renderPass)
+    void SkyboxPass::setupPipeline(const PassAttachmentFormats &formats)
     {
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = Initializers::initPipelineInputAssemblyState(
                 VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
@@ -59,8 +61,16 @@ namespace VT
         pipelineLayoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
         RHICheck(vkCreatePipelineLayout(VulkanRHI::Device, &pipelineLayoutCreateInfo, nullptr, &skyboxPipelineLayout));
 
-        // Create graphics pipeline
-        VkGraphicsPipelineCreateInfo pipelineCI = Initializers::initPipeline(skyboxPipelineLayout, renderPass);
+        // Create graphics pipeline, rendered into scene color with dynamic rendering
+        VkPipelineRenderingCreateInfo renderingCreateInfo{};
+        renderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        renderingCreateInfo.colorAttachmentCount = 1;
+        renderingCreateInfo.pColorAttachmentFormats = &formats.sceneColorFormat;
+        renderingCreateInfo.depthAttachmentFormat = formats.sceneDepthFormat;
+        renderingCreateInfo.stencilAttachmentFormat = formats.sceneStencilFormat;
+
+        VkGraphicsPipelineCreateInfo pipelineCI = Initializers::initPipeline(skyboxPipelineLayout, VK_NULL_HANDLE);
+        pipelineCI.pNext = &renderingCreateInfo;
         pipelineCI.pInputAssemblyState = &inputAssemblyState;
         pipelineCI.pRasterizationState = &rasterizationState;
         pipelineCI.pColorBlendState = &colorBlendState;
@@ -70,8 +80,6 @@ namespace VT
         pipelineCI.pDynamicState = &dynamicState;
         pipelineCI.pVertexInputState = StaticMeshVertex::getPipelineVertexInputState(
                 { VertexComponent::Position, VertexComponent::Normal, VertexComponent::UV });
-        // TODO: multiple subpass handle
-        pipelineCI.subpass = 0;
 
         std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
         auto shaderModuleVert = VulkanRHI::ShaderManager->getShader("SkyBox.vert.spv");
@@ -81,15 +89,14 @@ namespace VT
         pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
         pipelineCI.pStages = shaderStages.data();
 
-        RHICheck(vkCreateGraphicsPipelines(VulkanRHI::Device, VK_NULL_HANDLE, 1,
-                                            &pipelineCI, nullptr, &skyboxPipeline));
-        VT_CORE_INFO("Create skybox pipeline successfully");
+        skyboxPipeline = VulkanRHI::get()->getPipelineCache().createGraphicsPipeline(pipelineCI, "Skybox");
     }
 
-    void SkyboxPass::init(VkRenderPass renderPass)
+    void SkyboxPass::init(const PassAttachmentFormats &formats)
     {
+        VT_PROFILE_SCOPE("SkyboxPass::init");
         setupDescriptorLayout();
-        setupPipeline(renderPass);
+        setupPipeline(formats);
     }
 
     void SkyboxPass::release()
@@ -116,26 +123,44 @@ namespace VT
         SceneHandle::Get()->onRenderTickSkybox(cmd, skyboxPipelineLayout);
     }
 
+    void SkyboxPass::addToRenderGraph(RenderGraph &graph, PassFrameResources &resources)
+    {
+        VT_PROFILE_SCOPE("SkyboxPass::addToRenderGraph");
+        graph.addPass("Skybox", [&resources] (RenderGraphPassBuilder &builder)
+        {
+            // Skybox covers every pixel, previous scene color is never loaded
+            VkClearValue depthClearValue{};
+            depthClearValue.depthStencil = { 1.0f, 0 };
+            builder.colorAttachment(resources.sceneColor, VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+            builder.depthAttachment(resources.sceneDepth, VK_ATTACHMENT_LOAD_OP_CLEAR, depthClearValue);
+        }, [this] (VkCommandBuffer cmd, const RenderGraph &graph)
+        {
+            onRenderTick(cmd);
+        });
+    }
+
     // ------------------------------------------------ PBR ------------------------------------------------
     void PBRPass::setupDescriptorLayout()
     {
-        // TODO: add other uniforms and samplers
+        // Scene set: camera uniforms, irradiance, prefiltered map and BRDF LUT, built by scene
+        // Material textures come from bindless heap
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{
-            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0),
+            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0),
             Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1),
             Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 2),
-            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 3),
-            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 4),
-            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 5),
-            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 6),
-            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 7)
+            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 3)
         };
 
         VkDescriptorSetLayoutCreateInfo descriptorLayout = Initializers::initDescriptorSetLayoutCreateInfo(setLayoutBindings);
         RHICheck(vkCreateDescriptorSetLayout(VulkanRHI::Device, &descriptorLayout, nullptr, &pbrDescriptorSetLayout));
+
+        std::vector<VkDescriptorSetLayoutBinding> instanceLayoutBindings = InstanceBatcher::getDescriptorSetLayoutBindings();
+
+        VkDescriptorSetLayoutCreateInfo instanceLayout = Initializers::initDescriptorSetLayoutCreateInfo(instanceLayoutBindings);
+        RHICheck(vkCreateDescriptorSetLayout(VulkanRHI::Device, &instanceLayout, nullptr, &pbrInstanceDescriptorSetLayout));
     }
 
-    void PBRPass::setupPipeline(VkRenderPass renderPass)
+    void PBRPass::setupPipeline(const PassAttachmentFormats &formats)
     {
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = Initializers::initPipelineInputAssemblyState(
                 VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
@@ -163,18 +188,27 @@ namespace VT
         VkPipelineDynamicStateCreateInfo dynamicState = Initializers::initPipelineDynamicState(dynamicStateEnables);
 
         // Create pipeline layout
-        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = Initializers::initPipelineLayout(&pbrDescriptorSetLayout, 1);
+        const std::array<VkDescriptorSetLayout, 3> setLayouts{ pbrDescriptorSetLayout, pbrInstanceDescriptorSetLayout,
+                                                                VulkanRHI::get()->getBindlessHeap().getDescriptorSetLayout() };
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = Initializers::initPipelineLayout(setLayouts.data(), static_cast<uint32_t>(setLayouts.size()));
 
         std::vector<VkPushConstantRange> pushConstantRanges{
-                Initializers::initPushConstantRange(VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4), 0),
-                Initializers::initPushConstantRange(VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(int32_t), sizeof(glm::mat4))
+                Initializers::initPushConstantRange(VK_SHADER_STAGE_VERTEX_BIT, sizeof(StaticMeshPushConstants), 0)
         };
         pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantRanges.size();
         pipelineLayoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
         RHICheck(vkCreatePipelineLayout(VulkanRHI::Device, &pipelineLayoutCreateInfo, nullptr, &pbrPipelineLayout));
 
-        // Create pipeline
-        VkGraphicsPipelineCreateInfo pipelineCI = Initializers::initPipeline(pbrPipelineLayout, renderPass);
+        // Create pipeline, rendered into scene color with dynamic rendering
+        VkPipelineRenderingCreateInfo renderingCreateInfo{};
+        renderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        renderingCreateInfo.colorAttachmentCount = 1;
+        renderingCreateInfo.pColorAttachmentFormats = &formats.sceneColorFormat;
+        renderingCreateInfo.depthAttachmentFormat = formats.sceneDepthFormat;
+        renderingCreateInfo.stencilAttachmentFormat = formats.sceneStencilFormat;
+
+        VkGraphicsPipelineCreateInfo pipelineCI = Initializers::initPipeline(pbrPipelineLayout, VK_NULL_HANDLE);
+        pipelineCI.pNext = &renderingCreateInfo;
         pipelineCI.pInputAssemblyState = &inputAssemblyState;
         pipelineCI.pRasterizationState = &rasterizationState;
         pipelineCI.pColorBlendState = &colorBlendState;
@@ -184,8 +218,6 @@ namespace VT
         pipelineCI.pDynamicState = &dynamicState;
         pipelineCI.pVertexInputState = StaticMeshVertex::getPipelineVertexInputState(
                 { VertexComponent::Position, VertexComponent::Normal, VertexComponent::UV, VertexComponent::Tangent, VertexComponent::Bitangent });
-        // TODO: multiple subpass handle
-        pipelineCI.subpass = 0;
 
         std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
         auto shaderModuleVert = VulkanRHI::ShaderManager->getShader("PBRTexture.vert.spv");
@@ -195,15 +227,25 @@ namespace VT
         pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
         pipelineCI.pStages = shaderStages.data();
 
-        RHICheck(vkCreateGraphicsPipelines(VulkanRHI::Device, VK_NULL_HANDLE, 1,
-                                            &pipelineCI, nullptr, &pbrPipeline));
-        VT_CORE_INFO("Create PBR pipeline successfully");
+        pbrPipeline = VulkanRHI::get()->getPipelineCache().createGraphicsPipeline(pipelineCI, "PBR");
+
+        // Compact vertex variant, same shaders with decode enabled by specialization constant
+        const VkBool32 compactVertex = VK_TRUE;
+        VkSpecializationMapEntry specializationEntry{ 0, 0, sizeof(VkBool32) };
+        VkSpecializationInfo specializationInfo{ 1, &specializationEntry, sizeof(VkBool32), &compactVertex };
+        shaderStages[0].pSpecializationInfo = &specializationInfo;
+        pipelineCI.pVertexInputState = StaticMeshCompactVertex::getPipelineVertexInputState(
+                { VertexComponent::Position, VertexComponent::Normal, VertexComponent::UV, VertexComponent::Tangent, VertexComponent::Bitangent });
+
+        pbrCompactPipeline = VulkanRHI::get()->getPipelineCache().createGraphicsPipeline(pipelineCI, "PBRCompact");
     }
 
-    void PBRPass::init(VkRenderPass renderPass)
+    void PBRPass::init(const PassAttachmentFormats &formats)
     {
+        VT_PROFILE_SCOPE("PBRPass::init");
+        pbrAttachmentFormats = formats;
         setupDescriptorLayout();
-        setupPipeline(renderPass);
+        setupPipeline(formats);
     }
 
     void PBRPass::release()
@@ -212,6 +254,10 @@ namespace VT
         {
             vkDestroyDescriptorSetLayout(VulkanRHI::Device, pbrDescriptorSetLayout, nullptr);
         }
+        if (pbrInstanceDescriptorSetLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(VulkanRHI::Device, pbrInstanceDescriptorSetLayout, nullptr);
+        }
         if (pbrPipelineLayout != VK_NULL_HANDLE)
         {
             vkDestroyPipelineLayout(VulkanRHI::Device, pbrPipelineLayout, nullptr);
@@ -220,38 +266,89 @@ namespace VT
         {
             vkDestroyPipeline(VulkanRHI::Device, pbrPipeline, nullptr);
         }
+        if (pbrCompactPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(VulkanRHI::Device, pbrCompactPipeline, nullptr);
+        }
     }
 
     void PBRPass::onRenderTick(VkCommandBuffer cmd)
     {
-        // Draw PBR model
+        onRenderTick(cmd, 0, SceneHandle::Get()->getInstanceBatcher().getDrawItemCount());
+    }
+
+    void PBRPass::onRenderTick(VkCommandBuffer cmd, uint32_t beginItem, uint32_t endItem)
+    {
+        // Draw batches and their GPU culling are recorded by culling pass
+        // Draw PBR model, one pipeline per vertex format sharing scene set and bindless heap
+        SceneHandle::Get()->bindSceneDescriptors(cmd, pbrPipelineLayout);
         vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pbrPipeline);
-        SceneHandle::Get()->onRenderTick(cmd, pbrPipelineLayout);
+        SceneHandle::Get()->onRenderTick(cmd, pbrPipelineLayout, VertexFormat::Standard, beginItem, endItem);
+
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pbrCompactPipeline);
+        SceneHandle::Get()->onRenderTick(cmd, pbrPipelineLayout, VertexFormat::Compact, beginItem, endItem);
+    }
+
+    void PBRPass::addToRenderGraph(RenderGraph &graph, PassFrameResources &resources)
+    {
+        VT_PROFILE_SCOPE("PBRPass::addToRenderGraph");
+        // Culling pass built draw items already, one chunk gains nothing from secondary command buffers
+        const bool isParallel = resources.commandRecorder != nullptr &&
+            SceneHandle::Get()->getInstanceBatcher().getDrawItemCount() > GMinDrawItemsPerRecordChunk;
+        graph.addPass("PBR", [&resources, isParallel] (RenderGraphPassBuilder &builder)
+        {
+            builder.colorAttachment(resources.sceneColor, VK_ATTACHMENT_LOAD_OP_LOAD);
+            builder.depthAttachment(resources.sceneDepth, VK_ATTACHMENT_LOAD_OP_LOAD);
+            if (resources.instanceIndirectBuffer.isValid())
+            {
+                builder.read(resources.instanceIndirectBuffer, RenderGraphAccess::IndirectRead);
+                builder.read(resources.instanceVisibleBuffer, RenderGraphAccess::VertexStorageRead);
+            }
+            if (isParallel)
+            {
+                builder.setSecondaryCommandBuffers();
+            }
+        }, [this, resources, isParallel] (VkCommandBuffer cmd, const RenderGraph &graph)
+        {
+            if (!isParallel)
+            {
+                onRenderTick(cmd);
+                return;
+            }
+
+            // Opaque draw items split across threads, primary only executes them
+            const auto& desc = graph.getImageDesc(resources.sceneColor);
+            VkViewport viewport = Initializers::initViewport((float)desc.width, (float)desc.height, 0.0f, 1.0f);
+            VkRect2D scissor = Initializers::initRect2D((int32_t)desc.width, (int32_t)desc.height, 0, 0);
+            auto& recorder = *resources.commandRecorder;
+            recorder.beginFrame(resources.frameIndex, { pbrAttachmentFormats.sceneColorFormat },
+                                pbrAttachmentFormats.sceneDepthFormat, pbrAttachmentFormats.sceneStencilFormat, viewport, scissor);
+
+            std::vector<VkCommandBuffer> secondaryCommandBuffers{};
+            const uint32_t drawItemCount = SceneHandle::Get()->getInstanceBatcher().getDrawItemCount();
+            recorder.recordParallel(drawItemCount, [this] (VkCommandBuffer secondaryCmd, uint32_t beginItem, uint32_t endItem)
+            {
+                onRenderTick(secondaryCmd, beginItem, endItem);
+            }, secondaryCommandBuffers);
+
+            vkCmdExecuteCommands(cmd, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+        });
     }
 
     // ---------------------------------------------- Tonemap ----------------------------------------------
-    void TonemapPass::setupDescriptor(const std::vector<VkDescriptorImageInfo> &descriptors)
+    void TonemapPass::setupDescriptor()
     {
-        // Generate descriptor set layout for tone mapping
+        // Generate descriptor set layout for tone mapping, scene color is fetched without sampler
         const std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings{
-            { 0, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr }
+            { 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr }
         };
 
         VkDescriptorSetLayoutCreateInfo descriptorLayout = Initializers::initDescriptorSetLayoutCreateInfo(descriptorSetLayoutBindings);
 
         RHICheck(vkCreateDescriptorSetLayout(VulkanRHI::Device, &descriptorLayout, nullptr, &tonemapDescriptorSetLayout));
-
-        // Allocate and update descriptor sets for tone mapping input - pre-frame
-        auto numFrames = VulkanRHI::get()->getSwapChain().imageCount;
-        tonemapDescriptorSets.resize(numFrames);
-        for (uint32_t i = 0; i < numFrames; ++i)
-        {
-            tonemapDescriptorSets[i] = VulkanRHI::get()->getDescriptorPoolCache().allocateSet(tonemapDescriptorSetLayout);
-            VulkanRHI::get()->updateDescriptorSet(tonemapDescriptorSets[i], 0, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, { descriptors[i] });
-        }
     }
 
-    void TonemapPass::setupPipeline(VkRenderPass renderPass)
+    void TonemapPass::setupPipeline(const PassAttachmentFormats &formats)
     {
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = Initializers::initPipelineInputAssemblyState(
                 VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
@@ -283,8 +380,14 @@ namespace VT
         pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
         RHICheck(vkCreatePipelineLayout(VulkanRHI::Device, &pipelineLayoutCreateInfo, nullptr, &tonemapPipelineLayout));
 
-        // Create pipeline
-        VkGraphicsPipelineCreateInfo pipelineCI = Initializers::initPipeline(tonemapPipelineLayout, renderPass);
+        // Create pipeline, rendered into swap chain image with dynamic rendering
+        VkPipelineRenderingCreateInfo renderingCreateInfo{};
+        renderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        renderingCreateInfo.colorAttachmentCount = 1;
+        renderingCreateInfo.pColorAttachmentFormats = &formats.swapChainFormat;
+
+        VkGraphicsPipelineCreateInfo pipelineCI = Initializers::initPipeline(tonemapPipelineLayout, VK_NULL_HANDLE);
+        pipelineCI.pNext = &renderingCreateInfo;
         pipelineCI.pInputAssemblyState = &inputAssemblyState;
         pipelineCI.pRasterizationState = &rasterizationState;
         pipelineCI.pColorBlendState = &colorBlendState;
@@ -293,8 +396,6 @@ namespace VT
         pipelineCI.pDepthStencilState = nullptr;
         pipelineCI.pDynamicState = &dynamicState;
         pipelineCI.pVertexInputState = &vertexInputState;
-        // TODO: multiple subpass handle
-        pipelineCI.subpass = 1;
 
         std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
         auto shaderModuleVert = VulkanRHI::ShaderManager->getShader("Tonemap.vert.spv");
@@ -304,15 +405,14 @@ namespace VT
         pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
         pipelineCI.pStages = shaderStages.data();
 
-        RHICheck(vkCreateGraphicsPipelines(VulkanRHI::Device, VK_NULL_HANDLE, 1,
-                                            &pipelineCI, nullptr, &tonemapPipeline));
-        VT_CORE_INFO("Create Tone-mapping pipeline successfully");
+        tonemapPipeline = VulkanRHI::get()->getPipelineCache().createGraphicsPipeline(pipelineCI, "Tonemap");
     }
 
-    void TonemapPass::init(VkRenderPass renderPass, const std::vector<VkDescriptorImageInfo> &descriptors)
+    void TonemapPass::init(const PassAttachmentFormats &formats)
     {
-        setupDescriptor(descriptors);
-        setupPipeline(renderPass);
+        VT_PROFILE_SCOPE("TonemapPass::init");
+        setupDescriptor();
+        setupPipeline(formats);
     }
 
     void TonemapPass::release()
@@ -331,26 +431,30 @@ namespace VT
         }
     }
 
-    void TonemapPass::updateDescriptorSets(const std::vector<VkDescriptorImageInfo> &descriptors)
+    void TonemapPass::onRenderTick(VkCommandBuffer cmd, uint32_t frameIndex, VkImageView sceneColorView)
     {
-        // Update descriptor sets for tone mapping input - pre-frame
-        auto numFrames = tonemapDescriptorSets.size();
-        for (uint32_t i = 0; i < numFrames; ++i)
-        {
-            VulkanRHI::get()->updateDescriptorSet(tonemapDescriptorSets[i], 0, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, { descriptors[i] });
-        }
-    }
-
-    void TonemapPass::onRenderTick(VkCommandBuffer cmd)
-    {
-        // Transition to tone mapping subpass
-        vkCmdNextSubpass(cmd, VK_SUBPASS_CONTENTS_INLINE);
+        // Transient set of this frame, dropped with the whole pool when frame comes around again
+        VkDescriptorSet descriptorSet = VulkanRHI::get()->getDescriptorPoolCache().allocateTransientSet(tonemapDescriptorSetLayout, frameIndex);
+        const VkDescriptorImageInfo imageInfo{ VK_NULL_HANDLE, sceneColorView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        VulkanRHI::get()->updateDescriptorSet(descriptorSet, 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, { imageInfo });
 
         // Draw a full screen triangle for post-processing/tone mapping
-        auto frameIndex = VulkanRHI::get()->getCurrentFrameIndex();
         vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, tonemapPipeline);
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, tonemapPipelineLayout, 0,
-                                1, &tonemapDescriptorSets[frameIndex], 0,nullptr);
+                                1, &descriptorSet, 0,nullptr);
         vkCmdDraw(cmd, 3, 1, 0, 0);
     }
+
+    void TonemapPass::addToRenderGraph(RenderGraph &graph, PassFrameResources &resources)
+    {
+        VT_PROFILE_SCOPE("TonemapPass::addToRenderGraph");
+        graph.addPass("Tonemap", [&resources] (RenderGraphPassBuilder &builder)
+        {
+            builder.read(resources.sceneColor, RenderGraphAccess::FragmentSampled);
+            builder.colorAttachment(resources.swapChain, VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+        }, [this, resources] (VkCommandBuffer cmd, const RenderGraph &graph)
+        {
+            onRenderTick(cmd, resources.frameIndex, graph.getImageView(resources.sceneColor));
+        });
+    }
 }
\ No newline at end of file
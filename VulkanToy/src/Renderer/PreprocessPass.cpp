@@ -129,10 +129,7 @@ namespace VT
         createInfo.stage = shaderStage;
         createInfo.layout = pipelineLayout;
 
-        VkPipeline computePipeline{};
-        RHICheck(vkCreateComputePipelines(VulkanRHI::Device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &computePipeline));
-
-        return computePipeline;
+        return VulkanRHI::get()->getPipelineCache().createComputePipeline(createInfo, fileName.c_str());
     }
 
     void PreprocessPass::preprocessEnvMap()
@@ -166,7 +163,10 @@ namespace VT
                 vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
                 vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1,
                                         &m_computeDescriptorSet, 0, nullptr);
-                vkCmdDispatch(cmd, kEnvMapSize / 32, kEnvMapSize / 32, 6);
+                {
+                    GPUProfileScope gpuZone{ cmd, "EquirectToCube" };
+                    vkCmdDispatch(cmd, kEnvMapSize / 32, kEnvMapSize / 32, 6);
+                }
 
                 const auto postDispatchBarrier = ImageMemoryBarrier{ envTextureUnfiltered->getImage(), VK_ACCESS_SHADER_WRITE_BIT, 0,
                                                                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL }; //.mipLevels(0, 1);
@@ -257,6 +257,7 @@ namespace VT
 
                     const SpecularFilterPushConstants pushConstants{ level - 1, float(level) * deltaRoughness };
                     vkCmdPushConstants(cmd, m_computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SpecularFilterPushConstants), &pushConstants);
+                    GPUProfileScope gpuZone{ cmd, "SpecularFilter mip " + std::to_string(level) };
                     vkCmdDispatch(cmd, numGroups, numGroups, 6);
                 }
 
@@ -295,7 +296,10 @@ namespace VT
                 vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
                 vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1, &m_computeDescriptorSet,
                                         0, nullptr);
-                vkCmdDispatch(cmd, kIrradianceMapSize / 32, kIrradianceMapSize / 32, 6);
+                {
+                    GPUProfileScope gpuZone{ cmd, "IrradianceCube" };
+                    vkCmdDispatch(cmd, kIrradianceMapSize / 32, kIrradianceMapSize / 32, 6);
+                }
 
                 const auto postDispatchBarrier = ImageMemoryBarrier{ m_irmapTexture->getImage(), VK_ACCESS_SHADER_WRITE_BIT, 0,
                                                                         VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
@@ -324,7 +328,10 @@ namespace VT
                 vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
                 vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipelineLayout, 0, 1, &m_computeDescriptorSet,
                                         0, nullptr);
-                vkCmdDispatch(cmd, kBRDF_LUT_Size / 32, kBRDF_LUT_Size / 32, 6);
+                {
+                    GPUProfileScope gpuZone{ cmd, "SplitSumBRDF" };
+                    vkCmdDispatch(cmd, kBRDF_LUT_Size / 32, kBRDF_LUT_Size / 32, 6);
+                }
 
                 const auto postDispatchBarrier = ImageMemoryBarrier{ m_spBRDF_LUT->getImage(), VK_ACCESS_SHADER_WRITE_BIT, 0,
                                                                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
@@ -342,9 +349,10 @@ namespace VT
         vkDestroyPipelineLayout(VulkanRHI::Device, m_computePipelineLayout, nullptr);
     }
 
-    // Currently render pass is useless
-    void PreprocessPass::init(VkRenderPass renderPass)
+    // One-shot compute work at startup, attachment formats are unused
+    void PreprocessPass::init(const PassAttachmentFormats &formats)
     {
+        VT_PROFILE_SCOPE("PreprocessPass::init");
         preprocessInit();
         preprocessEnvMap();
 
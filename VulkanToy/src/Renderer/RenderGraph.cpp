@@ -0,0 +1,777 @@
+//
+// Created by ZHIKANG on 2023/4/19.
+//
+
+#include <VulkanToy/Renderer/RenderGraph.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+
+namespace VT
+{
+    namespace
+    {
+        constexpr uint32_t GInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+        struct AccessInfo
+        {
+            VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_NONE;
+            VkAccessFlags2 access = VK_ACCESS_2_NONE;
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkImageUsageFlags usage = 0;
+            bool isWrite = false;
+        };
+
+        AccessInfo getAccessInfo(RenderGraphAccess access)
+        {
+            switch (access)
+            {
+                case RenderGraphAccess::ColorAttachment:
+                    return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                            VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true };
+                case RenderGraphAccess::DepthAttachment:
+                    return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true };
+                case RenderGraphAccess::FragmentSampled:
+                    return { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, false };
+                case RenderGraphAccess::ComputeSampled:
+                    return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, false };
+                case RenderGraphAccess::VertexStorageRead:
+                    return { VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, false };
+                case RenderGraphAccess::FragmentStorageRead:
+                    return { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, false };
+                case RenderGraphAccess::ComputeStorageRead:
+                    return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, false };
+                case RenderGraphAccess::ComputeStorageWrite:
+                    return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true };
+                case RenderGraphAccess::IndirectRead:
+                    return { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+                            VK_IMAGE_LAYOUT_UNDEFINED, 0, false };
+                case RenderGraphAccess::TransferRead:
+                    return { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false };
+                case RenderGraphAccess::TransferWrite:
+                    return { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true };
+                case RenderGraphAccess::Present:
+                    return { VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, false };
+            }
+            return {};
+        }
+
+        VkImageAspectFlags getFormatAspect(VkFormat format)
+        {
+            switch (format)
+            {
+                case VK_FORMAT_D16_UNORM:
+                case VK_FORMAT_X8_D24_UNORM_PACK32:
+                case VK_FORMAT_D32_SFLOAT:
+                    return VK_IMAGE_ASPECT_DEPTH_BIT;
+                case VK_FORMAT_D16_UNORM_S8_UINT:
+                case VK_FORMAT_D24_UNORM_S8_UINT:
+                case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+                case VK_FORMAT_S8_UINT:
+                    return VK_IMAGE_ASPECT_STENCIL_BIT;
+                default:
+                    return VK_IMAGE_ASPECT_COLOR_BIT;
+            }
+        }
+
+        VkImageCreateInfo getImageCreateInfo(const RenderGraphImageDesc &desc, VkImageUsageFlags usage)
+        {
+            VkImageCreateInfo createInfo{};
+            createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            createInfo.imageType = VK_IMAGE_TYPE_2D;
+            createInfo.format = desc.format;
+            createInfo.extent = { desc.width, desc.height, 1 };
+            createInfo.mipLevels = 1;
+            createInfo.arrayLayers = 1;
+            createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            createInfo.usage = usage;
+            createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            return createInfo;
+        }
+
+        // Synchronization state of one resource while walking passes in execution order
+        struct ResourceState
+        {
+            VkPipelineStageFlags2 writeStage = VK_PIPELINE_STAGE_2_NONE;
+            VkAccessFlags2 writeAccess = VK_ACCESS_2_NONE;
+            // Reads already synchronized with last write
+            VkPipelineStageFlags2 readStage = VK_PIPELINE_STAGE_2_NONE;
+            VkAccessFlags2 readAccess = VK_ACCESS_2_NONE;
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            bool isTouched = false;
+        };
+
+        // Transition state to new use, return false when no barrier is needed
+        bool transitionState(ResourceState &state, bool isImage, const AccessInfo &info,
+                            VkPipelineStageFlags2 &outSrcStage, VkAccessFlags2 &outSrcAccess)
+        {
+            const bool layoutChange = isImage && state.layout != info.layout;
+            outSrcStage = VK_PIPELINE_STAGE_2_NONE;
+            outSrcAccess = VK_ACCESS_2_NONE;
+
+            if (info.isWrite || layoutChange)
+            {
+                // Wait for last write and every read since, layout transition counts as write
+                outSrcStage = state.writeStage | state.readStage;
+                outSrcAccess = state.writeAccess;
+                const bool needBarrier = layoutChange || outSrcStage != VK_PIPELINE_STAGE_2_NONE;
+
+                state.writeStage = info.stage;
+                state.writeAccess = info.isWrite ? info.access : VK_ACCESS_2_NONE;
+                state.readStage = info.isWrite ? VK_PIPELINE_STAGE_2_NONE : info.stage;
+                state.readAccess = info.isWrite ? VK_ACCESS_2_NONE : info.access;
+                return needBarrier;
+            }
+
+            // Read after read of same stages is already synchronized
+            if ((state.readStage & info.stage) == info.stage && (state.readAccess & info.access) == info.access)
+            {
+                return false;
+            }
+            state.readStage |= info.stage;
+            state.readAccess |= info.access;
+            if (state.writeStage == VK_PIPELINE_STAGE_2_NONE)
+            {
+                return false;
+            }
+            outSrcStage = state.writeStage;
+            outSrcAccess = state.writeAccess;
+            return true;
+        }
+
+        void recordBarriers(VkCommandBuffer cmd, const std::vector<VkImageMemoryBarrier2> &imageBarriers, const VkMemoryBarrier2 &memoryBarrier)
+        {
+            const bool hasMemoryBarrier = memoryBarrier.srcStageMask != VK_PIPELINE_STAGE_2_NONE || memoryBarrier.dstStageMask != VK_PIPELINE_STAGE_2_NONE;
+            if (imageBarriers.empty() && !hasMemoryBarrier)
+            {
+                return;
+            }
+
+            VkDependencyInfo dependencyInfo{};
+            dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+            dependencyInfo.memoryBarrierCount = hasMemoryBarrier ? 1 : 0;
+            dependencyInfo.pMemoryBarriers = &memoryBarrier;
+            dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+            dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+            vkCmdPipelineBarrier2(cmd, &dependencyInfo);
+        }
+    }
+
+    // ---------------------------------------------- Builder ----------------------------------------------
+    void RenderGraphPassBuilder::read(RenderGraphHandle handle, RenderGraphAccess access)
+    {
+        VT_CORE_ASSERT(!getAccessInfo(access).isWrite, "Render graph read declared with write access");
+        m_graph.addUse(m_passIndex, handle, access, false, true);
+    }
+
+    void RenderGraphPassBuilder::write(RenderGraphHandle handle, RenderGraphAccess access)
+    {
+        VT_CORE_ASSERT(getAccessInfo(access).isWrite, "Render graph write declared with read access");
+        m_graph.addUse(m_passIndex, handle, access, true, true);
+    }
+
+    void RenderGraphPassBuilder::colorAttachment(RenderGraphHandle handle, VkAttachmentLoadOp loadOp, VkClearValue clearValue)
+    {
+        m_graph.m_passes[m_passIndex].colorAttachments.push_back({ handle, loadOp, clearValue });
+        m_graph.addUse(m_passIndex, handle, RenderGraphAccess::ColorAttachment, true, loadOp == VK_ATTACHMENT_LOAD_OP_LOAD);
+    }
+
+    void RenderGraphPassBuilder::depthAttachment(RenderGraphHandle handle, VkAttachmentLoadOp loadOp, VkClearValue clearValue)
+    {
+        m_graph.m_passes[m_passIndex].depthAttachment = { handle, loadOp, clearValue };
+        m_graph.addUse(m_passIndex, handle, RenderGraphAccess::DepthAttachment, true, loadOp == VK_ATTACHMENT_LOAD_OP_LOAD);
+    }
+
+    void RenderGraphPassBuilder::setSecondaryCommandBuffers()
+    {
+        m_graph.m_passes[m_passIndex].secondaryCommandBuffers = true;
+    }
+
+    void RenderGraphPassBuilder::setSideEffect()
+    {
+        m_graph.m_passes[m_passIndex].sideEffect = true;
+    }
+
+    // ------------------------------------------- Render graph -------------------------------------------
+    void RenderGraph::FrameTransients::release()
+    {
+        for (auto& transient : images)
+        {
+            vkDestroyImageView(VulkanRHI::Device, transient.view, nullptr);
+            vkDestroyImage(VulkanRHI::Device, transient.image, nullptr);
+        }
+        for (auto& block : blocks)
+        {
+            vmaFreeMemory(VulkanRHI::VMA, block);
+        }
+        images.clear();
+        blocks.clear();
+    }
+
+    void RenderGraph::release()
+    {
+        releaseTransients();
+        m_frameTransients.clear();
+        m_resources.clear();
+        m_passes.clear();
+        m_executionOrder.clear();
+        m_compiled = false;
+    }
+
+    void RenderGraph::releaseTransients()
+    {
+        for (auto& frameTransients : m_frameTransients)
+        {
+            frameTransients.release();
+        }
+    }
+
+    void RenderGraph::reset(uint32_t frameIndex)
+    {
+        m_resources.clear();
+        m_passes.clear();
+        m_executionOrder.clear();
+        m_finalImageBarriers.clear();
+        m_compiled = false;
+
+        m_frameIndex = frameIndex;
+        if (frameIndex >= m_frameTransients.size())
+        {
+            m_frameTransients.resize(frameIndex + 1);
+        }
+    }
+
+    RenderGraphHandle RenderGraph::createImage(const std::string &name, const RenderGraphImageDesc &desc)
+    {
+        Resource resource{};
+        resource.name = name;
+        resource.isImage = true;
+        resource.desc = desc;
+        resource.aspect = getFormatAspect(desc.format);
+        m_resources.push_back(std::move(resource));
+        return { static_cast<uint32_t>(m_resources.size() - 1) };
+    }
+
+    RenderGraphHandle RenderGraph::importImage(const std::string &name, VkImage image, VkImageView view, const RenderGraphImageDesc &desc,
+                                            VkImageLayout initialLayout, VkPipelineStageFlags2 initialStage,
+                                            std::optional<RenderGraphAccess> finalAccess)
+    {
+        Resource resource{};
+        resource.name = name;
+        resource.isImage = true;
+        resource.isImported = true;
+        resource.desc = desc;
+        resource.aspect = getFormatAspect(desc.format);
+        resource.image = image;
+        resource.view = view;
+        resource.initialLayout = initialLayout;
+        resource.initialStage = initialStage;
+        resource.hasFinalAccess = finalAccess.has_value();
+        resource.finalAccess = finalAccess.value_or(RenderGraphAccess::Present);
+        m_resources.push_back(std::move(resource));
+        return { static_cast<uint32_t>(m_resources.size() - 1) };
+    }
+
+    RenderGraphHandle RenderGraph::importBuffer(const std::string &name, VkBuffer buffer)
+    {
+        Resource resource{};
+        resource.name = name;
+        resource.isImported = true;
+        resource.buffer = buffer;
+        m_resources.push_back(std::move(resource));
+        return { static_cast<uint32_t>(m_resources.size() - 1) };
+    }
+
+    void RenderGraph::addPass(const std::string &name, const std::function<void(RenderGraphPassBuilder &builder)> &setup,
+                            RenderGraphExecuteFunc &&execute)
+    {
+        VT_CORE_ASSERT(!m_compiled, "Render graph pass added after compile");
+
+        Pass pass{};
+        pass.name = name;
+        pass.execute = std::move(execute);
+        m_passes.push_back(std::move(pass));
+
+        RenderGraphPassBuilder builder{ *this, static_cast<uint32_t>(m_passes.size() - 1) };
+        setup(builder);
+    }
+
+    void RenderGraph::addUse(uint32_t passIndex, RenderGraphHandle handle, RenderGraphAccess access, bool isWrite, bool preserve)
+    {
+        VT_CORE_ASSERT(handle.isValid() && handle.index < m_resources.size(), "Invalid render graph resource");
+
+        auto& resource = m_resources[handle.index];
+        resource.usage |= getAccessInfo(access).usage;
+        m_passes[passIndex].uses.push_back({ handle.index, access, isWrite, preserve });
+    }
+
+    const RenderGraph::Resource& RenderGraph::getResource(RenderGraphHandle handle) const
+    {
+        VT_CORE_ASSERT(handle.isValid() && handle.index < m_resources.size(), "Invalid render graph resource");
+        return m_resources[handle.index];
+    }
+
+    void RenderGraph::cullPasses()
+    {
+        // Producers of each pass, latest earlier writer of every resource whose contents it needs
+        std::vector<std::vector<uint32_t>> producers(m_passes.size());
+        std::vector<uint32_t> lastWriters(m_resources.size(), GInvalidIndex);
+        for (uint32_t passIndex = 0; passIndex < m_passes.size(); ++passIndex)
+        {
+            const auto& pass = m_passes[passIndex];
+            for (const auto& use : pass.uses)
+            {
+                if ((!use.isWrite || use.preserve) && lastWriters[use.resource] != GInvalidIndex)
+                {
+                    producers[passIndex].push_back(lastWriters[use.resource]);
+                }
+            }
+            for (const auto& use : pass.uses)
+            {
+                if (use.isWrite)
+                {
+                    lastWriters[use.resource] = passIndex;
+                }
+            }
+        }
+
+        // Passes with side effects or writing imported resources are roots, keep everything they depend on
+        std::vector<uint32_t> stack{};
+        for (uint32_t passIndex = 0; passIndex < m_passes.size(); ++passIndex)
+        {
+            auto& pass = m_passes[passIndex];
+            pass.isAlive = pass.sideEffect || std::any_of(pass.uses.begin(), pass.uses.end(), [this] (const ResourceUse &use)
+            {
+                return use.isWrite && m_resources[use.resource].isImported;
+            });
+            if (pass.isAlive)
+            {
+                stack.push_back(passIndex);
+            }
+        }
+        while (!stack.empty())
+        {
+            const uint32_t passIndex = stack.back();
+            stack.pop_back();
+            for (uint32_t producer : producers[passIndex])
+            {
+                if (!m_passes[producer].isAlive)
+                {
+                    m_passes[producer].isAlive = true;
+                    stack.push_back(producer);
+                }
+            }
+        }
+
+        m_culledPassCount = 0;
+        for (uint32_t passIndex = 0; passIndex < m_passes.size(); ++passIndex)
+        {
+            if (m_passes[passIndex].isAlive)
+            {
+                m_executionOrder.push_back(passIndex);
+            } else
+            {
+                ++m_culledPassCount;
+            }
+        }
+    }
+
+    void RenderGraph::computeLifetimes()
+    {
+        for (uint32_t order = 0; order < m_executionOrder.size(); ++order)
+        {
+            for (const auto& use : m_passes[m_executionOrder[order]].uses)
+            {
+                auto& resource = m_resources[use.resource];
+                resource.firstUse = std::min(resource.firstUse, order);
+                resource.lastUse = std::max(resource.lastUse, order);
+            }
+        }
+    }
+
+    void RenderGraph::aliasTransients(std::vector<VkMemoryRequirements> &outBlockRequirements)
+    {
+        // Transient images used by alive passes, in order of first use
+        std::vector<uint32_t> transients{};
+        for (uint32_t resourceIndex = 0; resourceIndex < m_resources.size(); ++resourceIndex)
+        {
+            const auto& resource = m_resources[resourceIndex];
+            if (resource.isImage && !resource.isImported && resource.firstUse != GInvalidIndex)
+            {
+                transients.push_back(resourceIndex);
+            }
+        }
+        std::stable_sort(transients.begin(), transients.end(), [this] (uint32_t a, uint32_t b)
+        {
+            return m_resources[a].firstUse < m_resources[b].firstUse;
+        });
+
+        struct Block
+        {
+            uint32_t lastUse = 0;
+            uint32_t lastResource = GInvalidIndex;
+        };
+        std::vector<Block> blocks{};
+        outBlockRequirements.clear();
+        m_transientMemorySize = 0;
+        m_aliasedMemorySize = 0;
+
+        for (uint32_t resourceIndex : transients)
+        {
+            auto& resource = m_resources[resourceIndex];
+
+            // Requirements without creating image
+            const VkImageCreateInfo createInfo = getImageCreateInfo(resource.desc, resource.usage);
+            VkDeviceImageMemoryRequirements requirementsInfo{};
+            requirementsInfo.sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS;
+            requirementsInfo.pCreateInfo = &createInfo;
+            VkMemoryRequirements2 requirements{};
+            requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+            vkGetDeviceImageMemoryRequirements(VulkanRHI::Device, &requirementsInfo, &requirements);
+            const VkMemoryRequirements& memoryRequirements = requirements.memoryRequirements;
+            m_transientMemorySize += memoryRequirements.size;
+
+            // Reuse block whose images are all dead, prefer smallest one large enough, otherwise grow largest one
+            uint32_t bestBlock = GInvalidIndex;
+            for (uint32_t blockIndex = 0; blockIndex < blocks.size(); ++blockIndex)
+            {
+                const auto& blockRequirements = outBlockRequirements[blockIndex];
+                if (blocks[blockIndex].lastUse >= resource.firstUse ||
+                    (blockRequirements.memoryTypeBits & memoryRequirements.memoryTypeBits) == 0)
+                {
+                    continue;
+                }
+                if (bestBlock == GInvalidIndex)
+                {
+                    bestBlock = blockIndex;
+                    continue;
+                }
+
+                const VkDeviceSize bestSize = outBlockRequirements[bestBlock].size;
+                const bool fits = blockRequirements.size >= memoryRequirements.size;
+                const bool bestFits = bestSize >= memoryRequirements.size;
+                if ((fits && (!bestFits || blockRequirements.size < bestSize)) || (!fits && !bestFits && blockRequirements.size > bestSize))
+                {
+                    bestBlock = blockIndex;
+                }
+            }
+
+            if (bestBlock == GInvalidIndex)
+            {
+                bestBlock = static_cast<uint32_t>(blocks.size());
+                blocks.push_back({});
+                outBlockRequirements.push_back(memoryRequirements);
+            } else
+            {
+                auto& blockRequirements = outBlockRequirements[bestBlock];
+                blockRequirements.size = std::max(blockRequirements.size, memoryRequirements.size);
+                blockRequirements.alignment = std::max(blockRequirements.alignment, memoryRequirements.alignment);
+                blockRequirements.memoryTypeBits &= memoryRequirements.memoryTypeBits;
+            }
+
+            resource.block = bestBlock;
+            resource.aliasPredecessor = blocks[bestBlock].lastResource;
+            blocks[bestBlock].lastUse = resource.lastUse;
+            blocks[bestBlock].lastResource = resourceIndex;
+        }
+
+        for (const auto& blockRequirements : outBlockRequirements)
+        {
+            m_aliasedMemorySize += blockRequirements.size;
+        }
+    }
+
+    void RenderGraph::realizeTransients(const std::vector<VkMemoryRequirements> &blockRequirements)
+    {
+        std::vector<uint32_t> transients{};
+        for (uint32_t resourceIndex = 0; resourceIndex < m_resources.size(); ++resourceIndex)
+        {
+            if (m_resources[resourceIndex].block != GInvalidIndex)
+            {
+                transients.push_back(resourceIndex);
+            }
+        }
+
+        // Frame slot is acquired, GPU finished with transient images of this frame
+        auto& frameTransients = m_frameTransients[m_frameIndex];
+        bool isSameShape = frameTransients.images.size() == transients.size() && frameTransients.blocks.size() == blockRequirements.size();
+        for (uint32_t i = 0; isSameShape && i < transients.size(); ++i)
+        {
+            const auto& resource = m_resources[transients[i]];
+            const auto& transient = frameTransients.images[i];
+            isSameShape = transient.desc == resource.desc && transient.usage == resource.usage && transient.block == resource.block;
+        }
+
+        if (!isSameShape)
+        {
+            frameTransients.release();
+
+            VmaAllocationCreateInfo allocationCreateInfo{};
+            allocationCreateInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            frameTransients.blocks.resize(blockRequirements.size());
+            for (size_t blockIndex = 0; blockIndex < blockRequirements.size(); ++blockIndex)
+            {
+                RHICheck(vmaAllocateMemory(VulkanRHI::VMA, &blockRequirements[blockIndex], &allocationCreateInfo,
+                                        &frameTransients.blocks[blockIndex], nullptr));
+            }
+
+            for (uint32_t resourceIndex : transients)
+            {
+                const auto& resource = m_resources[resourceIndex];
+                TransientImage transient{};
+                transient.desc = resource.desc;
+                transient.usage = resource.usage;
+                transient.block = resource.block;
+
+                const VkImageCreateInfo createInfo = getImageCreateInfo(resource.desc, resource.usage);
+                RHICheck(vkCreateImage(VulkanRHI::Device, &createInfo, nullptr, &transient.image));
+                RHICheck(vmaBindImageMemory(VulkanRHI::VMA, frameTransients.blocks[resource.block], transient.image));
+                VulkanRHI::setResourceName(VK_OBJECT_TYPE_IMAGE, (uint64_t)transient.image, resource.name.c_str());
+
+                // Sampled depth view only sees depth aspect
+                VkImageAspectFlags viewAspect = resource.aspect;
+                if ((resource.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) && (resource.usage & VK_IMAGE_USAGE_SAMPLED_BIT))
+                {
+                    viewAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+                }
+                VkImageViewCreateInfo viewCreateInfo{};
+                viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                viewCreateInfo.image = transient.image;
+                viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewCreateInfo.format = resource.desc.format;
+                viewCreateInfo.subresourceRange = { viewAspect, 0, 1, 0, 1 };
+                RHICheck(vkCreateImageView(VulkanRHI::Device, &viewCreateInfo, nullptr, &transient.view));
+
+                frameTransients.images.push_back(transient);
+            }
+        }
+
+        for (uint32_t i = 0; i < transients.size(); ++i)
+        {
+            auto& resource = m_resources[transients[i]];
+            resource.image = frameTransients.images[i].image;
+            resource.view = frameTransients.images[i].view;
+        }
+    }
+
+    void RenderGraph::planBarriers()
+    {
+        std::vector<ResourceState> states(m_resources.size());
+        for (uint32_t resourceIndex = 0; resourceIndex < m_resources.size(); ++resourceIndex)
+        {
+            const auto& resource = m_resources[resourceIndex];
+            if (resource.isImported)
+            {
+                states[resourceIndex].writeStage = resource.initialStage;
+                states[resourceIndex].layout = resource.initialLayout;
+                states[resourceIndex].isTouched = true;
+            }
+        }
+
+        auto addBarrier = [this, &states] (uint32_t resourceIndex, const AccessInfo &info,
+                                        std::vector<VkImageMemoryBarrier2> &imageBarriers, VkMemoryBarrier2 &memoryBarrier)
+        {
+            const auto& resource = m_resources[resourceIndex];
+            auto& state = states[resourceIndex];
+
+            // First use of aliased image waits for previous image in same memory, contents are discarded
+            if (!state.isTouched)
+            {
+                state.isTouched = true;
+                if (resource.aliasPredecessor != GInvalidIndex)
+                {
+                    const auto& predecessor = states[resource.aliasPredecessor];
+                    state.writeStage = predecessor.writeStage | predecessor.readStage;
+                    state.writeAccess = predecessor.writeAccess;
+                }
+            }
+
+            const VkImageLayout oldLayout = state.layout;
+            VkPipelineStageFlags2 srcStage{};
+            VkAccessFlags2 srcAccess{};
+            if (!transitionState(state, resource.isImage, info, srcStage, srcAccess))
+            {
+                return;
+            }
+            if (resource.isImage)
+            {
+                state.layout = info.layout;
+
+                VkImageMemoryBarrier2 barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+                barrier.srcStageMask = srcStage;
+                barrier.srcAccessMask = srcAccess;
+                barrier.dstStageMask = info.stage;
+                barrier.dstAccessMask = info.access;
+                barrier.oldLayout = oldLayout;
+                barrier.newLayout = info.layout;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = resource.image;
+                barrier.subresourceRange = { resource.aspect, 0, 1, 0, 1 };
+                imageBarriers.push_back(barrier);
+            } else
+            {
+                // Buffers share one global memory barrier per pass
+                memoryBarrier.srcStageMask |= srcStage;
+                memoryBarrier.srcAccessMask |= srcAccess;
+                memoryBarrier.dstStageMask |= info.stage;
+                memoryBarrier.dstAccessMask |= info.access;
+            }
+        };
+
+        for (uint32_t passIndex : m_executionOrder)
+        {
+            auto& pass = m_passes[passIndex];
+            pass.imageBarriers.clear();
+            pass.memoryBarrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+
+            // Merge several uses of one resource inside pass
+            std::vector<std::pair<uint32_t, AccessInfo>> mergedUses{};
+            for (const auto& use : pass.uses)
+            {
+                const AccessInfo info = getAccessInfo(use.access);
+                auto iter = std::find_if(mergedUses.begin(), mergedUses.end(), [&use] (const auto &merged) { return merged.first == use.resource; });
+                if (iter == mergedUses.end())
+                {
+                    mergedUses.emplace_back(use.resource, info);
+                    continue;
+                }
+                VT_CORE_ASSERT(!m_resources[use.resource].isImage || iter->second.layout == info.layout,
+                            "Render graph image used with two layouts in one pass");
+                iter->second.stage |= info.stage;
+                iter->second.access |= info.access;
+                iter->second.isWrite |= info.isWrite;
+            }
+
+            for (const auto& [resourceIndex, info] : mergedUses)
+            {
+                addBarrier(resourceIndex, info, pass.imageBarriers, pass.memoryBarrier);
+            }
+        }
+
+        // Hand imported resources back in their final state, such as swap chain image for present
+        m_finalImageBarriers.clear();
+        m_finalMemoryBarrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+        for (uint32_t resourceIndex = 0; resourceIndex < m_resources.size(); ++resourceIndex)
+        {
+            const auto& resource = m_resources[resourceIndex];
+            if (resource.isImported && resource.hasFinalAccess && resource.firstUse != GInvalidIndex)
+            {
+                addBarrier(resourceIndex, getAccessInfo(resource.finalAccess), m_finalImageBarriers, m_finalMemoryBarrier);
+            }
+        }
+    }
+
+    void RenderGraph::compile()
+    {
+        VT_PROFILE_SCOPE("RenderGraph::compile");
+        VT_CORE_ASSERT(!m_compiled, "Render graph compiled twice");
+
+        cullPasses();
+        computeLifetimes();
+
+        std::vector<VkMemoryRequirements> blockRequirements{};
+        aliasTransients(blockRequirements);
+        realizeTransients(blockRequirements);
+
+        planBarriers();
+        m_compiled = true;
+    }
+
+    void RenderGraph::execute(VkCommandBuffer cmd)
+    {
+        VT_CORE_ASSERT(m_compiled, "Render graph executed before compile");
+
+        for (uint32_t order = 0; order < m_executionOrder.size(); ++order)
+        {
+            const auto& pass = m_passes[m_executionOrder[order]];
+            VT_PROFILE_SCOPE_DYNAMIC(pass.name);
+            VulkanRHI::setPerfMarkerBegin(cmd, pass.name.c_str(), glm::vec4{ 0.5f, 0.8f, 0.5f, 1.0f });
+            const uint32_t gpuZone = VulkanRHI::get()->getGPUProfiler().beginZone(cmd, pass.name);
+
+            recordBarriers(cmd, pass.imageBarriers, pass.memoryBarrier);
+
+            const bool hasDepth = pass.depthAttachment.handle.isValid();
+            const bool isGraphics = !pass.colorAttachments.empty() || hasDepth;
+            if (isGraphics)
+            {
+                // Attachments nothing reads later are not stored
+                auto toRenderingAttachment = [this, order] (const RenderGraphAttachment &attachment, VkImageLayout layout)
+                {
+                    const auto& resource = m_resources[attachment.handle.index];
+                    VkRenderingAttachmentInfo attachmentInfo{};
+                    attachmentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+                    attachmentInfo.imageView = resource.view;
+                    attachmentInfo.imageLayout = layout;
+                    attachmentInfo.loadOp = attachment.loadOp;
+                    attachmentInfo.storeOp = (!resource.isImported && resource.lastUse == order) ?
+                            VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+                    attachmentInfo.clearValue = attachment.clearValue;
+                    return attachmentInfo;
+                };
+
+                std::vector<VkRenderingAttachmentInfo> colorAttachments{};
+                colorAttachments.reserve(pass.colorAttachments.size());
+                for (const auto& attachment : pass.colorAttachments)
+                {
+                    colorAttachments.push_back(toRenderingAttachment(attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+                }
+                VkRenderingAttachmentInfo depthAttachment{};
+                VkRenderingAttachmentInfo stencilAttachment{};
+                if (hasDepth)
+                {
+                    depthAttachment = toRenderingAttachment(pass.depthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+                    if (m_resources[pass.depthAttachment.handle.index].aspect & VK_IMAGE_ASPECT_STENCIL_BIT)
+                    {
+                        stencilAttachment = depthAttachment;
+                    }
+                }
+
+                const auto& areaDesc = m_resources[hasDepth ? pass.depthAttachment.handle.index : pass.colorAttachments[0].handle.index].desc;
+                VkRenderingInfo renderingInfo{};
+                renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+                renderingInfo.flags = pass.secondaryCommandBuffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+                renderingInfo.renderArea = { { 0, 0 }, { areaDesc.width, areaDesc.height } };
+                renderingInfo.layerCount = 1;
+                renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+                renderingInfo.pColorAttachments = colorAttachments.data();
+                renderingInfo.pDepthAttachment = hasDepth ? &depthAttachment : nullptr;
+                renderingInfo.pStencilAttachment = stencilAttachment.sType != 0 ? &stencilAttachment : nullptr;
+                vkCmdBeginRendering(cmd, &renderingInfo);
+
+                // Secondary command buffers set their own dynamic states
+                if (!pass.secondaryCommandBuffers)
+                {
+                    VkViewport viewport = Initializers::initViewport((float)areaDesc.width, (float)areaDesc.height, 0.0f, 1.0f);
+                    VkRect2D scissor = Initializers::initRect2D((int32_t)areaDesc.width, (int32_t)areaDesc.height, 0, 0);
+                    vkCmdSetViewport(cmd, 0, 1, &viewport);
+                    vkCmdSetScissor(cmd, 0, 1, &scissor);
+                }
+            }
+
+            pass.execute(cmd, *this);
+
+            if (isGraphics)
+            {
+                vkCmdEndRendering(cmd);
+            }
+            VulkanRHI::get()->getGPUProfiler().endZone(cmd, gpuZone);
+            VulkanRHI::setPerfMarkerEnd(cmd);
+        }
+
+        recordBarriers(cmd, m_finalImageBarriers, m_finalMemoryBarrier);
+    }
+}
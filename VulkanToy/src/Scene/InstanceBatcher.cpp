@@ -0,0 +1,307 @@
+//
+// Created by ZHIKANG on 2023/4/17.
+//
+
+#include <VulkanToy/Scene/InstanceBatcher.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+#include <VulkanToy/Core/JobSystem.h>
+
+namespace VT
+{
+    static constexpr VkShaderStageFlags GInstanceStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
+    void InstanceBatcher::FrameResource::release()
+    {
+        if (instanceBuffer == nullptr)
+        {
+            return;
+        }
+
+        instanceBuffer->unmap();
+        instanceBuffer->release();
+        cullBuffer->unmap();
+        cullBuffer->release();
+        indirectBuffer->unmap();
+        indirectBuffer->release();
+        visibleBuffer->release();
+        VulkanRHI::get()->getDescriptorSetCache().releaseSet(descriptorSet);
+
+        instanceBuffer = nullptr;
+        cullBuffer = nullptr;
+        indirectBuffer = nullptr;
+        visibleBuffer = nullptr;
+        descriptorSet = VK_NULL_HANDLE;
+        writtenItems.clear();
+        writtenStamps.clear();
+    }
+
+    std::vector<VkDescriptorSetLayoutBinding> InstanceBatcher::getDescriptorSetLayoutBindings()
+    {
+        return {
+            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GInstanceStages, 0),
+            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GInstanceStages, 1),
+            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GInstanceStages, 2),
+            Initializers::initDescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GInstanceStages, 3)
+        };
+    }
+
+    void InstanceBatcher::reserve(FrameResource &frameResource, uint32_t instanceCount, uint32_t batchCount)
+    {
+        if (frameResource.instanceBuffer != nullptr &&
+            instanceCount <= frameResource.instanceCapacity && batchCount <= frameResource.batchCapacity)
+        {
+            return;
+        }
+
+        // Image of this frame is acquired, GPU finished with old buffers
+        frameResource.release();
+
+        uint32_t instanceCapacity = std::max(frameResource.instanceCapacity, GMinInstanceCapacity);
+        while (instanceCapacity < instanceCount)
+        {
+            instanceCapacity *= 2;
+        }
+        uint32_t batchCapacity = std::max(frameResource.batchCapacity, GMinBatchCapacity);
+        while (batchCapacity < batchCount)
+        {
+            batchCapacity *= 2;
+        }
+
+        frameResource.instanceCapacity = instanceCapacity;
+        frameResource.batchCapacity = batchCapacity;
+        frameResource.instanceBuffer = VulkanBuffer::create2(
+                "InstanceBuffer",
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                instanceCapacity * sizeof(StaticMeshInstanceData));
+        frameResource.cullBuffer = VulkanBuffer::create2(
+                "InstanceCullBuffer",
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                instanceCapacity * sizeof(StaticMeshCullData));
+        frameResource.indirectBuffer = VulkanBuffer::create2(
+                "InstanceIndirectBuffer",
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                batchCapacity * sizeof(VkDrawIndexedIndirectCommand));
+        frameResource.visibleBuffer = VulkanBuffer::create2(
+                "InstanceVisibleBuffer",
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                0,
+                instanceCapacity * sizeof(uint32_t));
+        // Map persistent
+        RHICheck(frameResource.instanceBuffer->map());
+        RHICheck(frameResource.cullBuffer->map());
+        RHICheck(frameResource.indirectBuffer->map());
+
+        bool result = VulkanRHI::get()->descriptorFactoryBegin()
+            .bindBuffers(0, 1, &frameResource.instanceBuffer->getDescriptorBufferInfo(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GInstanceStages)
+            .bindBuffers(1, 1, &frameResource.cullBuffer->getDescriptorBufferInfo(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GInstanceStages)
+            .bindBuffers(2, 1, &frameResource.indirectBuffer->getDescriptorBufferInfo(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GInstanceStages)
+            .bindBuffers(3, 1, &frameResource.visibleBuffer->getDescriptorBufferInfo(), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, GInstanceStages)
+            .build(frameResource.descriptorSet);
+        VT_CORE_ASSERT(result, "Fail to set up instance buffer descriptor set");
+    }
+
+    void InstanceBatcher::release()
+    {
+        for (auto& frameResource : m_frameResources)
+        {
+            frameResource.release();
+        }
+        m_frameResources.clear();
+    }
+
+    void InstanceBatcher::build(const std::vector<Ref<Component>> &components, const std::vector<uint32_t> &visibleComponents,
+                                uint32_t frameIndex)
+    {
+        m_sortItems.clear();
+        m_batches.clear();
+        m_singleComponents.clear();
+
+        const auto componentCount = static_cast<uint32_t>(components.size());
+        m_componentVisible.assign(componentCount, 0);
+        for (uint32_t componentIndex : visibleComponents)
+        {
+            m_componentVisible[componentIndex] = 1;
+        }
+
+        // Hidden components keep their instance, so CPU visibility changes do not regroup the table
+        InstanceBatchKey key{};
+        for (uint32_t componentIndex = 0; componentIndex < componentCount; ++componentIndex)
+        {
+            if (components[componentIndex]->getInstanceBatchKey(key))
+            {
+                m_sortItems.emplace_back(key, componentIndex);
+            } else if (m_componentVisible[componentIndex] != 0)
+            {
+                m_singleComponents.push_back(componentIndex);
+            }
+        }
+
+        // Equal keys become adjacent, component order inside batch is kept stable
+        std::sort(m_sortItems.begin(), m_sortItems.end());
+
+        uint32_t batchCount = 0;
+        for (size_t item = 0; item < m_sortItems.size(); ++item)
+        {
+            if (item == 0 || m_sortItems[item].first != m_sortItems[item - 1].first)
+            {
+                batchCount++;
+            }
+        }
+
+        if (frameIndex >= m_frameResources.size())
+        {
+            m_frameResources.resize(frameIndex + 1);
+        }
+        m_frameIndex = frameIndex;
+        if (m_sortItems.empty())
+        {
+            return;
+        }
+        auto& frameResource = m_frameResources[frameIndex];
+        reserve(frameResource, static_cast<uint32_t>(m_sortItems.size()), batchCount);
+
+        auto *instances = static_cast<StaticMeshInstanceData *>(frameResource.instanceBuffer->getMapped());
+        auto *cullData = static_cast<StaticMeshCullData *>(frameResource.cullBuffer->getMapped());
+        auto *commands = static_cast<VkDrawIndexedIndirectCommand *>(frameResource.indirectBuffer->getMapped());
+
+        // Same items in same order keep every instance slot and batch of this slot's table
+        const bool isLayoutChanged = frameResource.writtenItems != m_sortItems;
+
+        // Batch boundaries depend on previous item, cheap enough to find serially
+        // Instance counts are always reset, GPU culling of this slot's last frame accumulated into them
+        const auto instanceCount = static_cast<uint32_t>(m_sortItems.size());
+        m_instanceBatchIndices.resize(instanceCount);
+        for (uint32_t instance = 0; instance < instanceCount; ++instance)
+        {
+            const auto& [itemKey, componentIndex] = m_sortItems[instance];
+            if (instance == 0 || itemKey != m_sortItems[instance - 1].first)
+            {
+                if (isLayoutChanged)
+                {
+                    VkDrawIndexedIndirectCommand command{};
+                    components[componentIndex]->getInstanceDrawCommand(command);
+                    command.firstInstance = instance;
+                    commands[m_batches.size()] = command;
+                }
+                commands[m_batches.size()].instanceCount = 0;
+
+                m_batches.push_back({ componentIndex, instance, 0, itemKey.vertexFormat });
+            }
+            m_batches.back().instanceCount++;
+            m_instanceBatchIndices[instance] = static_cast<uint32_t>(m_batches.size()) - 1;
+        }
+
+        // Stamp packs component revision with CPU visibility, either change rewrites the instance
+        m_instanceStamps.resize(instanceCount);
+        m_dirtyInstances.clear();
+        for (uint32_t instance = 0; instance < instanceCount; ++instance)
+        {
+            const uint32_t componentIndex = m_sortItems[instance].second;
+            m_instanceStamps[instance] = (static_cast<uint64_t>(components[componentIndex]->getInstanceRevision()) << 1) |
+                                        m_componentVisible[componentIndex];
+            if (isLayoutChanged || m_instanceStamps[instance] != frameResource.writtenStamps[instance])
+            {
+                m_dirtyInstances.push_back(instance);
+            }
+        }
+
+        // Every dirty instance writes its own slots
+        JobSystemHandle::Get()->parallelFor(static_cast<uint32_t>(m_dirtyInstances.size()), GDefaultJobGrainSize,
+                                            [&](uint32_t begin, uint32_t end)
+        {
+            StaticMeshRenderBound bound{};
+            for (uint32_t dirty = begin; dirty < end; ++dirty)
+            {
+                const uint32_t instance = m_dirtyInstances[dirty];
+                const uint32_t componentIndex = m_sortItems[instance].second;
+                const auto& component = components[componentIndex];
+                component->getInstanceData(instances[instance]);
+
+                StaticMeshCullData data{};
+                if (m_componentVisible[componentIndex] == 0)
+                {
+                    data.centerRadius = glm::vec4{ 0.0f, 0.0f, 0.0f, -1.0f };
+                    data.extent = glm::vec3{ 0.0f };
+                } else if (component->getWorldBound(bound))
+                {
+                    data.centerRadius = glm::vec4{ bound.origin, bound.radius };
+                    data.extent = bound.extent;
+                } else
+                {
+                    // Huge but finite, infinity times zero plane component is NaN
+                    constexpr float huge = 1e30f;
+                    data.centerRadius = glm::vec4{ 0.0f, 0.0f, 0.0f, huge };
+                    data.extent = glm::vec3{ huge };
+                }
+                data.batchIndex = m_instanceBatchIndices[instance];
+                cullData[instance] = data;
+            }
+        });
+
+        if (isLayoutChanged)
+        {
+            frameResource.writtenItems = m_sortItems;
+        }
+        frameResource.writtenStamps = m_instanceStamps;
+    }
+
+    void InstanceBatcher::cull(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, const std::array<glm::vec4, 6> &planes) const
+    {
+        if (m_sortItems.empty())
+        {
+            return;
+        }
+
+        GPUCullingPushConstants pushConstants{};
+        pushConstants.planes = planes;
+        pushConstants.instanceCount = getInstanceCount();
+
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1,
+                                &m_frameResources[m_frameIndex].descriptorSet, 0, nullptr);
+        vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GPUCullingPushConstants), &pushConstants);
+        vkCmdDispatch(cmd, (pushConstants.instanceCount + GCullingWorkGroupSize - 1) / GCullingWorkGroupSize, 1, 1);
+    }
+
+    void InstanceBatcher::draw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, VertexFormat vertexFormat,
+                                const std::vector<Ref<Component>> &components, uint32_t beginItem, uint32_t endItem) const
+    {
+        const auto batchCount = static_cast<uint32_t>(m_batches.size());
+        endItem = std::min(endItem, getDrawItemCount());
+
+        const uint32_t endBatch = std::min(endItem, batchCount);
+        if (beginItem < endBatch)
+        {
+            const auto& frameResource = m_frameResources[m_frameIndex];
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, GInstanceDescriptorSetIndex, 1,
+                                    &frameResource.descriptorSet, 0, nullptr);
+
+            // Batches culled away on GPU have zero instance count and draw nothing
+            for (uint32_t batchIndex = beginItem; batchIndex < endBatch; ++batchIndex)
+            {
+                const auto& batch = m_batches[batchIndex];
+                if (batch.vertexFormat == vertexFormat)
+                {
+                    components[batch.componentIndex]->bindInstanceResources(cmd, pipelineLayout);
+                    vkCmdDrawIndexedIndirect(cmd, frameResource.indirectBuffer->getBuffer(),
+                                            batchIndex * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+                }
+            }
+        }
+
+        for (uint32_t item = std::max(beginItem, batchCount); item < endItem; ++item)
+        {
+            auto& component = components[m_singleComponents[item - batchCount]];
+            if (component->getVertexFormat() == vertexFormat)
+            {
+                component->onRenderTick(cmd, pipelineLayout);
+            }
+        }
+    }
+}
@@ -5,29 +5,85 @@
 #include <VulkanToy/Scene/Scene.h>
 #include <VulkanToy/Scene/StaticMeshComponent.h>
 #include <VulkanToy/Renderer/SceneCamera.h>
+#include <VulkanToy/AssetSystem/MaterialManager.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+#include <VulkanToy/Core/JobSystem.h>
 
 namespace VT
 {
-    void Scene::updateUniformBuffer()
+    void Scene::updateCameraParameters()
     {
         m_cameraParas.projection = SceneCameraHandle::Get()->getProjection();
         m_cameraParas.view = SceneCameraHandle::Get()->getViewMatrix();
         m_cameraParas.position = SceneCameraHandle::Get()->getPosition();
+    }
+
+    void Scene::setupSceneDescriptors()
+    {
+        VkDescriptorImageInfo irradianceImageInfo{};
+        irradianceImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        irradianceImageInfo.imageView = StandardPBRMaterial::irradianceTexture->getView();
+        irradianceImageInfo.sampler = VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::Irradiance));
+
+        VkDescriptorImageInfo prefilteredImageInfo{};
+        prefilteredImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        prefilteredImageInfo.imageView = StandardPBRMaterial::prefilteredMapTexture->getView();
+        prefilteredImageInfo.sampler = VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::Prefiltered));
+
+        VkDescriptorImageInfo BRDFLUTImageInfo{};
+        BRDFLUTImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        BRDFLUTImageInfo.imageView = StandardPBRMaterial::BRDFLUT->getView();
+        BRDFLUTImageInfo.sampler = VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::BRDFLUT));
+
+        // Offset into frame allocator is given when binding
+        VkDescriptorBufferInfo cameraBufferInfo = VulkanRHI::get()->getFrameAllocator().getDescriptorBufferInfo(sizeof(CameraParameters));
+
+        bool result = VulkanRHI::get()->descriptorFactoryBegin()
+            .bindBuffers(0, 1, &cameraBufferInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
+            .bindImages(1, 1, &irradianceImageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .bindImages(2, 1, &prefilteredImageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .bindImages(3, 1, &BRDFLUTImageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+            .build(m_sceneDescriptorSet);
+        VT_CORE_ASSERT(result, "Fail to set up scene descriptor set");
+    }
+
+    void Scene::cullComponents()
+    {
+        m_frustum.Update(SceneCameraHandle::Get()->getViewProjection());
 
-        m_uniformBuffer->copyData(&m_cameraParas, sizeof(CameraParameters));
+        const auto componentCount = static_cast<uint32_t>(m_components.size());
+
+        // Every component is a candidate, compute pass culls them
+        if (m_gpuCulling)
+        {
+            m_visibleComponents.resize(componentCount);
+            std::iota(m_visibleComponents.begin(), m_visibleComponents.end(), 0u);
+            return;
+        }
+
+        m_cullingBounds.resize(componentCount);
+        JobSystemHandle::Get()->parallelFor(componentCount, GDefaultJobGrainSize, [this](uint32_t begin, uint32_t end)
+        {
+            StaticMeshRenderBound bound{};
+            for (uint32_t index = begin; index < end; ++index)
+            {
+                if (m_components[index]->getWorldBound(bound))
+                {
+                    m_cullingBounds.set(index, bound.origin, bound.extent, bound.radius);
+                } else
+                {
+                    m_cullingBounds.setAlwaysVisible(index);
+                }
+            }
+        });
+
+        FrustumCuller::cullAll(m_frustum, m_cullingBounds, m_visibleComponents);
     }
 
     void Scene::init()
     {
-        // TODO: initialize uniform buffer of camera parameters
-        m_uniformBuffer = VulkanBuffer::create2(
-                "CameraUniformBuffer",
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT,
-                sizeof(CameraParameters));
-        RHICheck(m_uniformBuffer->map());   // Map persistent
-        updateUniformBuffer();                  // Update uniform buffers
+        updateCameraParameters();
+        setupSceneDescriptors();                // IBL maps are baked by preprocess pass on renderer init
 
         // TODO: Just for test
         Ref<StaticMeshComponent> sample = CreateRef<StaticMeshComponent>(EngineMeshes::GCerberusUUID);
@@ -44,13 +100,12 @@ namespace VT
 
     void Scene::release()
     {
-        // Uniform buffer must unmap
-        m_uniformBuffer->unmap();
-        m_uniformBuffer->release();
-        m_uniformBuffer.reset();
+        VulkanRHI::get()->getDescriptorSetCache().releaseSet(m_sceneDescriptorSet);
 
         m_skybox->release();
 
+        m_instanceBatcher.release();
+
         for (auto& component : m_components)
         {
             component->release();
@@ -64,26 +119,91 @@ namespace VT
 
     void Scene::tick(const RuntimeModuleTickData &tickData)
     {
-        updateUniformBuffer();
+        auto jobSystem = JobSystemHandle::Get();
 
-        m_skybox->tick(tickData);
+        // Camera parameters and skybox are independent, culling needs world bounds of ticked components
+        JobGraph tickGraph{};
+        tickGraph.addNode([this]() { updateCameraParameters(); });
+        tickGraph.addNode([this, &tickData]() { m_skybox->tick(tickData); });
+        auto componentTick = tickGraph.addNode([this, jobSystem, &tickData]()
+        {
+            VT_PROFILE_SCOPE("Component tick");
+            jobSystem->parallelFor(static_cast<uint32_t>(m_components.size()), GComponentTickGrainSize,
+                                    [this, &tickData](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t index = begin; index < end; ++index)
+                {
+                    m_components[index]->tick(tickData);
+                }
+            });
+        });
+        auto culling = tickGraph.addNode([this]()
+        {
+            VT_PROFILE_SCOPE("Component culling");
+            cullComponents();
+        });
+        tickGraph.addDependency(culling, componentTick);
 
-        for (auto& component : m_components)
+        tickGraph.run(*jobSystem);
+    }
+
+    void Scene::prepareFrameUniforms()
+    {
+        // Previous frames may still read their own copies, each frame writes a fresh one
+        FrameAllocation allocation = VulkanRHI::get()->getFrameAllocator().upload(m_cameraParas);
+        m_hasFrameUniforms = allocation.isValid();
+        if (m_hasFrameUniforms)
         {
-            component->tick(tickData);
+            m_cameraUniformOffset = allocation.getDynamicOffset();
+        } else
+        {
+            // Offset of an earlier frame may point into a region host is rewriting
+            VT_CORE_WARN("Fail to allocate camera uniforms, scene draws of this frame are skipped");
         }
     }
 
-    void Scene::onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout)
+    void Scene::prepareDrawBatches(uint32_t frameIndex)
     {
-        for (auto& component : m_components)
+        m_instanceBatcher.build(m_components, m_visibleComponents, frameIndex);
+    }
+
+    void Scene::bindSceneDescriptors(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout) const
+    {
+        if (!m_hasFrameUniforms)
+        {
+            return;
+        }
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, GSceneDescriptorSetIndex, 1,
+                                &m_sceneDescriptorSet, 1, &m_cameraUniformOffset);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, GBindlessDescriptorSetIndex, 1,
+                                &VulkanRHI::get()->getBindlessHeap().getDescriptorSet(), 0, nullptr);
+    }
+
+    void Scene::onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, VertexFormat vertexFormat)
+    {
+        if (!m_hasFrameUniforms)
+        {
+            return;
+        }
+        m_instanceBatcher.draw(cmd, pipelineLayout, vertexFormat, m_components);
+    }
+
+    void Scene::onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, VertexFormat vertexFormat,
+                            uint32_t beginItem, uint32_t endItem)
+    {
+        if (!m_hasFrameUniforms)
         {
-            component->onRenderTick(cmd, pipelineLayout);
+            return;
         }
+        m_instanceBatcher.draw(cmd, pipelineLayout, vertexFormat, m_components, beginItem, endItem);
     }
 
     void Scene::onRenderTickSkybox(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout)
     {
-        m_skybox->onRenderTick(cmd, pipelineLayout);
+        if (!m_hasFrameUniforms)
+        {
+            return;
+        }
+        m_skybox->onRenderTick(cmd, pipelineLayout, m_cameraUniformOffset);
     }
 }
\ No newline at end of file
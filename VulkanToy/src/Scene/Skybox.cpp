@@ -19,7 +19,8 @@ namespace VT
 
             setupDescriptors();
 
-            isMeshReady = true;
+            // Ready when async upload finish, see tick
+            isMeshReady = false;
             isMeshReplace = true;
         } else
         {
@@ -29,12 +30,13 @@ namespace VT
 
     void Skybox::setupDescriptors()
     {
-        auto uniformBuffer = SceneHandle::Get()->getUniformBuffer();
+        // Camera uniforms of scene, offset into frame allocator is given when binding
+        VkDescriptorBufferInfo cameraBufferInfo = VulkanRHI::get()->getFrameAllocator().getDescriptorBufferInfo(sizeof(CameraParameters));
         VkDescriptorImageInfo imageInfo{ VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::Cube)),
                                             SkyboxMaterial::skyboxTexture->getView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
 
         bool result = VulkanRHI::get()->descriptorFactoryBegin()
-            .bindBuffers(0, 1, &uniformBuffer->getDescriptorBufferInfo(), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .bindBuffers(0, 1, &cameraBufferInfo, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT)
             .bindImages(1, 1, &imageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
             .build(descriptorSet);
         VT_CORE_ASSERT(result, "Fail to set up vulkan descriptor set");
@@ -42,31 +44,34 @@ namespace VT
 
     void Skybox::release()
     {
-        // Currently use one descriptor set
-        vkFreeDescriptorSets(VulkanRHI::Device, VulkanRHI::get()->getDescriptorPoolCache().getPool(),
-                                1, &descriptorSet);
+        // Set may be shared with equal builds
+        VulkanRHI::get()->getDescriptorSetCache().releaseSet(descriptorSet);
     }
 
     void Skybox::tick(const RuntimeModuleTickData &tickData)
     {
-        // TODO: add implementation
+        if (!isMeshReady && cacheGPUMeshAsset != nullptr)
+        {
+            isMeshReady = cacheGPUMeshAsset->isAssetReady();
+        }
     }
 
-    void Skybox::onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout)
+    void Skybox::onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t cameraUniformOffset)
     {
         if (isMeshReady)
         {
             vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
-                                    &descriptorSet, 0, nullptr);
+                                    &descriptorSet, 1, &cameraUniformOffset);
 
             glm::mat4 model = glm::mat4{ glm::mat3{ SceneCameraHandle::Get()->getViewMatrix() } };
             vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &model);
 
             const VkDeviceSize offsets[1] = {0};
             vkCmdBindVertexBuffers(cmd, 0, 1, &cacheGPUMeshAsset->getVertexBuffer(), offsets);
-            vkCmdBindIndexBuffer(cmd, cacheGPUMeshAsset->getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            vkCmdBindIndexBuffer(cmd, cacheGPUMeshAsset->getIndexBuffer(), 0, cacheGPUMeshAsset->getIndexType());
 
-            vkCmdDrawIndexed(cmd, cacheGPUMeshAsset->getIndicesCount(), 1, 0, 0, 0);
+            const auto& lod = cacheGPUMeshAsset->getLods().front();
+            vkCmdDrawIndexed(cmd, lod.indexCount, 1, lod.indexStartPosition, 0, 0);
         }
     }
 }
@@ -7,6 +7,7 @@
 #include <VulkanToy/AssetSystem/TextureManager.h>
 #include <VulkanToy/VulkanRHI/VulkanRHI.h>
 #include <VulkanToy/Scene/Scene.h>
+#include <VulkanToy/Renderer/SceneCamera.h>
 
 namespace VT
 {
@@ -18,7 +19,7 @@ namespace VT
 
     void StaticMeshComponent::setMeshUUID(const UUID &in)
     {
-        if (staticMeshUUID.empty())
+        if (staticMeshUUID.isNil())
         {
             staticMeshUUID = in;
             loadAssetByUUID();
@@ -31,67 +32,51 @@ namespace VT
         cacheGPUMeshAsset = MeshManager::Get()->getMesh(staticMeshUUID);
         VT_CORE_INFO("Loading mesh asset successfully");
 
+        cacheTextureAssets = {
+            TextureManager::Get()->getImage(EngineImages::GAlbedoImageUUID),
+            TextureManager::Get()->getImage(EngineImages::GNormalImageUUID),
+            TextureManager::Get()->getImage(EngineImages::GRoughnessImageUUID),
+            TextureManager::Get()->getImage(EngineImages::GMetallicImageUUID)
+        };
+
         cacheMaterialAsset = CreateRef<StandardPBRMaterial>();
-        cacheMaterialAsset->albedoTexture = TextureManager::Get()->getImage(EngineImages::GAlbedoImageUUID)->getVulkanImage();
-        cacheMaterialAsset->normalTexture = TextureManager::Get()->getImage(EngineImages::GNormalImageUUID)->getVulkanImage();
-        cacheMaterialAsset->roughnessTexture = TextureManager::Get()->getImage(EngineImages::GRoughnessImageUUID)->getVulkanImage();
-        cacheMaterialAsset->metallicTexture = TextureManager::Get()->getImage(EngineImages::GMetallicImageUUID)->getVulkanImage();
+        cacheMaterialAsset->albedoTexture = cacheTextureAssets[0]->getVulkanImage();
+        cacheMaterialAsset->normalTexture = cacheTextureAssets[1]->getVulkanImage();
+        cacheMaterialAsset->roughnessTexture = cacheTextureAssets[2]->getVulkanImage();
+        cacheMaterialAsset->metallicTexture = cacheTextureAssets[3]->getVulkanImage();
 
+        // Ready when async upload finish, see tick
         isMeshReplace = true;
-        isMeshReady = true;
-
-        setupDescriptors();
+        isMeshReady = false;
     }
 
-    void StaticMeshComponent::setupDescriptors()
+    void StaticMeshComponent::registerMaterial()
     {
-        auto uniformBuffer = SceneHandle::Get()->getUniformBuffer();
-        VkDescriptorImageInfo albedoImageInfo{};
-        albedoImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        albedoImageInfo.imageView = cacheMaterialAsset->albedoTexture->getView();
-        albedoImageInfo.sampler = VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::Albedo));
-
-        VkDescriptorImageInfo normalImageInfo{};
-        normalImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        normalImageInfo.imageView = cacheMaterialAsset->normalTexture->getView();
-        normalImageInfo.sampler = VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::Normal));
-
-        VkDescriptorImageInfo roughnessImageInfo{};
-        roughnessImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        roughnessImageInfo.imageView = cacheMaterialAsset->roughnessTexture->getView();
-        roughnessImageInfo.sampler = VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::Roughness));
-
-        VkDescriptorImageInfo metallicImageInfo{};
-        metallicImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        metallicImageInfo.imageView = cacheMaterialAsset->metallicTexture->getView();
-        metallicImageInfo.sampler = VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::Metallic));
-
-        VkDescriptorImageInfo irradianceImageInfo{};
-        irradianceImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        irradianceImageInfo.imageView = StandardPBRMaterial::irradianceTexture->getView();
-        irradianceImageInfo.sampler = VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::Irradiance));
-
-        VkDescriptorImageInfo prefilteredImageInfo{};
-        prefilteredImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        prefilteredImageInfo.imageView = StandardPBRMaterial::prefilteredMapTexture->getView();
-        prefilteredImageInfo.sampler = VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::Prefiltered));
-
-        VkDescriptorImageInfo BRDFLUTImageInfo{};
-        BRDFLUTImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        BRDFLUTImageInfo.imageView = StandardPBRMaterial::BRDFLUT->getView();
-        BRDFLUTImageInfo.sampler = VulkanRHI::SamplerManager->getSampler(static_cast<uint8_t>(TextureType::BRDFLUT));
-
-        bool result = VulkanRHI::get()->descriptorFactoryBegin()
-            .bindBuffers(0, 1, &uniformBuffer->getDescriptorBufferInfo(), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
-            .bindImages(1, 1, &albedoImageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-            .bindImages(2, 1, &normalImageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-            .bindImages(3, 1, &roughnessImageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-            .bindImages(4, 1, &metallicImageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-            .bindImages(5, 1, &irradianceImageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-            .bindImages(6, 1, &prefilteredImageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-            .bindImages(7, 1, &BRDFLUTImageInfo, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-            .build(descriptorSet);
-        VT_CORE_ASSERT(result, "Fail to set up vulkan descriptor set");
+        BindlessMaterialData data{};
+        data.baseColorFactor = cacheMaterialAsset->baseColorFactor;
+        data.albedoIndex = cacheTextureAssets[0]->getBindlessIndex();
+        data.normalIndex = cacheTextureAssets[1]->getBindlessIndex();
+        data.roughnessIndex = cacheTextureAssets[2]->getBindlessIndex();
+        data.metallicIndex = cacheTextureAssets[3]->getBindlessIndex();
+        data.metallicFactor = cacheMaterialAsset->metallicFactor;
+        data.roughnessFactor = cacheMaterialAsset->roughnessFactor;
+        data.alphaCutOff = cacheMaterialAsset->alphaCutOff;
+
+        auto &bindlessHeap = VulkanRHI::get()->getBindlessHeap();
+        // Components falling back to default material keep it, update and release leave it untouched
+        if (cacheMaterialAsset->bindlessIndex == GBindlessInvalidIndex)
+        {
+            cacheMaterialAsset->bindlessIndex = bindlessHeap.registerMaterial(data);
+            if (cacheMaterialAsset->bindlessIndex == GBindlessInvalidIndex)
+            {
+                VT_CORE_WARN("Material table is full, mesh {0} is drawn with default material", staticMeshUUID.toString());
+                cacheMaterialAsset->bindlessIndex = GBindlessDefaultMaterialIndex;
+            }
+        } else
+        {
+            bindlessHeap.updateMaterial(cacheMaterialAsset->bindlessIndex, data);
+        }
+        instanceRevision++;
     }
 
     void StaticMeshComponent::tick(const RuntimeModuleTickData &tickData)
@@ -101,43 +86,147 @@ namespace VT
             return;
         } else
         {
+            if (!isMeshReady)
+            {
+                isMeshReady = cacheGPUMeshAsset->isAssetReady() &&
+                    std::all_of(cacheTextureAssets.begin(), cacheTextureAssets.end(),
+                                [](const Ref<GPUImageAsset> &texture) { return texture->isAssetReady(); });
+                if (isMeshReady)
+                {
+                    registerMaterial();
+                }
+            }
+            // Cache ages assets by use, this component holds them without looking them up again
+            cacheGPUMeshAsset->markUsed();
+            for (auto& texture : cacheTextureAssets)
+            {
+                texture->markUsed();
+            }
             updateObjectCollectInfo(tickData);
+            selectLod();
+        }
+    }
+
+    void StaticMeshComponent::selectLod()
+    {
+        lodIndex = 0;
+        if (!isMeshReady)
+        {
+            return;
+        }
+
+        const auto& lods = cacheGPUMeshAsset->getLods();
+        const auto& camera = *SceneCameraHandle::Get();
+        const auto& bound = cacheGPUMeshAsset->getRenderBound();
+        const float maxScale = std::max({ std::abs(scale.x), std::abs(scale.y), std::abs(scale.z) });
+        const glm::vec3 center = translation + bound.origin * scale;
+        const float radius = bound.radius * maxScale;
+
+        // Distance to nearest point of bound sphere, camera inside sphere keeps LOD 0
+        const float distance = glm::length(center - camera.getPosition()) - radius;
+        if (distance <= 0.0f)
+        {
+            return;
+        }
+
+        // Pixels covered by one object space unit at that distance
+        const float pixelsPerUnit = std::abs(camera.getProjection()[1][1]) * camera.getViewportHeight() * 0.5f / distance;
+        if (2.0f * radius * pixelsPerUnit < GMeshLodMinScreenSize)
+        {
+            lodIndex = static_cast<uint32_t>(lods.size()) - 1;
+            return;
+        }
+
+        while (lodIndex + 1 < lods.size() && lods[lodIndex + 1].error * maxScale * pixelsPerUnit <= GMeshLodPixelError)
+        {
+            lodIndex++;
         }
     }
 
     void StaticMeshComponent::updateObjectCollectInfo(const RuntimeModuleTickData &tickData)
     {
+        if (translation != revisionTranslation || scale != revisionScale)
+        {
+            revisionTranslation = translation;
+            revisionScale = scale;
+            instanceRevision++;
+        }
+
         // TODO: update materials
         //
     }
 
-    void StaticMeshComponent::onRenderTick(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout)
+    bool StaticMeshComponent::getInstanceBatchKey(InstanceBatchKey &outKey) const
     {
-        const int32_t id = 0;
-        if (isMeshReady)
+        if (!isMeshReady)
         {
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1,
-                                &descriptorSet, 0, nullptr);
+            return false;
+        }
+
+        // Material travels with instance data, components of different materials share the draw
+        outKey.mesh = reinterpret_cast<uintptr_t>(cacheGPUMeshAsset.get());
+        outKey.lodIndex = lodIndex;
+        outKey.vertexFormat = cacheGPUMeshAsset->getVertexFormat();
+        return true;
+    }
 
-            glm::mat4 model{ 1.0f };
-            model = glm::translate(model, translation);
-            model = glm::scale(model, scale);
+    void StaticMeshComponent::getInstanceData(StaticMeshInstanceData &outData) const
+    {
+        outData.model = glm::translate(glm::mat4{ 1.0f }, translation);
+        outData.model = glm::scale(outData.model, scale);
+        outData.materialIndex = cacheMaterialAsset->bindlessIndex;
+    }
+
+    void StaticMeshComponent::getInstanceDrawCommand(VkDrawIndexedIndirectCommand &outCommand) const
+    {
+        const auto& lod = cacheGPUMeshAsset->getLods()[lodIndex];
+        outCommand.indexCount = lod.indexCount;
+        outCommand.firstIndex = lod.indexStartPosition;
+        outCommand.vertexOffset = 0;
+    }
 
-            vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &model);
-            vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(glm::mat4), sizeof(int32_t), &id);
+    void StaticMeshComponent::bindInstanceResources(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout)
+    {
+        // Scene set and bindless heap are bound once by pass
+        StaticMeshPushConstants pushConstants{};
+        pushConstants.positionOffset = glm::vec4{ cacheGPUMeshAsset->getPositionOffset(), 0.0f };
+        pushConstants.positionScale = glm::vec4{ cacheGPUMeshAsset->getPositionScale(), 0.0f };
 
-            const VkDeviceSize offsets[1] = {0};
-            vkCmdBindVertexBuffers(cmd, 0, 1, &cacheGPUMeshAsset->getVertexBuffer(), offsets);
-            vkCmdBindIndexBuffer(cmd, cacheGPUMeshAsset->getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+        vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(StaticMeshPushConstants), &pushConstants);
 
-            vkCmdDrawIndexed(cmd, cacheGPUMeshAsset->getIndicesCount(), 1, 0, 0, 0);
+        const VkDeviceSize offsets[1] = {0};
+        vkCmdBindVertexBuffers(cmd, 0, 1, &cacheGPUMeshAsset->getVertexBuffer(), offsets);
+        vkCmdBindIndexBuffer(cmd, cacheGPUMeshAsset->getIndexBuffer(), 0, cacheGPUMeshAsset->getIndexType());
+    }
+
+    VertexFormat StaticMeshComponent::getVertexFormat() const
+    {
+        return cacheGPUMeshAsset != nullptr ? cacheGPUMeshAsset->getVertexFormat() : VertexFormat::Standard;
+    }
+
+    bool StaticMeshComponent::getWorldBound(StaticMeshRenderBound &outBound) const
+    {
+        if (cacheGPUMeshAsset == nullptr)
+        {
+            return false;
         }
+
+        // Draw ignores rotation, so does bound
+        const auto& bound = cacheGPUMeshAsset->getRenderBound();
+        const glm::vec3 absScale = glm::abs(scale);
+        outBound.origin = translation + bound.origin * scale;
+        outBound.extent = bound.extent * absScale;
+        outBound.radius = bound.radius * std::max({ absScale.x, absScale.y, absScale.z });
+        return true;
     }
 
     void StaticMeshComponent::release()
     {
-        // Currently use one descriptor set
-        vkFreeDescriptorSets(VulkanRHI::Device, VulkanRHI::get()->getDescriptorPoolCache().getPool(),
-                                1, &descriptorSet);
+        // Textures give back their own slots when released
+        if (cacheMaterialAsset != nullptr)
+        {
+            VulkanRHI::get()->getBindlessHeap().releaseMaterial(cacheMaterialAsset->bindlessIndex);
+            cacheMaterialAsset->bindlessIndex = GBindlessInvalidIndex;
+        }
     }
 }
\ No newline at end of file
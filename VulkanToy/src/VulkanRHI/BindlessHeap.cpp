@@ -0,0 +1,260 @@
+//
+// Created by ZHIKANG on 2023/4/20.
+//
+
+#include <VulkanToy/VulkanRHI/BindlessHeap.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+
+namespace VT
+{
+    uint32_t BindlessHeap::SlotAllocator::allocate(const char *bindingName)
+    {
+        if (!freeSlots.empty())
+        {
+            uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        if (nextSlot >= capacity)
+        {
+            VT_CORE_ERROR("Bindless heap is out of {0} slots, capacity is {1}", bindingName, capacity);
+            return GBindlessInvalidIndex;
+        }
+        return nextSlot++;
+    }
+
+    void BindlessHeap::SlotAllocator::free(uint32_t slot)
+    {
+        VT_CORE_ASSERT(slot < nextSlot, "Free bindless slot that is never allocated");
+        freeSlots.push_back(slot);
+    }
+
+    void BindlessHeap::init(const VkPhysicalDeviceProperties &properties, const VkPhysicalDeviceDescriptorIndexingProperties &indexingProperties)
+    {
+        // Limits are zero when driver does not report descriptor indexing properties
+        auto clampCapacity = [](uint32_t wanted, uint32_t limit)
+        {
+            return limit != 0 ? std::min(wanted, limit) : wanted;
+        };
+        m_sampledImageSlots.capacity = clampCapacity(GBindlessMaxSampledImages, std::min(
+                indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+                indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages));
+        m_storageBufferSlots.capacity = clampCapacity(GBindlessMaxStorageBuffers, std::min(
+                indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers) - 1);    // One for material buffer
+        m_materialSlots.capacity = GBindlessMaxMaterials;
+
+        // Immutable sampler, same as material texture sampler
+        VkSamplerCreateInfo samplerCI = Initializers::initSamplerLinear();
+        samplerCI.compareOp = VK_COMPARE_OP_NEVER;
+        samplerCI.mipLodBias = 0.0f;
+        samplerCI.minLod = 0.0f;
+        samplerCI.maxLod = FLT_MAX;
+        samplerCI.anisotropyEnable = VK_TRUE;
+        samplerCI.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+        samplerCI.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        samplerCI.unnormalizedCoordinates = VK_FALSE;
+        RHICheck(vkCreateSampler(VulkanRHI::Device, &samplerCI, nullptr, &m_sampler));
+
+        // Set layout
+        std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+        bindings[0].binding = GBindlessSampledImageBinding;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        bindings[0].descriptorCount = m_sampledImageSlots.capacity;
+        bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+        bindings[1].binding = GBindlessSamplerBinding;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        bindings[1].descriptorCount = 1;
+        bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+        bindings[1].pImmutableSamplers = &m_sampler;
+        bindings[2].binding = GBindlessStorageBufferBinding;
+        bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[2].descriptorCount = m_storageBufferSlots.capacity;
+        bindings[2].stageFlags = VK_SHADER_STAGE_ALL;
+        bindings[3].binding = GBindlessMaterialBinding;
+        bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[3].descriptorCount = 1;
+        bindings[3].stageFlags = VK_SHADER_STAGE_ALL;
+
+        // Slots may be empty and written while set is bound by frames in flight
+        constexpr VkDescriptorBindingFlags arrayBindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                                                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+        std::array<VkDescriptorBindingFlags, 4> bindingFlags{
+            arrayBindingFlags, 0, arrayBindingFlags, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+        };
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCI{};
+        bindingFlagsCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsCI.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+        bindingFlagsCI.pBindingFlags = bindingFlags.data();
+
+        VkDescriptorSetLayoutCreateInfo layoutCI{};
+        layoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutCI.pNext = &bindingFlagsCI;
+        layoutCI.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        layoutCI.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutCI.pBindings = bindings.data();
+        RHICheck(vkCreateDescriptorSetLayout(VulkanRHI::Device, &layoutCI, nullptr, &m_descriptorSetLayout));
+
+        // Own pool, update-after-bind sets can not come from main pool
+        std::array<VkDescriptorPoolSize, 3> poolSizes{
+            VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, m_sampledImageSlots.capacity },
+            VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLER, 1 },
+            VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_storageBufferSlots.capacity + 1 }
+        };
+        VkDescriptorPoolCreateInfo poolCI{};
+        poolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCI.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        poolCI.maxSets = 1;
+        poolCI.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolCI.pPoolSizes = poolSizes.data();
+        RHICheck(vkCreateDescriptorPool(VulkanRHI::Device, &poolCI, nullptr, &m_descriptorPool));
+
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = m_descriptorPool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &m_descriptorSetLayout;
+        RHICheck(vkAllocateDescriptorSets(VulkanRHI::Device, &allocateInfo, &m_descriptorSet));
+        VulkanRHI::setResourceName(VK_OBJECT_TYPE_DESCRIPTOR_SET, (uint64_t)m_descriptorSet, "BindlessDescriptorSet");
+
+        // Material table, persistent mapped
+        m_materialBuffer = VulkanBuffer::create2(
+                "BindlessMaterialBuffer",
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                sizeof(BindlessMaterialData) * m_materialSlots.capacity);
+        RHICheck(m_materialBuffer->map());
+
+        // Untextured white material, texture slots stay invalid and shader uses constants
+        const uint32_t defaultMaterial = m_materialSlots.allocate("material");
+        VT_CORE_ASSERT(defaultMaterial == GBindlessDefaultMaterialIndex, "Default material must take first material slot");
+        static_cast<BindlessMaterialData *>(m_materialBuffer->getMapped())[defaultMaterial] = BindlessMaterialData{};
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_descriptorSet;
+        write.dstBinding = GBindlessMaterialBinding;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = &m_materialBuffer->getDescriptorBufferInfo();
+        vkUpdateDescriptorSets(VulkanRHI::Device, 1, &write, 0, nullptr);
+
+        VT_CORE_INFO("Bindless heap: {0} sampled images, {1} storage buffers, {2} materials",
+                    m_sampledImageSlots.capacity, m_storageBufferSlots.capacity, m_materialSlots.capacity);
+    }
+
+    void BindlessHeap::release()
+    {
+        if (m_materialBuffer != nullptr)
+        {
+            m_materialBuffer->unmap();
+            m_materialBuffer->release();
+            m_materialBuffer.reset();
+        }
+        vkDestroyDescriptorPool(VulkanRHI::Device, m_descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(VulkanRHI::Device, m_descriptorSetLayout, nullptr);
+        vkDestroySampler(VulkanRHI::Device, m_sampler, nullptr);
+        m_descriptorPool = VK_NULL_HANDLE;
+        m_descriptorSetLayout = VK_NULL_HANDLE;
+        m_descriptorSet = VK_NULL_HANDLE;
+        m_sampler = VK_NULL_HANDLE;
+    }
+
+    uint32_t BindlessHeap::registerSampledImage(VkImageView view)
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        uint32_t index = m_sampledImageSlots.allocate("sampled image");
+        if (index == GBindlessInvalidIndex) return index;
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageView = view;
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_descriptorSet;
+        write.dstBinding = GBindlessSampledImageBinding;
+        write.dstArrayElement = index;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        write.pImageInfo = &imageInfo;
+        vkUpdateDescriptorSets(VulkanRHI::Device, 1, &write, 0, nullptr);
+
+        return index;
+    }
+
+    void BindlessHeap::releaseSampledImage(uint32_t index)
+    {
+        // Descriptor stays until slot is rewritten, partially bound allows shaders to never touch it
+        if (index == GBindlessInvalidIndex || m_descriptorSet == VK_NULL_HANDLE) return;
+        // Frames in flight may still index the slot, it is reused only after they finish
+        VulkanRHI::get()->getDeletionQueue().retire([this, index]()
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_sampledImageSlots.free(index);
+        });
+    }
+
+    uint32_t BindlessHeap::registerStorageBuffer(VkBuffer buffer, VkDeviceSize size)
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        uint32_t index = m_storageBufferSlots.allocate("storage buffer");
+        if (index == GBindlessInvalidIndex) return index;
+
+        VkDescriptorBufferInfo bufferInfo{ buffer, 0, size };
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = m_descriptorSet;
+        write.dstBinding = GBindlessStorageBufferBinding;
+        write.dstArrayElement = index;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = &bufferInfo;
+        vkUpdateDescriptorSets(VulkanRHI::Device, 1, &write, 0, nullptr);
+
+        return index;
+    }
+
+    void BindlessHeap::releaseStorageBuffer(uint32_t index)
+    {
+        if (index == GBindlessInvalidIndex || m_descriptorSet == VK_NULL_HANDLE) return;
+        // Frames in flight may still index the slot, it is reused only after they finish
+        VulkanRHI::get()->getDeletionQueue().retire([this, index]()
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_storageBufferSlots.free(index);
+        });
+    }
+
+    uint32_t BindlessHeap::registerMaterial(const BindlessMaterialData &data)
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        uint32_t index = m_materialSlots.allocate("material");
+        if (index == GBindlessInvalidIndex) return index;
+
+        auto *materials = static_cast<BindlessMaterialData *>(m_materialBuffer->getMapped());
+        materials[index] = data;
+        return index;
+    }
+
+    void BindlessHeap::updateMaterial(uint32_t index, const BindlessMaterialData &data)
+    {
+        // Frames in flight may still read old entry, change takes effect for following frames
+        if (index == GBindlessInvalidIndex || index == GBindlessDefaultMaterialIndex) return;
+        auto *materials = static_cast<BindlessMaterialData *>(m_materialBuffer->getMapped());
+        materials[index] = data;
+    }
+
+    void BindlessHeap::releaseMaterial(uint32_t index)
+    {
+        if (index == GBindlessInvalidIndex || index == GBindlessDefaultMaterialIndex || m_descriptorSet == VK_NULL_HANDLE) return;
+        // Frames in flight may still index the slot, it is reused only after they finish
+        VulkanRHI::get()->getDeletionQueue().retire([this, index]()
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_materialSlots.free(index);
+        });
+    }
+}
@@ -0,0 +1,135 @@
+//
+// Created by ZHIKANG on 2023/4/21.
+//
+
+#include <VulkanToy/VulkanRHI/DeletionQueue.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+
+namespace VT
+{
+    void DeletionQueue::release()
+    {
+        onDeviceIdle();
+        VT_CORE_ASSERT(m_entries.empty() && m_pendingEntries.empty(), "Deletion queue must be empty on release");
+    }
+
+    void DeletionQueue::retire(std::function<void()> &&destroy)
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_pendingEntries.push_back(std::move(destroy));
+    }
+
+    void DeletionQueue::retireBuffer(VkBuffer buffer, VmaAllocation allocation)
+    {
+        if (buffer == VK_NULL_HANDLE) return;
+        retire([buffer, allocation]()
+        {
+            vmaDestroyBuffer(VulkanRHI::VMA, buffer, allocation);
+        });
+    }
+
+    void DeletionQueue::retireBuffer(VkBuffer buffer, VkDeviceMemory memory)
+    {
+        if (buffer == VK_NULL_HANDLE) return;
+        retire([buffer, memory]()
+        {
+            vkDestroyBuffer(VulkanRHI::Device, buffer, nullptr);
+            if (memory != VK_NULL_HANDLE)
+            {
+                vkFreeMemory(VulkanRHI::Device, memory, nullptr);
+            }
+        });
+    }
+
+    void DeletionQueue::retireImage(VkImage image, VmaAllocation allocation)
+    {
+        if (image == VK_NULL_HANDLE) return;
+        retire([image, allocation]()
+        {
+            vmaDestroyImage(VulkanRHI::VMA, image, allocation);
+        });
+    }
+
+    void DeletionQueue::retireImage(VkImage image, VkDeviceMemory memory)
+    {
+        if (image == VK_NULL_HANDLE) return;
+        retire([image, memory]()
+        {
+            vkDestroyImage(VulkanRHI::Device, image, nullptr);
+            if (memory != VK_NULL_HANDLE)
+            {
+                vkFreeMemory(VulkanRHI::Device, memory, nullptr);
+            }
+        });
+    }
+
+    void DeletionQueue::retireImageView(VkImageView imageView)
+    {
+        if (imageView == VK_NULL_HANDLE) return;
+        retire([imageView]()
+        {
+            vkDestroyImageView(VulkanRHI::Device, imageView, nullptr);
+        });
+    }
+
+    void DeletionQueue::onFrameSubmitted(uint64_t timelineValue)
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        for (auto& destroy : m_pendingEntries)
+        {
+            m_entries.push_back(Entry{ timelineValue, std::move(destroy) });
+        }
+        m_pendingEntries.clear();
+    }
+
+    void DeletionQueue::onTimelineReached(uint64_t timelineValue)
+    {
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_completedValue = std::max(m_completedValue, timelineValue);
+        }
+        collect();
+    }
+
+    void DeletionQueue::onDeviceIdle()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            // Not called while a frame records, nothing pending is referenced by a submitted frame
+            for (auto& destroy : m_pendingEntries)
+            {
+                m_entries.push_back(Entry{ m_completedValue, std::move(destroy) });
+            }
+            m_pendingEntries.clear();
+            if (!m_entries.empty())
+            {
+                m_completedValue = std::max(m_completedValue, m_entries.back().timelineValue);
+            }
+        }
+        collect();
+    }
+
+    void DeletionQueue::collect()
+    {
+        std::vector<std::function<void()>> destroys{};
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            while (!m_entries.empty() && m_entries.front().timelineValue <= m_completedValue)
+            {
+                destroys.push_back(std::move(m_entries.front().destroy));
+                m_entries.pop_front();
+            }
+        }
+
+        for (auto& destroy : destroys)
+        {
+            destroy();
+        }
+    }
+
+    size_t DeletionQueue::getPendingCount()
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        return m_entries.size() + m_pendingEntries.size();
+    }
+}
@@ -0,0 +1,73 @@
+//
+// Created by ZHIKANG on 2023/4/20.
+//
+
+#include <VulkanToy/VulkanRHI/FrameLinearAllocator.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+
+namespace VT
+{
+    void FrameLinearAllocator::init(const VkPhysicalDeviceProperties &properties, uint32_t frameCount, VkDeviceSize regionSize)
+    {
+        m_alignment = std::max(properties.limits.minUniformBufferOffsetAlignment, properties.limits.minStorageBufferOffsetAlignment);
+        m_regionSize = (regionSize + m_alignment - 1) / m_alignment * m_alignment;
+        m_regionCount = frameCount;
+
+        m_buffer = VulkanBuffer::create2(
+                "FrameLinearBuffer",
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+                m_regionSize * m_regionCount);
+        RHICheck(m_buffer->map());     // Map persistent
+
+        beginFrame(0);
+    }
+
+    void FrameLinearAllocator::release()
+    {
+        if (m_buffer != nullptr)
+        {
+            m_buffer->unmap();
+            m_buffer->release();
+            m_buffer.reset();
+        }
+    }
+
+    void FrameLinearAllocator::beginFrame(uint32_t frameIndex)
+    {
+        VT_CORE_ASSERT(frameIndex < m_regionCount, "Frame index of frame linear allocator is out of range");
+        if (frameIndex >= m_regionCount)
+        {
+            // Keep appending to current region, rewinding it could overwrite data GPU still reads
+            VT_CORE_ERROR("Frame linear allocator has {0} regions, frame index {1} is out of range", m_regionCount, frameIndex);
+            return;
+        }
+        m_peakUsedSize = std::max(m_peakUsedSize, m_regionOffset.load(std::memory_order_relaxed));
+        m_frameIndex = frameIndex;
+        m_regionOffset.store(0, std::memory_order_relaxed);
+    }
+
+    FrameAllocation FrameLinearAllocator::allocate(VkDeviceSize size)
+    {
+        const VkDeviceSize alignedSize = (size + m_alignment - 1) / m_alignment * m_alignment;
+        const VkDeviceSize regionOffset = m_regionOffset.fetch_add(alignedSize, std::memory_order_relaxed);
+        if (regionOffset + alignedSize > m_regionSize)
+        {
+            VT_CORE_ERROR("Frame linear allocator region of {0} bytes is full", m_regionSize);
+            return {};
+        }
+
+        FrameAllocation allocation{};
+        allocation.buffer = m_buffer->getBuffer();
+        allocation.offset = m_frameIndex * m_regionSize + regionOffset;
+        allocation.size = size;
+        allocation.mapped = static_cast<uint8_t *>(m_buffer->getMapped()) + allocation.offset;
+        return allocation;
+    }
+
+    VkDescriptorBufferInfo FrameLinearAllocator::getDescriptorBufferInfo(VkDeviceSize range) const
+    {
+        return VkDescriptorBufferInfo{ m_buffer->getBuffer(), 0, range };
+    }
+}
@@ -0,0 +1,195 @@
+//
+// Created by ZHIKANG on 2023/4/24.
+//
+
+#include <VulkanToy/VulkanRHI/GPUProfiler.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+
+namespace VT
+{
+    void GPUProfiler::init(const VkPhysicalDeviceProperties &properties, const VkQueueFamilyProperties &queueFamilyProperties, uint32_t frameCount)
+    {
+        if (queueFamilyProperties.timestampValidBits == 0 || properties.limits.timestampPeriod == 0.0f)
+        {
+            VT_CORE_WARN("Graphics queue does not support timestamps, GPU profiler is disabled");
+            return;
+        }
+
+        m_timestampPeriod = properties.limits.timestampPeriod;
+        m_timestampMask = queueFamilyProperties.timestampValidBits >= 64 ? ~0ull : (1ull << queueFamilyProperties.timestampValidBits) - 1;
+        m_frames.resize(frameCount);
+
+        VkQueryPoolCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        createInfo.queryCount = getFirstQuery(frameCount);
+        RHICheck(vkCreateQueryPool(VulkanRHI::Device, &createInfo, nullptr, &m_queryPool));
+        VulkanRHI::setResourceName(VK_OBJECT_TYPE_QUERY_POOL, reinterpret_cast<uint64_t>(m_queryPool), "GPUProfilerQueryPool");
+
+        // Host reset, no command buffer needed before first use
+        vkResetQueryPool(VulkanRHI::Device, m_queryPool, 0, createInfo.queryCount);
+        m_isSupported = true;
+    }
+
+    void GPUProfiler::release()
+    {
+        if (m_queryPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(VulkanRHI::Device, m_queryPool, nullptr);
+            m_queryPool = VK_NULL_HANDLE;
+        }
+        m_isSupported = false;
+        m_frames.clear();
+        m_histories.clear();
+        m_historyIndices.clear();
+    }
+
+    void GPUProfiler::beginFrame(uint32_t frameIndex)
+    {
+        if (!m_isSupported)
+        {
+            return;
+        }
+
+        // Zones recorded before first frame, e.g. preprocess dispatches, are read with slot zero
+        readback(frameIndex);
+        auto& frame = m_frames[frameIndex];
+        if (frame.zoneCount > 0)
+        {
+            vkResetQueryPool(VulkanRHI::Device, m_queryPool, getFirstQuery(frameIndex), frame.zoneCount * 2);
+        }
+        frame.zoneCount = 0;
+        frame.openDepth = 0;
+        m_frameIndex = frameIndex;
+        m_frameNumber++;
+    }
+
+    void GPUProfiler::readback(uint32_t frameIndex)
+    {
+        const auto& frame = m_frames[frameIndex];
+        if (frame.zoneCount == 0)
+        {
+            return;
+        }
+
+        // Timeline of this slot has been waited, results are ready and no wait flag is needed
+        std::array<uint64_t, GMaxGPUProfilerZones * 2> timestamps{};
+        const VkResult result = vkGetQueryPoolResults(VulkanRHI::Device, m_queryPool, getFirstQuery(frameIndex), frame.zoneCount * 2,
+                                                    sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result != VK_SUCCESS)
+        {
+            return;
+        }
+
+        for (uint32_t zoneIndex = 0; zoneIndex < frame.zoneCount; ++zoneIndex)
+        {
+            const auto& zone = frame.zones[zoneIndex];
+            const uint64_t ticks = ((timestamps[zoneIndex * 2 + 1] & m_timestampMask) - (timestamps[zoneIndex * 2] & m_timestampMask)) & m_timestampMask;
+            const float durationMs = static_cast<float>(static_cast<double>(ticks) * m_timestampPeriod / 1e6);
+
+            auto [iterator, isInserted] = m_historyIndices.try_emplace(zone.name, static_cast<uint32_t>(m_histories.size()));
+            if (isInserted)
+            {
+                m_histories.emplace_back().name = zone.name;
+            }
+            auto& history = m_histories[iterator->second];
+            history.depth = zone.depth;
+
+            // Same zone recorded several times in one frame adds up
+            if (history.sampleCount > 0 && history.lastFrame == m_frameNumber)
+            {
+                history.samples[(history.sampleOffset + GGPUProfilerHistorySize - 1) % GGPUProfilerHistorySize] += durationMs;
+                continue;
+            }
+            history.samples[history.sampleOffset] = durationMs;
+            history.sampleOffset = (history.sampleOffset + 1) % GGPUProfilerHistorySize;
+            history.sampleCount = std::min(history.sampleCount + 1, GGPUProfilerHistorySize);
+            history.lastFrame = m_frameNumber;
+            history.lastOrder = zoneIndex;
+        }
+    }
+
+    uint32_t GPUProfiler::beginZone(VkCommandBuffer cmd, std::string_view name)
+    {
+        if (!m_isSupported)
+        {
+            return UINT32_MAX;
+        }
+
+        auto& frame = m_frames[m_frameIndex];
+        if (frame.zoneCount >= GMaxGPUProfilerZones)
+        {
+            return UINT32_MAX;
+        }
+
+        const uint32_t zoneIndex = frame.zoneCount++;
+        frame.zones[zoneIndex].name = name;
+        frame.zones[zoneIndex].depth = frame.openDepth++;
+
+        // All commands stage waits for earlier work, so sibling zones do not overlap
+        vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_queryPool, getFirstQuery(m_frameIndex) + zoneIndex * 2);
+        return zoneIndex;
+    }
+
+    void GPUProfiler::endZone(VkCommandBuffer cmd, uint32_t zoneIndex)
+    {
+        if (zoneIndex == UINT32_MAX)
+        {
+            return;
+        }
+
+        m_frames[m_frameIndex].openDepth--;
+        vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_queryPool, getFirstQuery(m_frameIndex) + zoneIndex * 2 + 1);
+    }
+
+    std::vector<GPUZoneTiming> GPUProfiler::getZoneTimings() const
+    {
+        std::vector<const ZoneHistory *> visible{};
+        for (const auto& history : m_histories)
+        {
+            // Init zones, e.g. preprocess dispatches, stay listed
+            if (history.sampleCount > 0 && (history.lastFrame == 0 || history.lastFrame + GGPUProfilerHistorySize >= m_frameNumber))
+            {
+                visible.push_back(&history);
+            }
+        }
+
+        // One shot zones of earlier frames first, then zones of latest frame in recording order
+        std::sort(visible.begin(), visible.end(), [](const ZoneHistory *a, const ZoneHistory *b)
+        {
+            return a->lastFrame != b->lastFrame ? a->lastFrame < b->lastFrame : a->lastOrder < b->lastOrder;
+        });
+
+        std::vector<GPUZoneTiming> timings{};
+        timings.reserve(visible.size());
+        for (const auto* history : visible)
+        {
+            auto& timing = timings.emplace_back();
+            timing.name = history->name;
+            timing.depth = history->depth;
+            timing.lastMs = history->samples[(history->sampleOffset + GGPUProfilerHistorySize - 1) % GGPUProfilerHistorySize];
+            timing.minMs = std::numeric_limits<float>::max();
+            float sumMs = 0.0f;
+            for (uint32_t sample = 0; sample < history->sampleCount; ++sample)
+            {
+                const float durationMs = history->samples[sample];
+                timing.minMs = std::min(timing.minMs, durationMs);
+                timing.maxMs = std::max(timing.maxMs, durationMs);
+                sumMs += durationMs;
+            }
+            timing.avgMs = sumMs / static_cast<float>(history->sampleCount);
+        }
+        return timings;
+    }
+
+    GPUProfileScope::GPUProfileScope(VkCommandBuffer cmd, std::string_view name)
+    : m_cmd(cmd), m_zoneIndex(VulkanRHI::get()->getGPUProfiler().beginZone(cmd, name))
+    {
+
+    }
+
+    GPUProfileScope::~GPUProfileScope()
+    {
+        VulkanRHI::get()->getGPUProfiler().endZone(m_cmd, m_zoneIndex);
+    }
+}
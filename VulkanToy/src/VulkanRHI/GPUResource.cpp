@@ -59,7 +59,7 @@ namespace VT
             VkMemoryRequirements memRequirements;
             vkGetBufferMemoryRequirements(VulkanRHI::Device, m_buffer, &memRequirements);
 
-            VkMemoryAllocateInfo memAllocateInfo;
+            VkMemoryAllocateInfo memAllocateInfo{};
             memAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
             memAllocateInfo.allocationSize = memRequirements.size;
             memAllocateInfo.memoryTypeIndex = VulkanRHI::get()->findMemoryType(memRequirements.memoryTypeBits, memoryPropertyFlags);
@@ -93,20 +93,26 @@ namespace VT
 
     void VulkanBuffer::release()
     {
+        // Released already
+        if (m_buffer == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        // Frames in flight may still read it, destroyed when they finish
+        auto& deletionQueue = VulkanRHI::get()->getDeletionQueue();
         if (!m_isHeap)
         {
-            vmaDestroyBuffer(VulkanRHI::VMA, m_buffer, m_allocation);
+            deletionQueue.retireBuffer(m_buffer, m_allocation);
+            m_allocation = nullptr;
         } else
         {
-            if (m_buffer != VK_NULL_HANDLE)
-            {
-                vkDestroyBuffer(VulkanRHI::Device, m_buffer, nullptr);
-            }
-            if (m_memory != VK_NULL_HANDLE)
-            {
-                vkFreeMemory(VulkanRHI::Device, m_memory, nullptr);
-            }
+            deletionQueue.retireBuffer(m_buffer, m_memory);
+            m_memory = VK_NULL_HANDLE;
         }
+        m_buffer = VK_NULL_HANDLE;
+        m_mapped = nullptr;
+        VulkanRHI::minusGPUResourceMemoryUsed(m_size);
     }
 
     uint64_t VulkanBuffer::getDeviceAddress()
@@ -316,23 +322,22 @@ namespace VT
     void VulkanImage::release()
     {
         VT_CORE_ASSERT(m_image != VK_NULL_HANDLE, "Image is null handle");
+        // Frames in flight may still sample it, destroyed when they finish
+        auto& deletionQueue = VulkanRHI::get()->getDeletionQueue();
+        deletionQueue.retireImageView(m_imageView);
+        m_imageView = VK_NULL_HANDLE;
+
         if (m_allocation != nullptr)
         {
-            vmaDestroyImage(VulkanRHI::VMA, m_image, m_allocation);
-            m_image = VK_NULL_HANDLE;
+            deletionQueue.retireImage(m_image, m_allocation);
+            m_allocation = nullptr;
         } else
         {
-            vkDestroyImage(VulkanRHI::Device, m_image, nullptr);
-            m_image = VK_NULL_HANDLE;
             VT_CORE_ASSERT(m_memory != VK_NULL_HANDLE, "Image memory is null handle");
-            vkFreeMemory(VulkanRHI::Device, m_memory, nullptr);
+            deletionQueue.retireImage(m_image, m_memory);
             m_memory = VK_NULL_HANDLE;
         }
-
-        if (m_imageView != VK_NULL_HANDLE)
-        {
-            vkDestroyImageView(VulkanRHI::Device, m_imageView, nullptr);
-        }
+        m_image = VK_NULL_HANDLE;
 
         VulkanRHI::minusGPUResourceMemoryUsed(m_size);
         VT_CORE_INFO("Image {0} has been released", m_name);
@@ -510,37 +515,42 @@ namespace VT
         }
 
         VulkanRHI::executeImmediatelyMajorGraphics([this] (VkCommandBuffer cmd) {
-            auto mipWidth = static_cast<int32_t>(m_createInfo.extent.width);
-            auto mipHeight = static_cast<int32_t>(m_createInfo.extent.height);
-            for (uint32_t level = 1; level < m_createInfo.mipLevels; ++level, mipWidth /= 2, mipHeight /= 2)
-            {
-                const auto preBlitBarrier = ImageMemoryBarrier{m_image, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
-                                                                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL }.mipLevels(level, 1);
-                vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr,
-                                        0, nullptr, 1, &preBlitBarrier.barrier);
-
-                VkImageBlit region{};
-                region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, m_createInfo.arrayLayers };
-                region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, m_createInfo.arrayLayers };
-                region.srcOffsets[1] = { mipWidth, mipHeight, 1 };
-                region.dstOffsets[1] = { int32_t(mipWidth / 2), int32_t(mipHeight / 2), 1 };
-                vkCmdBlitImage(cmd, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                1, &region, VK_FILTER_LINEAR);
-
-                const auto postBlitBarrier = ImageMemoryBarrier{m_image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
-                                                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL }.mipLevels(level, 1);
-                vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr,
-                                        0, nullptr, 1, &postBlitBarrier.barrier);
-            }
-            // Transition whole mip chain to shader-read-only-layout
-            const auto finalBarrier = ImageMemoryBarrier{ m_image, VK_ACCESS_TRANSFER_WRITE_BIT, 0,
-                                                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
-            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
-                                    0, nullptr, 1, &finalBarrier.barrier);
+            generateMipmaps(cmd);
         });
     }
 
+    void VulkanImage::generateMipmaps(VkCommandBuffer cmd)
+    {
+        auto mipWidth = static_cast<int32_t>(m_createInfo.extent.width);
+        auto mipHeight = static_cast<int32_t>(m_createInfo.extent.height);
+        for (uint32_t level = 1; level < m_createInfo.mipLevels; ++level, mipWidth /= 2, mipHeight /= 2)
+        {
+            const auto preBlitBarrier = ImageMemoryBarrier{m_image, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL }.mipLevels(level, 1);
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr,
+                                    0, nullptr, 1, &preBlitBarrier.barrier);
+
+            VkImageBlit region{};
+            region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, m_createInfo.arrayLayers };
+            region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, m_createInfo.arrayLayers };
+            region.srcOffsets[1] = { mipWidth, mipHeight, 1 };
+            region.dstOffsets[1] = { int32_t(mipWidth / 2), int32_t(mipHeight / 2), 1 };
+            vkCmdBlitImage(cmd, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                            m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            1, &region, VK_FILTER_LINEAR);
+
+            const auto postBlitBarrier = ImageMemoryBarrier{m_image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL }.mipLevels(level, 1);
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr,
+                                    0, nullptr, 1, &postBlitBarrier.barrier);
+        }
+        // Transition whole mip chain to shader-read-only-layout
+        const auto finalBarrier = ImageMemoryBarrier{ m_image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+                                0, nullptr, 1, &finalBarrier.barrier);
+    }
+
     ImageMemoryBarrier::ImageMemoryBarrier(VkImage image, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
                                             VkImageLayout oldLayout, VkImageLayout newLayout)
     {
@@ -0,0 +1,125 @@
+//
+// Created by ZHIKANG on 2023/4/18.
+//
+
+#include <VulkanToy/VulkanRHI/PipelineCache.h>
+#include <VulkanToy/VulkanRHI/VulkanRHI.h>
+
+namespace VT
+{
+    bool PipelineCache::isCompatible(const std::vector<uint8_t> &data, const VkPhysicalDeviceProperties &properties)
+    {
+        VkPipelineCacheHeaderVersionOne header{};
+        if (data.size() < sizeof(header))
+        {
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        return header.headerSize >= sizeof(header) &&
+            header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            header.vendorID == properties.vendorID &&
+            header.deviceID == properties.deviceID &&
+            std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    void PipelineCache::init(const VkPhysicalDeviceProperties &properties, const std::filesystem::path &path)
+    {
+        m_path = path;
+
+        std::vector<uint8_t> data{};
+        if (std::ifstream file{ m_path, std::ios::binary | std::ios::ate }; file.is_open())
+        {
+            data.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file)
+            {
+                data.clear();
+            }
+        }
+
+        if (!data.empty() && !isCompatible(data, properties))
+        {
+            VT_CORE_WARN("Pipeline cache '{}' belongs to other GPU or driver, discard it", m_path.string());
+            data.clear();
+        }
+
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = data.size();
+        createInfo.pInitialData = data.empty() ? nullptr : data.data();
+        RHICheck(vkCreatePipelineCache(VulkanRHI::Device, &createInfo, nullptr, &m_pipelineCache));
+
+        VT_CORE_INFO("Pipeline cache initialized with {} bytes from '{}'", data.size(), m_path.string());
+    }
+
+    void PipelineCache::release()
+    {
+        if (m_pipelineCache == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        VT_CORE_INFO("Created {} pipelines in {:.2f} ms", m_pipelineCount, m_totalCreateMilliseconds);
+        save();
+
+        vkDestroyPipelineCache(VulkanRHI::Device, m_pipelineCache, nullptr);
+        m_pipelineCache = VK_NULL_HANDLE;
+    }
+
+    bool PipelineCache::save() const
+    {
+        size_t size = 0;
+        RHICheck(vkGetPipelineCacheData(VulkanRHI::Device, m_pipelineCache, &size, nullptr));
+        std::vector<uint8_t> data(size);
+        RHICheck(vkGetPipelineCacheData(VulkanRHI::Device, m_pipelineCache, &size, data.data()));
+
+        // Write to temporary file first, a crash while saving keeps the old cache
+        std::error_code errorCode{};
+        std::filesystem::create_directories(m_path.parent_path(), errorCode);
+        auto tempPath = m_path;
+        tempPath += ".tmp";
+        {
+            std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+            if (!file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(size)))
+            {
+                VT_CORE_ERROR("Fail to write pipeline cache '{}'", tempPath.string());
+                return false;
+            }
+        }
+        std::filesystem::rename(tempPath, m_path, errorCode);
+        if (errorCode)
+        {
+            VT_CORE_ERROR("Fail to replace pipeline cache '{}': {}", m_path.string(), errorCode.message());
+            return false;
+        }
+        return true;
+    }
+
+    void PipelineCache::recordCreateTime(const char *name, std::chrono::steady_clock::time_point start)
+    {
+        const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_pipelineCount++;
+        m_totalCreateMilliseconds += milliseconds;
+        VT_CORE_INFO("Pipeline '{}' created in {:.2f} ms", name, milliseconds);
+    }
+
+    VkPipeline PipelineCache::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo &createInfo, const char *name)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        RHICheck(vkCreateGraphicsPipelines(VulkanRHI::Device, m_pipelineCache, 1, &createInfo, nullptr, &pipeline));
+        recordCreateTime(name, start);
+        return pipeline;
+    }
+
+    VkPipeline PipelineCache::createComputePipeline(const VkComputePipelineCreateInfo &createInfo, const char *name)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        RHICheck(vkCreateComputePipelines(VulkanRHI::Device, m_pipelineCache, 1, &createInfo, nullptr, &pipeline));
+        recordCreateTime(name, start);
+        return pipeline;
+    }
+}
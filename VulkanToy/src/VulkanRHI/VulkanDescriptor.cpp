@@ -10,106 +10,352 @@ namespace VT
     const char *mainPoolName = "MainPool";
     const char *ImGuiPoolName = "ImGuiPool";
 
+    static constexpr std::array<VkDescriptorPoolSize, 7> GDescriptorPoolSizes{
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, DESCRIPTOR_POOL_SIZE },
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, DESCRIPTOR_POOL_SIZE },
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, DESCRIPTOR_POOL_SIZE },
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, DESCRIPTOR_POOL_SIZE },
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, DESCRIPTOR_POOL_SIZE },
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, DESCRIPTOR_POOL_SIZE },
+        VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLER, DESCRIPTOR_POOL_SIZE }
+    };
+    static constexpr uint32_t GDescriptorPoolMaxSets = static_cast<uint32_t>(GDescriptorPoolSizes.size()) * DESCRIPTOR_POOL_SIZE;
+
     void DescriptorPoolCache::init()
     {
-        createPool(mainPoolName);
-        createPool(ImGuiPoolName);
+        getPool(mainPoolName);
+        getPool(ImGuiPoolName);
     }
 
     void DescriptorPoolCache::release()
     {
-        for (auto& pool : m_pools)
+        for (auto& [name, chain] : m_pools)
         {
-            vkDestroyDescriptorPool(VulkanRHI::Device, pool.second, nullptr);
+            for (auto pool : chain.pools)
+            {
+                vkDestroyDescriptorPool(VulkanRHI::Device, pool, nullptr);
+            }
         }
+        for (auto& chain : m_transientPools)
+        {
+            for (auto pool : chain.pools)
+            {
+                vkDestroyDescriptorPool(VulkanRHI::Device, pool, nullptr);
+            }
+        }
+        m_pools.clear();
+        m_transientPools.clear();
+        m_setOwners.clear();
     }
 
     void DescriptorPoolCache::reset()
     {
-        for (auto& pool : m_pools)
+        for (auto& [name, chain] : m_pools)
         {
-            vkResetDescriptorPool(VulkanRHI::Device, pool.second, 0);
+            for (auto pool : chain.pools)
+            {
+                vkResetDescriptorPool(VulkanRHI::Device, pool, 0);
+            }
+            chain.current = 0;
+            chain.allocatedSets = 0;
         }
-        m_pools.clear();
+        m_setOwners.clear();
     }
 
-    VkDescriptorSet DescriptorPoolCache::allocateSet(VkDescriptorSetLayout layout, const std::string &poolName)
+    VkDescriptorPool DescriptorPoolCache::createPool(VkDescriptorPoolCreateFlags flags)
     {
-        if (!m_pools.contains(poolName))
-        {
-            createPool(poolName);
-        }
+        VkDescriptorPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.flags = flags;
+        poolCreateInfo.maxSets = GDescriptorPoolMaxSets;
+        poolCreateInfo.poolSizeCount = static_cast<uint32_t>(GDescriptorPoolSizes.size());
+        poolCreateInfo.pPoolSizes = GDescriptorPoolSizes.data();
+
+        VkDescriptorPool pool;
+        RHICheck(vkCreateDescriptorPool(VulkanRHI::Device, &poolCreateInfo, nullptr, &pool));
+        return pool;
+    }
 
+    VkDescriptorSet DescriptorPoolCache::allocateFromChain(PoolChain &chain, VkDescriptorSetLayout layout, VkDescriptorPoolCreateFlags flags,
+                                                        const std::string &chainName, VkDescriptorPool &outPool)
+    {
         VkDescriptorSetAllocateInfo allocateInfo{};
         allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
         allocateInfo.pNext = nullptr;
-        allocateInfo.descriptorPool = m_pools[poolName];
-        allocateInfo.descriptorSetCount = 1;    // TODO: more
+        allocateInfo.descriptorSetCount = 1;
         allocateInfo.pSetLayouts = &layout;
 
-        VkDescriptorSet descriptorSet;
-        auto result = vkAllocateDescriptorSets(VulkanRHI::Device, &allocateInfo, &descriptorSet);
-        if (result != VK_SUCCESS)
+        while (true)
         {
-            VT_CORE_CRITICAL("Fail to allocate descriptor set from pool '{0}'", poolName);
+            const bool isNewPool = chain.current == chain.pools.size();
+            if (isNewPool)
+            {
+                chain.pools.push_back(createPool(flags));
+                VT_CORE_INFO("Descriptor pool chain '{0}' grows to {1} pools", chainName, chain.pools.size());
+            }
+            allocateInfo.descriptorPool = chain.pools[chain.current];
+
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+            auto result = vkAllocateDescriptorSets(VulkanRHI::Device, &allocateInfo, &descriptorSet);
+            if (result == VK_SUCCESS)
+            {
+                chain.allocatedSets++;
+                outPool = allocateInfo.descriptorPool;
+                return descriptorSet;
+            }
+
+            // Full or fragmented pool, move on unless even an empty pool can not hold the set
+            if ((result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) && !isNewPool)
+            {
+                chain.current++;
+                continue;
+            }
+
+            VT_CORE_CRITICAL("Fail to allocate descriptor set from pool chain '{0}'", chainName);
+            return VK_NULL_HANDLE;
         }
+    }
 
+    VkDescriptorSet DescriptorPoolCache::allocateSet(VkDescriptorSetLayout layout, const std::string &poolName)
+    {
+        auto& chain = m_pools[poolName];
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = allocateFromChain(chain, layout, VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+                                                        poolName, pool);
+        if (descriptorSet != VK_NULL_HANDLE)
+        {
+            m_setOwners[descriptorSet] = SetOwner{ &chain, pool };
+        }
         return descriptorSet;
     }
 
-    VkDescriptorPool DescriptorPoolCache::getPool(const std::string &poolName)
+    void DescriptorPoolCache::freeSet(VkDescriptorSet descriptorSet)
     {
-        if (m_pools.contains(poolName))
+        auto it = m_setOwners.find(descriptorSet);
+        if (it == m_setOwners.end())
         {
-            return m_pools[poolName];
-        } else
+            VT_CORE_ERROR("Free descriptor set not allocated by descriptor pool cache");
+            return;
+        }
+
+        auto& [chain, pool] = it->second;
+        vkFreeDescriptorSets(VulkanRHI::Device, pool, 1, &descriptorSet);
+        chain->allocatedSets--;
+
+        // Freed space makes this pool worth trying again
+        const auto poolIndex = static_cast<uint32_t>(std::find(chain->pools.begin(), chain->pools.end(), pool) - chain->pools.begin());
+        chain->current = std::min(chain->current, poolIndex);
+
+        m_setOwners.erase(it);
+    }
+
+    VkDescriptorSet DescriptorPoolCache::allocateTransientSet(VkDescriptorSetLayout layout, uint32_t frameIndex)
+    {
+        if (frameIndex >= m_transientPools.size())
         {
-            return createPool(poolName);
+            m_transientPools.resize(frameIndex + 1);
         }
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        return allocateFromChain(m_transientPools[frameIndex], layout, 0, "Transient", pool);
     }
 
-    VkDescriptorPool DescriptorPoolCache::createPool(const std::string &poolName)
+    void DescriptorPoolCache::resetTransientPools(uint32_t frameIndex)
     {
-        std::vector<VkDescriptorPoolSize> poolSizes{
-            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, DESCRIPTOR_POOL_SIZE },
-            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, DESCRIPTOR_POOL_SIZE },
-            { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, DESCRIPTOR_POOL_SIZE },
-            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, DESCRIPTOR_POOL_SIZE },
-            { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, DESCRIPTOR_POOL_SIZE },
-            { VK_DESCRIPTOR_TYPE_SAMPLER, DESCRIPTOR_POOL_SIZE }
-        };
+        if (frameIndex >= m_transientPools.size())
+        {
+            return;
+        }
 
-        VkDescriptorPoolCreateInfo poolCreateInfo{};
-        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;   // Origin 0
-        poolCreateInfo.maxSets = static_cast<uint32_t>(poolSizes.size() * DESCRIPTOR_POOL_SIZE);
-        poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-        poolCreateInfo.pPoolSizes = poolSizes.data();
+        auto& chain = m_transientPools[frameIndex];
+        for (auto pool : chain.pools)
+        {
+            vkResetDescriptorPool(VulkanRHI::Device, pool, 0);
+        }
+        m_transientPeakSets = std::max(m_transientPeakSets, chain.allocatedSets);
+        chain.current = 0;
+        chain.allocatedSets = 0;
+    }
 
-        VkDescriptorPool pool;
-        RHICheck(vkCreateDescriptorPool(VulkanRHI::Device, &poolCreateInfo, nullptr, &pool));
+    VkDescriptorPool DescriptorPoolCache::getPool(const std::string &poolName)
+    {
+        auto& chain = m_pools[poolName];
+        if (chain.pools.empty())
+        {
+            chain.pools.push_back(createPool(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT));
+        }
+        return chain.pools.front();
+    }
 
-        if (auto it = m_pools.find(poolName); it == m_pools.end())
+    DescriptorPoolStats DescriptorPoolCache::getStats() const
+    {
+        DescriptorPoolStats stats{};
+        for (const auto& [name, chain] : m_pools)
         {
-            m_pools[poolName] = pool;
+            stats.poolCount += static_cast<uint32_t>(chain.pools.size());
+            stats.allocatedSets += chain.allocatedSets;
         }
-        return m_pools[poolName];
+        stats.maxSets = stats.poolCount * GDescriptorPoolMaxSets;
+
+        for (const auto& chain : m_transientPools)
+        {
+            stats.transientPoolCount += static_cast<uint32_t>(chain.pools.size());
+            stats.transientAllocatedSets += chain.allocatedSets;
+            stats.transientPeakSets = std::max(stats.transientPeakSets, chain.allocatedSets);
+        }
+        stats.transientMaxSets = stats.transientPoolCount * GDescriptorPoolMaxSets;
+        stats.transientPeakSets = std::max(stats.transientPeakSets, m_transientPeakSets);
+        return stats;
     }
 
-    DescriptorFactory DescriptorFactory::begin(DescriptorPoolCache *poolCache)
+    static void hashCombine(size_t &seed, uint64_t value)
     {
-        DescriptorFactory builder{};
-        builder.m_cache = poolCache;
-        return builder;
+        seed ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
     }
 
-    VkDescriptorSetLayout DescriptorLayoutCache::createDescriptorLayout(VkDescriptorSetLayoutCreateInfo &info)
+    bool DescriptorLayoutCache::LayoutKey::operator==(const LayoutKey &other) const
     {
+        if (flags != other.flags || bindings.size() != other.bindings.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < bindings.size(); ++i)
+        {
+            const auto& a = bindings[i];
+            const auto& b = other.bindings[i];
+            if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount ||
+                a.stageFlags != b.stageFlags || (a.pImmutableSamplers == nullptr) != (b.pImmutableSamplers == nullptr))
+            {
+                return false;
+            }
+        }
+        return immutableSamplers == other.immutableSamplers;
+    }
+
+    size_t DescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey &key) const
+    {
+        size_t seed = key.flags;
+        for (const auto& binding : key.bindings)
+        {
+            hashCombine(seed, binding.binding);
+            hashCombine(seed, binding.descriptorType);
+            hashCombine(seed, binding.descriptorCount);
+            hashCombine(seed, binding.stageFlags);
+            hashCombine(seed, binding.pImmutableSamplers != nullptr);
+        }
+        for (VkSampler sampler : key.immutableSamplers)
+        {
+            hashCombine(seed, reinterpret_cast<uint64_t>(sampler));
+        }
+        return seed;
+    }
+
+    void DescriptorLayoutCache::release()
+    {
+        for (auto& [key, layout] : m_layouts)
+        {
+            vkDestroyDescriptorSetLayout(VulkanRHI::Device, layout, nullptr);
+        }
+        m_layouts.clear();
+    }
+
+    VkDescriptorSetLayout DescriptorLayoutCache::createDescriptorLayout(const VkDescriptorSetLayoutCreateInfo &info)
+    {
+        VT_CORE_ASSERT(info.pNext == nullptr, "Descriptor layout cache can not key create info with pNext chain");
+
+        LayoutKey key{};
+        key.flags = info.flags;
+        key.bindings.assign(info.pBindings, info.pBindings + info.bindingCount);
+        std::sort(key.bindings.begin(), key.bindings.end(),
+                    [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) { return a.binding < b.binding; });
+
+        // Immutable samplers only apply to sampler types, layouts with the same handles are the same
+        for (auto& binding : key.bindings)
+        {
+            if (binding.descriptorType != VK_DESCRIPTOR_TYPE_SAMPLER && binding.descriptorType != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+            {
+                binding.pImmutableSamplers = nullptr;
+            }
+            if (binding.pImmutableSamplers != nullptr)
+            {
+                key.immutableSamplers.insert(key.immutableSamplers.end(), binding.pImmutableSamplers,
+                                            binding.pImmutableSamplers + binding.descriptorCount);
+            }
+        }
+
+        if (auto it = m_layouts.find(key); it != m_layouts.end())
+        {
+            return it->second;
+        }
+
         VkDescriptorSetLayout layout;
-        vkCreateDescriptorSetLayout(VulkanRHI::Device, &info, nullptr, &layout);
+        RHICheck(vkCreateDescriptorSetLayout(VulkanRHI::Device, &info, nullptr, &layout));
+        m_layouts.emplace(std::move(key), layout);
         return layout;
     }
 
+    size_t DescriptorSetCache::KeyHash::operator()(const std::vector<uint64_t> &key) const
+    {
+        size_t seed = key.size();
+        for (uint64_t value : key)
+        {
+            hashCombine(seed, value);
+        }
+        return seed;
+    }
+
+    void DescriptorSetCache::release()
+    {
+        // Sets go away with their pools
+        m_sets.clear();
+        m_keys.clear();
+    }
+
+    VkDescriptorSet DescriptorSetCache::acquire(const std::vector<uint64_t> &key)
+    {
+        if (auto it = m_sets.find(key); it != m_sets.end())
+        {
+            it->second.refCount++;
+            return it->second.descriptorSet;
+        }
+        return VK_NULL_HANDLE;
+    }
+
+    void DescriptorSetCache::insert(const std::vector<uint64_t> &key, VkDescriptorSet descriptorSet)
+    {
+        m_sets[key] = Entry{ descriptorSet, 1 };
+        m_keys[descriptorSet] = key;
+    }
+
+    void DescriptorSetCache::releaseSet(VkDescriptorSet descriptorSet)
+    {
+        auto keyIt = m_keys.find(descriptorSet);
+        if (keyIt == m_keys.end())
+        {
+            return;
+        }
+
+        auto setIt = m_sets.find(keyIt->second);
+        if (--setIt->second.refCount == 0)
+        {
+            // Frames in flight may still bind it, pool slot is given back when they finish
+            VulkanRHI::get()->getDeletionQueue().retire([descriptorSet]()
+            {
+                VulkanRHI::get()->getDescriptorPoolCache().freeSet(descriptorSet);
+            });
+            m_sets.erase(setIt);
+            m_keys.erase(keyIt);
+        }
+    }
+
+    DescriptorFactory DescriptorFactory::begin(DescriptorPoolCache *poolCache, DescriptorLayoutCache *layoutCache, DescriptorSetCache *setCache)
+    {
+        DescriptorFactory builder{};
+        builder.m_cache = poolCache;
+        builder.m_layoutCache = layoutCache;
+        builder.m_setCache = setCache;
+        return builder;
+    }
+
     DescriptorFactory& DescriptorFactory::bindBuffers(uint32_t binding, uint32_t count, VkDescriptorBufferInfo *bufferInfo,
                                                         VkDescriptorType type, VkShaderStageFlags stageFlags)
     {
@@ -166,10 +412,20 @@ namespace VT
         layoutCreateInfo.pBindings = m_bindings.data();
         layoutCreateInfo.bindingCount = static_cast<uint32_t>(m_bindings.size());
 
-        VkDescriptorSetLayout retLayout = DescriptorLayoutCache::createDescriptorLayout(layoutCreateInfo);
+        VkDescriptorSetLayout retLayout = m_layoutCache->createDescriptorLayout(layoutCreateInfo);
+        layout = retLayout;
+
+        // Same layout and resources, reuse existing set
+        std::vector<uint64_t> setKey = buildSetKey(retLayout);
+        if (VkDescriptorSet cachedSet = m_setCache->acquire(setKey); cachedSet != VK_NULL_HANDLE)
+        {
+            descriptorSet = cachedSet;
+            return true;
+        }
+
         VkDescriptorSet retSet = m_cache->allocateSet(retLayout);
+        m_setCache->insert(setKey, retSet);
 
-        // TODO: fix
         std::vector<VkWriteDescriptorSet> writes{};
         writes.reserve(m_descriptorWriteBufInfos.size());
         for (auto& descriptorWrite : m_descriptorWriteBufInfos)
@@ -196,11 +452,36 @@ namespace VT
         vkUpdateDescriptorSets(VulkanRHI::Device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 
         descriptorSet = retSet;
-        layout = retLayout;
 
         return true;
     }
 
+    std::vector<uint64_t> DescriptorFactory::buildSetKey(VkDescriptorSetLayout layout) const
+    {
+        std::vector<uint64_t> key{ reinterpret_cast<uint64_t>(layout) };
+        for (const auto& descriptorWrite : m_descriptorWriteBufInfos)
+        {
+            key.push_back((uint64_t(descriptorWrite.binding) << 32) | uint64_t(descriptorWrite.type));
+            for (uint32_t element = 0; element < descriptorWrite.count; ++element)
+            {
+                if (descriptorWrite.isImage)
+                {
+                    const auto& imageInfo = descriptorWrite.imageInfo[element];
+                    key.push_back(reinterpret_cast<uint64_t>(imageInfo.sampler));
+                    key.push_back(reinterpret_cast<uint64_t>(imageInfo.imageView));
+                    key.push_back(uint64_t(imageInfo.imageLayout));
+                } else
+                {
+                    const auto& bufferInfo = descriptorWrite.bufferInfo[element];
+                    key.push_back(reinterpret_cast<uint64_t>(bufferInfo.buffer));
+                    key.push_back(bufferInfo.offset);
+                    key.push_back(bufferInfo.range);
+                }
+            }
+        }
+        return key;
+    }
+
     bool DescriptorFactory::build(VkDescriptorSet &descriptorSet)
     {
         VkDescriptorSetLayout layout;
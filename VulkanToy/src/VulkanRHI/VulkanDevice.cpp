@@ -114,6 +114,7 @@ namespace VT
         vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
         std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
         vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+        queueFamilyProperties = queueFamilies;
 
         uint32_t graphicsQueueCount = 0;
         uint32_t copyQueueCount = 0;
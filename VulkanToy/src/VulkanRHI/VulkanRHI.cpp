@@ -169,38 +169,30 @@ namespace VT
     {
         VT_CORE_ASSERT(VulkanRHI::MaxSwapChainCount != ~0, "Vulkan RHI GMaxSwpChainCount must be initialized");
 
-        semaphoresImageAvailable.resize(VulkanRHI::MaxSwapChainCount);
         semaphoresRenderFinished.resize(VulkanRHI::MaxSwapChainCount);
 
-        inFlightFences.resize(VulkanRHI::MaxSwapChainCount);
-        imagesInFlight.resize(VulkanRHI::MaxSwapChainCount);
-        for (auto& fence : imagesInFlight)
-        {
-            fence = VK_NULL_HANDLE;
-        }
-
         VkSemaphoreCreateInfo semaphoreCreateInfo{};
         semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        VkFenceCreateInfo fenceCreateInfo{};
-        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-        for (size_t i = 0; i < VulkanRHI::MaxSwapChainCount; ++i)
+        for (auto& semaphore : semaphoresImageAvailable)
+        {
+            RHICheck(vkCreateSemaphore(VulkanRHI::Device, &semaphoreCreateInfo, nullptr, &semaphore));
+        }
+        for (auto& semaphore : semaphoresRenderFinished)
         {
-            RHICheck(vkCreateSemaphore(VulkanRHI::Device, &semaphoreCreateInfo, nullptr, &semaphoresImageAvailable[i]));
-            RHICheck(vkCreateSemaphore(VulkanRHI::Device, &semaphoreCreateInfo, nullptr, &semaphoresRenderFinished[i]));
-            RHICheck(vkCreateFence(VulkanRHI::Device, &fenceCreateInfo, nullptr, &inFlightFences[i]));
+            RHICheck(vkCreateSemaphore(VulkanRHI::Device, &semaphoreCreateInfo, nullptr, &semaphore));
         }
     }
 
     void VulkanContext::PresentContext::release()
     {
-        for (size_t i = 0; i < VulkanRHI::MaxSwapChainCount; ++i)
+        for (auto& semaphore : semaphoresImageAvailable)
         {
-            vkDestroySemaphore(VulkanRHI::Device, semaphoresImageAvailable[i], nullptr);
-            vkDestroySemaphore(VulkanRHI::Device, semaphoresRenderFinished[i], nullptr);
-            vkDestroyFence(VulkanRHI::Device, inFlightFences[i], nullptr);
+            vkDestroySemaphore(VulkanRHI::Device, semaphore, nullptr);
+        }
+        for (auto& semaphore : semaphoresRenderFinished)
+        {
+            vkDestroySemaphore(VulkanRHI::Device, semaphore, nullptr);
         }
     }
 
@@ -360,7 +352,8 @@ namespace VT
 
     void VulkanContext::createDrawCommandBuffers()
     {
-        m_drawCmdBuffers.resize(m_swapChain.imageCount);
+        // One per frame slot, reused once the slot's last frame finish
+        m_drawCmdBuffers.resize(GMaxFramesInFlight);
 
         VkCommandBufferAllocateInfo cmdAllocateInfo{};
         cmdAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -377,6 +370,7 @@ namespace VT
 
         // Initialize instance
         {
+            VT_PROFILE_SCOPE("Vulkan instance");
             std::vector<const char *> instanceExtensionNames;
             instanceExtensionNames.reserve(4);
             instanceExtensionNames.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
@@ -395,6 +389,7 @@ namespace VT
 
         // Initialize device
         {
+            VT_PROFILE_SCOPE("Vulkan device");
             std::vector<const char *> deviceExtensionNames;
             deviceExtensionNames.reserve(10);
             deviceExtensionNames.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
@@ -448,6 +443,7 @@ namespace VT
             enable12GpuFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
             enable12GpuFeatures.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
             enable12GpuFeatures.timelineSemaphore = VK_TRUE;
+            enable12GpuFeatures.hostQueryReset = VK_TRUE;
             enable12GpuFeatures.bufferDeviceAddress = VK_TRUE;
 
             // Enable gpu features 1.3 here.
@@ -491,13 +487,41 @@ namespace VT
         // Initialize descriptor cache(layout and descriptor set)
         m_descriptorPoolCache.init();
 
+        // Initialize pipeline cache from disk
+        {
+            VT_PROFILE_SCOPE("Pipeline cache load");
+            m_pipelineCache.init(m_device.properties);
+        }
+
+        // Initialize bindless descriptor heap
+        m_bindlessHeap.init(m_device.properties, m_device.descriptorIndexingProperties);
+
         // Initialize swap chain
-        m_swapChain.init();
+        {
+            VT_PROFILE_SCOPE("Swap chain");
+            m_swapChain.init();
+        }
         VulkanRHI::MaxSwapChainCount = m_swapChain.swapChainImageViews.size();
 
+        // Initialize frame linear allocator, one region per frame slot
+        m_frameAllocator.init(m_device.properties, GMaxFramesInFlight);
+
+        // Initialize GPU timestamp profiler, one query range per frame slot
+        m_gpuProfiler.init(m_device.properties, m_device.queueFamilyProperties[m_device.queueInfos.graphicsFamily], GMaxFramesInFlight);
+
         // Initialize present context
         m_presentContext.init();
 
+        // Initialize frame timeline
+        VkSemaphoreTypeCreateInfo timelineCreateInfo{};
+        timelineCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timelineCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timelineCreateInfo.initialValue = 0;
+        VkSemaphoreCreateInfo timelineSemaphoreInfo{};
+        timelineSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        timelineSemaphoreInfo.pNext = &timelineCreateInfo;
+        RHICheck(vkCreateSemaphore(m_device.logicalDevice, &timelineSemaphoreInfo, nullptr, &m_timelineSemaphore));
+
         // Initialize command pool
         m_device.initCommandPool();
 
@@ -512,18 +536,40 @@ namespace VT
     {
         // TODO: other
 
-        // Release present context
+        // Destroy retired resources first, they may give back descriptor sets and bindless slots
+        m_deletionQueue.release();
+
+        // Release present context and frame timeline
         m_presentContext.release();
+        vkDestroySemaphore(m_device.logicalDevice, m_timelineSemaphore, nullptr);
+        m_timelineSemaphore = VK_NULL_HANDLE;
 
         // Release swap chain
         m_swapChain.release();
 
-        // TODO: release descriptor cache(layout and descriptor set)
+        // Release descriptor caches, cached sets go away with their pools
+        m_descriptorSetCache.release();
         m_descriptorPoolCache.release();
+        m_descriptorLayoutCache.release();
 
         // TODO: release sampler cache
         m_samplerCache.release();
 
+        // Save pipeline cache to disk
+        m_pipelineCache.release();
+
+        // Release bindless descriptor heap, assets have given back their slots
+        m_bindlessHeap.release();
+
+        // Release frame linear allocator
+        m_frameAllocator.release();
+
+        // Release GPU profiler query pool
+        m_gpuProfiler.release();
+
+        // Bindless material buffer and frame linear buffer were retired above, destroy them while VMA is alive
+        m_deletionQueue.release();
+
         // Release VMA
         releaseVMA();
 
@@ -553,6 +599,7 @@ namespace VT
     void VulkanContext::rebuildSwapChain()
     {
         vkDeviceWaitIdle(m_device.logicalDevice);
+        m_deletionQueue.onDeviceIdle();
 
         static int width = 0, height = 0;
         glfwGetFramebufferSize(m_window, &width, &height);
@@ -569,7 +616,6 @@ namespace VT
         m_presentContext.release();
         m_swapChain.rebuild();
         m_presentContext.init();
-        m_presentContext.imagesInFlight.resize(m_swapChain.swapChainImageViews.size(), VK_NULL_HANDLE);
 
         // TODO: after recreate broadcast
         onAfterSwapChainRebuild.broadcast();
@@ -603,7 +649,9 @@ namespace VT
     {
         m_presentContext.isSwapChainChange |= isSwapChainRebuilt();
 
-        vkWaitForFences(m_device.logicalDevice, 1, &m_presentContext.inFlightFences[m_presentContext.currentFrame], VK_TRUE, UINT64_MAX);
+        // One wait per frame, last frame recorded in this slot must finish before its resources are reused
+        waitTimeline(m_presentContext.frameTimelineValues[m_presentContext.currentFrame]);
+        m_deletionQueue.onTimelineReached(getCompletedTimelineValue());
 
         VkResult result = vkAcquireNextImageKHR(
             m_device.logicalDevice,
@@ -620,12 +668,10 @@ namespace VT
             VT_CORE_CRITICAL("Fail to acquire presented image");
         }
 
-        if (m_presentContext.imagesInFlight[m_presentContext.imageIndex] != VK_NULL_HANDLE)
-        {
-            vkWaitForFences(m_device.logicalDevice, 1, &m_presentContext.imagesInFlight[m_presentContext.imageIndex], VK_TRUE, UINT64_MAX);
-        }
-
-        m_presentContext.imagesInFlight[m_presentContext.imageIndex] = m_presentContext.inFlightFences[m_presentContext.currentFrame];
+        // Transient descriptor sets, frame allocations and timestamp queries of this slot can go
+        m_descriptorPoolCache.resetTransientPools(m_presentContext.currentFrame);
+        m_frameAllocator.beginFrame(m_presentContext.currentFrame);
+        m_gpuProfiler.beginFrame(m_presentContext.currentFrame);
 
         return m_presentContext.imageIndex;
     }
@@ -635,7 +681,7 @@ namespace VT
         VkPresentInfoKHR presentInfo{};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
-        VkSemaphore signalSemaphores[] = { m_presentContext.semaphoresRenderFinished[m_presentContext.currentFrame] };
+        VkSemaphore signalSemaphores[] = { m_presentContext.semaphoresRenderFinished[m_presentContext.imageIndex] };
         presentInfo.waitSemaphoreCount = 1;
         presentInfo.pWaitSemaphores = signalSemaphores;
 
@@ -654,22 +700,75 @@ namespace VT
             VT_CORE_CRITICAL("Fail to present image");
         }
         // If swap chain rebuilt and on minimized, still add frame
-        m_presentContext.currentFrame = (m_presentContext.currentFrame + 1) % VulkanRHI::MaxSwapChainCount;
+        m_presentContext.currentFrame = (m_presentContext.currentFrame + 1) % m_presentContext.framesInFlight;
+    }
+
+    void VulkanContext::submitFrame(const VkSubmitInfo &info)
+    {
+        uint64_t value = submitWithTimeline(info);
+        m_presentContext.frameTimelineValues[m_presentContext.currentFrame] = value;
+        m_deletionQueue.onFrameSubmitted(value);
+    }
+
+    uint64_t VulkanContext::submitWithTimeline(const VkSubmitInfo &info)
+    {
+        VT_CORE_ASSERT(info.pNext == nullptr, "Timeline submit chains its own semaphore info");
+
+        // Binary signal semaphores ignore their values
+        std::vector<VkSemaphore> signalSemaphores(info.pSignalSemaphores, info.pSignalSemaphores + info.signalSemaphoreCount);
+        signalSemaphores.push_back(m_timelineSemaphore);
+        std::vector<uint64_t> signalValues(signalSemaphores.size(), 0);
+
+        // Value order must match submit order on the queue
+        std::lock_guard<std::mutex> lock{ m_timelineMutex };
+        const uint64_t value = ++m_timelineValue;
+        signalValues.back() = value;
+
+        VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+        timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineSubmitInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+        timelineSubmitInfo.pSignalSemaphoreValues = signalValues.data();
+
+        VkSubmitInfo submitInfo = info;
+        submitInfo.pNext = &timelineSubmitInfo;
+        submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+        submitInfo.pSignalSemaphores = signalSemaphores.data();
+        RHICheck(vkQueueSubmit(m_device.majorGraphicsPool.queue, 1, &submitInfo, VK_NULL_HANDLE));
+
+        return value;
+    }
+
+    void VulkanContext::waitTimeline(uint64_t value, uint64_t timeout)
+    {
+        if (value == 0)
+        {
+            return;
+        }
+
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_timelineSemaphore;
+        waitInfo.pValues = &value;
+        RHICheck(vkWaitSemaphores(m_device.logicalDevice, &waitInfo, timeout));
     }
 
-    void VulkanContext::submit(uint32_t count, VkSubmitInfo *infos)
+    bool VulkanContext::isTimelineReached(uint64_t value) const
     {
-        RHICheck(vkQueueSubmit(m_device.majorGraphicsPool.queue, count, infos, m_presentContext.inFlightFences[m_presentContext.currentFrame]));
+        return getCompletedTimelineValue() >= value;
     }
 
-    void VulkanContext::submitWithoutFence(uint32_t count, VkSubmitInfo *infos)
+    uint64_t VulkanContext::getCompletedTimelineValue() const
     {
-        RHICheck(vkQueueSubmit(m_device.majorGraphicsPool.queue, count, infos, nullptr));
+        uint64_t value = 0;
+        RHICheck(vkGetSemaphoreCounterValue(m_device.logicalDevice, m_timelineSemaphore, &value));
+        return value;
     }
 
-    void VulkanContext::resetFence()
+    void VulkanContext::setFramesInFlight(uint32_t count)
     {
-        RHICheck(vkResetFences(m_device.logicalDevice, 1, &m_presentContext.inFlightFences[m_presentContext.currentFrame]));
+        // Slot waits on its own last timeline value, so count can change without idling device
+        m_presentContext.framesInFlight = std::clamp(count, 1u, GMaxFramesInFlight);
     }
 
     VkCommandBuffer VulkanContext::createMajorGraphicsCommandBuffer()
@@ -688,7 +787,7 @@ namespace VT
 
     DescriptorFactory VulkanContext::descriptorFactoryBegin()
     {
-        return DescriptorFactory::begin(&m_descriptorPoolCache);
+        return DescriptorFactory::begin(&m_descriptorPoolCache, &m_descriptorLayoutCache, &m_descriptorSetCache);
     }
 
     void VulkanContext::updateDescriptorSet(VkDescriptorSet &dstDescriptorSet, uint32_t dstBinding,
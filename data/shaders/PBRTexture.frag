@@ -1,33 +1,49 @@
 #version 460
 
+#extension GL_EXT_nonuniform_qualifier : require
+
 layout (location = 0) in vec3 inWorldPos;
 layout (location = 1) in vec2 inUV;
-layout (location = 2) in mat3 inTangentBasis;
+layout (location = 2) flat in uint inMaterialIndex;
+layout (location = 3) in mat3 inTangentBasis;
 
 layout (location = 0) out vec4 outColor;
 
-layout (binding = 0) uniform UBO
+layout (set = 0, binding = 0) uniform UBO
 {
     mat4 projection;
     mat4 view;
     vec3 camPos;
 } ubo;
 
-layout (binding = 1) uniform sampler2D albedoTexture;
-layout (binding = 2) uniform sampler2D normalTexture;
-layout (binding = 3) uniform sampler2D roughnessTexture;
-layout (binding = 4) uniform sampler2D metallicTexture;
-
-layout (binding = 5) uniform samplerCube irradianceTexture;
-layout (binding = 6) uniform samplerCube specularTexture;
-layout (binding = 7) uniform sampler2D specularBRDF_LUT;
+layout (set = 0, binding = 1) uniform samplerCube irradianceTexture;
+layout (set = 0, binding = 2) uniform samplerCube specularTexture;
+layout (set = 0, binding = 3) uniform sampler2D specularBRDF_LUT;
 
-layout (push_constant) uniform PushConsts
+// Bindless heap, see BindlessHeap.h
+struct MaterialData
+{
+    vec4 baseColorFactor;
+    uint albedoIndex;
+    uint normalIndex;
+    uint roughnessIndex;
+    uint metallicIndex;
+    float metallicFactor;
+    float roughnessFactor;
+    float alphaCutOff;
+    uint padding;
+};
+
+layout (set = 2, binding = 0) uniform texture2D textures[];
+layout (set = 2, binding = 1) uniform sampler materialSampler;
+layout (std430, set = 2, binding = 3) readonly buffer MaterialBuffer
 {
-    layout(offset = 64) int id;
-} componentID;
+    MaterialData data[];
+} materials;
 
 #define PI 3.1415926535897932384626433832795
+// GBindlessInvalidIndex, e.g. textures of default material
+#define INVALID_INDEX 0xFFFFFFFFu
 
 const vec3 Fdielectric = vec3(0.04);
 
@@ -62,15 +78,27 @@ vec3 fresnelSchlickR(float cosTheta, vec3 F0, float roughness)
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(1.0 - cosTheta, 5.0);
 }
 
+// Material index may differ inside one instanced draw, missing texture gives fallback value
+vec4 sampleMaterialTexture(uint textureIndex, vec2 uv, vec4 fallback)
+{
+    if (textureIndex == INVALID_INDEX)
+    {
+        return fallback;
+    }
+    return texture(sampler2D(textures[nonuniformEXT(textureIndex)], materialSampler), uv);
+}
+
 void main()
 {
+    MaterialData material = materials.data[inMaterialIndex];
+
     // Sample input textures to get albedo, roughness and metallic
-    vec3 albedo = texture(albedoTexture, inUV).rgb;
-    float roughness = texture(roughnessTexture, inUV).r;
-    float metallic = texture(metallicTexture, inUV).r;
+    vec3 albedo = sampleMaterialTexture(material.albedoIndex, inUV, vec4(1.0)).rgb * material.baseColorFactor.rgb;
+    float roughness = sampleMaterialTexture(material.roughnessIndex, inUV, vec4(1.0)).r * material.roughnessFactor;
+    float metallic = sampleMaterialTexture(material.metallicIndex, inUV, vec4(1.0)).r * material.metallicFactor;
 
     // Calculate current fragment's normal and transform to world space
-    vec3 N = normalize(2.0 * texture(normalTexture, inUV).rgb - 1.0);
+    vec3 N = normalize(2.0 * sampleMaterialTexture(material.normalIndex, inUV, vec4(0.5, 0.5, 1.0, 1.0)).rgb - 1.0);
     N = normalize(inTangentBasis * N);
 
     // Outgoing light direction - vector from world space fragment position to the camera position
@@ -1,34 +1,87 @@
 #version 460
 
-layout (location = 0) in vec3 inPos;
+// Compact vertex: unorm16 position in quantization box with bitangent sign in w,
+// octahedral snorm16 normal and tangent, half float uv
+layout (constant_id = 0) const bool compactVertex = false;
+
+layout (location = 0) in vec4 inPos;
 layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec2 inUV;
 layout (location = 3) in vec3 inTangent;
 layout (location = 4) in vec3 inBitangnt;
 
-layout (binding = 0) uniform UBO
+layout (set = 0, binding = 0) uniform UBO
 {
     mat4 projection;
     mat4 view;
     vec3 camPos;
 } ubo;
 
-layout (push_constant) uniform PushConsts
+// Per instance model matrix and bindless material slot, written by instance batcher every frame
+struct InstanceData
 {
     mat4 model;
+    uint materialIndex;
+};
+
+layout (std430, set = 1, binding = 0) readonly buffer InstanceBuffer
+{
+    InstanceData data[];
+} instances;
+
+// Visible instance indices written by GPU culling, gl_InstanceIndex includes batch first instance
+layout (std430, set = 1, binding = 3) readonly buffer VisibleBuffer
+{
+    uint indices[];
+} visibleInstances;
+
+layout (push_constant) uniform PushConsts
+{
+    vec4 positionOffset;
+    vec4 positionScale;
 } pushConsts;
 
 layout (location = 0) out vec3 outWorldPos;
 layout (location = 1) out vec2 outUV;
-layout (location = 2) out mat3 outTangentBasis;
+layout (location = 2) flat out uint outMaterialIndex;
+layout (location = 3) out mat3 outTangentBasis;
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+    return normalize(v);
+}
 
 void main()
 {
-    vec3 localPos = vec3(pushConsts.model * vec4(inPos, 1.0));
+    vec3 position;
+    vec3 normal;
+    vec3 tangent;
+    vec3 bitangent;
+    if (compactVertex)
+    {
+        position = pushConsts.positionOffset.xyz + inPos.xyz * pushConsts.positionScale.xyz;
+        normal = octahedralDecode(inNormal.xy);
+        tangent = octahedralDecode(inTangent.xy);
+        bitangent = cross(normal, tangent) * (inPos.w > 0.5 ? -1.0 : 1.0);
+    } else
+    {
+        position = inPos.xyz;
+        normal = inNormal;
+        tangent = inTangent;
+        bitangent = inBitangnt;
+    }
+
+    InstanceData instance = instances.data[visibleInstances.indices[gl_InstanceIndex]];
+    mat4 model = instance.model;
+    vec3 localPos = vec3(model * vec4(position, 1.0));
 
     outWorldPos = localPos;
     outUV = inUV;
-    outTangentBasis = mat3(pushConsts.model) * mat3(inTangent, inBitangnt, inNormal);
+    outMaterialIndex = instance.materialIndex;
+    outTangentBasis = mat3(model) * mat3(tangent, bitangent, normal);
 
     gl_Position = ubo.projection * ubo.view * vec4(outWorldPos, 1.0);
-}
\ No newline at end of file
+}
@@ -1,12 +1,14 @@
 #version 450
 
+#extension GL_EXT_samplerless_texture_functions : require
+
 // Physically Based Rendering
 
 // Tone-mapping & gamma correction
 
 layout(location = 0) out vec4 outColor;
 
-layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput sceneColor;
+layout(set = 0, binding = 0) uniform texture2D sceneColor;
 
 const float gamma     = 2.2;
 const float exposure  = 1.0;
@@ -14,7 +16,7 @@ const float pureWhite = 1.0;
 
 void main()
 {
-    vec3 color = subpassLoad(sceneColor).rgb * exposure;
+    vec3 color = texelFetch(sceneColor, ivec2(gl_FragCoord.xy), 0).rgb * exposure;
 
     // Reinhard tonemapping operator
     // See: "Photographic Tone Reproduction for Digital Images", eq. 4